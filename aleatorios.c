@@ -0,0 +1,254 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CON_X86
+#endif
+
+#include "aleatorios.h"
+
+
+
+/* Declaración de las variables globales de los números aleatorios. */
+
+
+static const int rangos[NUMALEATORIOS][2] =
+{
+	{1, 100},
+	{1, 10},
+	{2, 6},
+	{1, 4},
+	{6, 10},
+	{60, 300},
+	{1, 10}
+};
+
+static uint64_t semillaBase = 1;
+static int hilosSembrados; // Cada hilo que empieza a sortear coge el siguiente.
+static int nivelSimd = -1; // Se mira la primera vez que se rellena un lote.
+
+static __thread struct generador generadorHilo;
+static __thread int generadorListo;
+static __thread int32_t lotes[NUMALEATORIOS][TAMLOTE];
+static __thread int quedan[NUMALEATORIOS]; // Números sin usar de cada lote (se gastan de delante hacia atrás).
+
+
+
+/* Implementación de las funciones. */
+
+
+static uint64_t splitmix (uint64_t *x)
+{
+	uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+
+	z = (z ^ (z>>30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z>>27)) * 0x94D049BB133111EBULL;
+	return z ^ (z>>31);
+}
+
+
+void siembraAleatorios (uint64_t semilla)
+{
+	semillaBase = semilla;
+}
+
+
+void iniciaGenerador (struct generador *g, uint64_t semilla)
+{
+	uint64_t x = semilla;
+	uint64_t v;
+	int carril;
+	int k;
+
+	for (carril=0; carril<CARRILES; carril++)
+	{
+		for (k=0; k<4; k+=2)
+		{
+			v = splitmix(&x);
+			g->estado[k][carril] = (uint32_t)v;
+			g->estado[k+1][carril] = (uint32_t)(v>>32);
+		}
+		if ((g->estado[0][carril] | g->estado[1][carril] | g->estado[2][carril] | g->estado[3][carril])==0) g->estado[0][carril] = 1; // Con todo a cero no saldría de ahí.
+	}
+}
+
+
+static void llenaEscalar (struct generador *g, int32_t *destino, int cuantos, uint32_t n, int32_t min)
+{
+	uint32_t s0, s1, s2, s3, x, t;
+	int carril;
+	int i;
+
+	// Los carriles son independientes: se avanza cada uno por separado y se colocan igual que en las versiones vectoriales.
+	for (carril=0; carril<CARRILES; carril++)
+	{
+		s0 = g->estado[0][carril];
+		s1 = g->estado[1][carril];
+		s2 = g->estado[2][carril];
+		s3 = g->estado[3][carril];
+
+		for (i=carril; i<cuantos; i+=CARRILES)
+		{
+			x = s0 + s3;
+			t = s1 << 9;
+			s2 ^= s0;
+			s3 ^= s1;
+			s1 ^= s2;
+			s0 ^= s3;
+			s2 ^= t;
+			s3 = (s3 << 11) | (s3 >> 21);
+
+			destino[i] = (int32_t)(((uint64_t)x * n) >> 32) + min; // Se usan los bits altos, que son los buenos en xoshiro128+.
+		}
+
+		g->estado[0][carril] = s0;
+		g->estado[1][carril] = s1;
+		g->estado[2][carril] = s2;
+		g->estado[3][carril] = s3;
+	}
+}
+
+
+#ifdef CON_X86
+__attribute__((target("sse2")))
+static void llenaSse2 (struct generador *g, int32_t *destino, int cuantos, uint32_t n, int32_t min)
+{
+	__m128i s0[2], s1[2], s2[2], s3[2];
+	__m128i x, t, pares, impares;
+	__m128i vn = _mm_set1_epi32((int)n);
+	__m128i vmin = _mm_set1_epi32(min);
+	__m128i altos = _mm_set_epi32(-1, 0, -1, 0); // Posiciones impares.
+	int mitad;
+	int i;
+
+	for (mitad=0; mitad<2; mitad++)
+	{
+		s0[mitad] = _mm_load_si128((__m128i*)&g->estado[0][4*mitad]);
+		s1[mitad] = _mm_load_si128((__m128i*)&g->estado[1][4*mitad]);
+		s2[mitad] = _mm_load_si128((__m128i*)&g->estado[2][4*mitad]);
+		s3[mitad] = _mm_load_si128((__m128i*)&g->estado[3][4*mitad]);
+	}
+
+	for (i=0; i<cuantos; i+=CARRILES)
+	{
+		for (mitad=0; mitad<2; mitad++)
+		{
+			x = _mm_add_epi32(s0[mitad], s3[mitad]);
+			t = _mm_slli_epi32(s1[mitad], 9);
+			s2[mitad] = _mm_xor_si128(s2[mitad], s0[mitad]);
+			s3[mitad] = _mm_xor_si128(s3[mitad], s1[mitad]);
+			s1[mitad] = _mm_xor_si128(s1[mitad], s2[mitad]);
+			s0[mitad] = _mm_xor_si128(s0[mitad], s3[mitad]);
+			s2[mitad] = _mm_xor_si128(s2[mitad], t);
+			s3[mitad] = _mm_or_si128(_mm_slli_epi32(s3[mitad], 11), _mm_srli_epi32(s3[mitad], 21));
+
+			// Parte alta de x*n: los carriles pares y los impares se multiplican por separado (mul_epu32 sólo usa los pares).
+			pares = _mm_srli_epi64(_mm_mul_epu32(x, vn), 32);
+			impares = _mm_mul_epu32(_mm_srli_epi64(x, 32), vn);
+			x = _mm_or_si128(_mm_andnot_si128(altos, pares), _mm_and_si128(altos, impares));
+			_mm_storeu_si128((__m128i*)(destino+i+4*mitad), _mm_add_epi32(x, vmin));
+		}
+	}
+
+	for (mitad=0; mitad<2; mitad++)
+	{
+		_mm_store_si128((__m128i*)&g->estado[0][4*mitad], s0[mitad]);
+		_mm_store_si128((__m128i*)&g->estado[1][4*mitad], s1[mitad]);
+		_mm_store_si128((__m128i*)&g->estado[2][4*mitad], s2[mitad]);
+		_mm_store_si128((__m128i*)&g->estado[3][4*mitad], s3[mitad]);
+	}
+}
+
+
+__attribute__((target("avx2")))
+static void llenaAvx2 (struct generador *g, int32_t *destino, int cuantos, uint32_t n, int32_t min)
+{
+	__m256i s0 = _mm256_load_si256((__m256i*)g->estado[0]);
+	__m256i s1 = _mm256_load_si256((__m256i*)g->estado[1]);
+	__m256i s2 = _mm256_load_si256((__m256i*)g->estado[2]);
+	__m256i s3 = _mm256_load_si256((__m256i*)g->estado[3]);
+	__m256i x, t, pares, impares;
+	__m256i vn = _mm256_set1_epi32((int)n);
+	__m256i vmin = _mm256_set1_epi32(min);
+	int i;
+
+	for (i=0; i<cuantos; i+=CARRILES)
+	{
+		x = _mm256_add_epi32(s0, s3);
+		t = _mm256_slli_epi32(s1, 9);
+		s2 = _mm256_xor_si256(s2, s0);
+		s3 = _mm256_xor_si256(s3, s1);
+		s1 = _mm256_xor_si256(s1, s2);
+		s0 = _mm256_xor_si256(s0, s3);
+		s2 = _mm256_xor_si256(s2, t);
+		s3 = _mm256_or_si256(_mm256_slli_epi32(s3, 11), _mm256_srli_epi32(s3, 21));
+
+		pares = _mm256_srli_epi64(_mm256_mul_epu32(x, vn), 32);
+		impares = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), vn);
+		x = _mm256_blend_epi32(pares, impares, 0xAA);
+		_mm256_storeu_si256((__m256i*)(destino+i), _mm256_add_epi32(x, vmin));
+	}
+
+	_mm256_store_si256((__m256i*)g->estado[0], s0);
+	_mm256_store_si256((__m256i*)g->estado[1], s1);
+	_mm256_store_si256((__m256i*)g->estado[2], s2);
+	_mm256_store_si256((__m256i*)g->estado[3], s3);
+}
+#endif
+
+
+int eligeSimd (int nivel)
+{
+	int mejor = SIMD_ESCALAR;
+
+#ifdef CON_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse2")) mejor = SIMD_SSE2;
+	if (__builtin_cpu_supports("avx2")) mejor = SIMD_AVX2;
+#endif
+
+	nivelSimd = (nivel>=0 && nivel<mejor) ? nivel : mejor; // No se puede pedir más de lo que tiene el procesador.
+	return nivelSimd;
+}
+
+
+void llenaAleatorios (struct generador *g, int32_t *destino, int cuantos, int min, int max)
+{
+	uint32_t n = (uint32_t)(max-min+1);
+
+	if (nivelSimd<0) eligeSimd(-1);
+
+#ifdef CON_X86
+	if (nivelSimd==SIMD_AVX2)
+	{
+		llenaAvx2(g, destino, cuantos, n, min);
+		return;
+	}
+	if (nivelSimd==SIMD_SSE2)
+	{
+		llenaSse2(g, destino, cuantos, n, min);
+		return;
+	}
+#endif
+	llenaEscalar(g, destino, cuantos, n, min);
+}
+
+
+int aleatorio (int tipo)
+{
+	if (quedan[tipo]==0)
+	{
+		if (generadorListo==0)
+		{
+			iniciaGenerador(&generadorHilo, semillaBase + 0x9E3779B97F4A7C15ULL*(uint64_t)__sync_add_and_fetch(&hilosSembrados, 1));
+			generadorListo = 1;
+		}
+		llenaAleatorios(&generadorHilo, lotes[tipo], TAMLOTE, rangos[tipo][0], rangos[tipo][1]);
+		quedan[tipo] = TAMLOTE;
+	}
+
+	quedan[tipo]--;
+	return lotes[tipo][TAMLOTE-1-quedan[tipo]];
+}
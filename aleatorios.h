@@ -0,0 +1,57 @@
+#ifndef ALEATORIOS_H
+#define ALEATORIOS_H
+
+#include <stdint.h>
+
+
+/*
+ * Números aleatorios por lotes. Cada hilo tiene su generador (ocho xoshiro128+ en paralelo, uno por carril) y un lote
+ * ya sorteado para cada rango que usa el campeonato; cuando se gasta un lote se rellena entero de una vez con AVX2,
+ * con SSE2 o sin instrucciones vectoriales, y las tres dan exactamente la misma secuencia.
+ *
+ * Cada rango se reparte de forma uniforme igual que rand()%n+min (el sesgo del paso a rango es menor que n/2^32,
+ * por debajo del que ya tenía el módulo con RAND_MAX).
+ */
+
+
+// Definición de constantes.
+#define TAMLOTE 256 // Números que se sortean de una vez (múltiplo de 8).
+#define CARRILES 8
+
+// Rangos que se sortean por lotes.
+#define ALEATORIO_SALUD 0 // 1..100, comprobación de salud en la cola.
+#define ALEATORIO_COMPORTAMIENTO 1 // 1..10
+#define ALEATORIO_VALIDO 2 // 2..6, duración de un movimiento válido.
+#define ALEATORIO_INDUMENTARIA 3 // 1..4, duración de un nulo por indumentaria.
+#define ALEATORIO_FUERZA 4 // 6..10, duración de un nulo por falta de fuerza.
+#define ALEATORIO_PUNTUACION 5 // 60..300
+#define ALEATORIO_BEBER 6 // 1..10
+#define NUMALEATORIOS 7
+
+// Instrucciones con las que se rellenan los lotes.
+#define SIMD_ESCALAR 0
+#define SIMD_SSE2 1
+#define SIMD_AVX2 2
+
+
+
+/* Estructuras. */
+
+
+struct generador
+{
+	uint32_t estado[4][CARRILES] __attribute__((aligned(32))); // Palabra k del estado de cada carril.
+};
+
+
+
+/* Declaración de las funciones. */
+
+
+void siembraAleatorios(uint64_t semilla); // Cada hilo saca su propia semilla de ésta la primera vez que sortea.
+int eligeSimd(int nivel); // Fuerza un nivel (o el mejor que haya si es -1); devuelve el que se va a usar.
+void iniciaGenerador(struct generador *g, uint64_t semilla);
+void llenaAleatorios(struct generador *g, int32_t *destino, int cuantos, int min, int max); // cuantos múltiplo de 8.
+int aleatorio(int tipo); // Siguiente número del lote de ese rango en este hilo.
+
+#endif
@@ -0,0 +1,673 @@
+/*
+ * Pruebas de rendimiento del campeonato.
+ *
+ *   benchmarks [--etiqueta=TEXTO] [--prueba=NOMBRE] [--rapido]
+ *
+ * Se incluye powerlifting.c entero (sin su main) para medir las mismas funciones que usa el campeonato.
+ * Cada resultado es una línea JSON por la salida estándar:
+ *   {"etiqueta":"...","prueba":"...","parametro":N,"operaciones":N,"segundos":S,"ns_por_op":X,"ops_por_segundo":Y}
+ *
+ * Pruebas: registro (mensajes del log con N hilos escribiendo a la vez), sitio (haySitioEnCampeonato con N huecos),
+ * eleccion (eligeAtleta con N huecos), podio (actualizaPodio), aleatorios (números sorteados: -1 con rand()%n uno a uno;
+ * 0, 1 y 2 por lotes sin SIMD, con SSE2 y con AVX2), columnas (levantamientos del análisis de temporada: 0 sacando las
+ * puntuaciones del texto del log, 1 exportándolos en columnas y 2 leyendo sólo la columna de las puntuaciones), sucesos
+ * (publicaciones en el bus con N productores a la vez), etapas (lo que le cuesta a la tarima cada levantamiento
+ * puntuado: 0 escribiéndolo en el log, el podio y el almacén ella misma, 1 publicándolo para las etapas y 2 igual pero
+ * esperando a que las etapas lo hayan escrito todo), durabilidad (levantamientos guardados en el almacén con la
+ * durabilidad 0 nada, 1 periódica, 2 en grupo y 3 con un fdatasync por levantamiento), campeonato (levantamientos por
+ * segundo de N campeonatos a la vez en tiempo virtual, todos en el mismo planificador) y multitud (inscripciones por
+ * segundo hasta tener N atletas esperando a la vez en tiempo real). Las cinco últimas dejan el planificador en marcha,
+ * por eso van al final.
+ */
+
+#define PL_SIN_MAIN
+#include "../powerlifting.c"
+
+
+
+/* Declaración de las variables globales. */
+
+
+char *etiqueta = "actual";
+struct campeonato *campeonatoPrueba; // Campeonato sin tareas sobre el que se miden las funciones sueltas.
+int rapido; // Con --rapido se hacen menos repeticiones (para comprobar que todo funciona).
+int operacionesPorHilo;
+int planificadorIniciado;
+struct bus busesPrueba[4]; // Uno por cada número de productores de la prueba del bus.
+long recibidos;
+
+
+
+/* Implementación de las funciones. */
+
+
+double segundosDesde (struct timespec *inicio)
+{
+	struct timespec fin;
+
+	clock_gettime(CLOCK_MONOTONIC, &fin);
+	return (fin.tv_sec-inicio->tv_sec) + (fin.tv_nsec-inicio->tv_nsec)/1e9;
+}
+
+
+void publica (char *prueba, long parametro, long operaciones, double segundos)
+{
+	printf("{\"etiqueta\":\"%s\",\"prueba\":\"%s\",\"parametro\":%ld,\"operaciones\":%ld,\"segundos\":%.6f,\"ns_por_op\":%.2f,\"ops_por_segundo\":%.1f}\n",
+		etiqueta, prueba, parametro, operaciones, segundos, segundos*1e9/operaciones, operaciones/segundos);
+	fflush(stdout);
+}
+
+
+void preparaAtletas (int huecos)
+{
+	int i;
+
+	// Todos los huecos quedan ocupados y las colas vacías: cada prueba pone lo que necesita.
+	free(campeonatoPrueba->atletas);
+	free(campeonatoPrueba->huecos);
+	campeonatoPrueba->maxAtletas = huecos;
+	campeonatoPrueba->atletas = (struct atletasCompeticion*)calloc(huecos, sizeof(struct atletasCompeticion));
+	campeonatoPrueba->huecos = (int*)malloc(sizeof(int)*huecos);
+	campeonatoPrueba->numHuecos = 0;
+	for (i=0; i<campeonatoPrueba->maxTarimas; i++)
+	{
+		campeonatoPrueba->punteroTarimas[i].primeroCola = -1;
+		campeonatoPrueba->punteroTarimas[i].ultimoCola = -1;
+		campeonatoPrueba->punteroTarimas[i].enCola = 0;
+	}
+}
+
+
+void arrancaPlanificador()
+{
+	if (planificadorIniciado==0)
+	{
+		iniciaPlanificador(numeroNucleos());
+		planificadorIniciado = 1;
+	}
+}
+
+
+void *escritor (void *arg)
+{
+	int juez = *(int*)arg;
+	int i;
+
+	for (i=0; i<operacionesPorHilo; i++)
+	{
+		registraEvento(campeonatoPrueba, EVENTO_VALIDO, juez, i, 60 + i%241);
+	}
+	return NULL;
+}
+
+
+void *productor (void *arg)
+{
+	struct bus *bus = (struct bus*)arg;
+	struct suceso suceso = {0};
+	int i;
+
+	suceso.tipo = SUCESO_PUNTUADO;
+	suceso.tarima = 1;
+	suceso.resultado = RESULTADO_VALIDO;
+	for (i=0; i<operacionesPorHilo; i++)
+	{
+		suceso.dorsal = i;
+		suceso.valor = 60 + i%241;
+		publicaSuceso(bus, &suceso);
+	}
+	return NULL;
+}
+
+
+void cuentaSuceso (void *datos, struct suceso *suceso)
+{
+	(*(long*)datos)++;
+}
+
+
+void pruebaRegistro()
+{
+	int hilos[4] = {1, 2, 4, 8};
+	int numeros[8];
+	pthread_t escritores[8];
+	struct timespec inicio;
+	int total = rapido ? 20000 : 400000;
+	int h;
+	int i;
+
+	// Sólo el fichero log: la pantalla no cuenta en esta prueba.
+	for (h=0; h<4; h++)
+	{
+		operacionesPorHilo = total/hilos[h];
+		clock_gettime(CLOCK_MONOTONIC, &inicio);
+		for (i=0; i<hilos[h]; i++)
+		{
+			numeros[i] = i+1;
+			pthread_create(&escritores[i], NULL, escritor, (void*)&numeros[i]);
+		}
+		for (i=0; i<hilos[h]; i++)
+		{
+			pthread_join(escritores[i], NULL);
+		}
+		vaciaSumideros(campeonatoPrueba);
+		publica("registro", hilos[h], (long)operacionesPorHilo*hilos[h], segundosDesde(&inicio));
+	}
+}
+
+
+void pruebaSitio()
+{
+	int huecos[3] = {10, 1000, 100000};
+	struct timespec inicio;
+	volatile int posicion;
+	long repeticiones;
+	long r;
+	int h;
+	int i;
+
+	// Peor caso: sólo queda libre el último hueco.
+	for (h=0; h<3; h++)
+	{
+		preparaAtletas(huecos[h]);
+		for (i=0; i<huecos[h]-1; i++)
+		{
+			campeonatoPrueba->atletas[i].id = i+1;
+		}
+		liberaHueco(campeonatoPrueba, huecos[h]-1);
+
+		repeticiones = (rapido ? 1000000L : 50000000L)/huecos[h];
+		clock_gettime(CLOCK_MONOTONIC, &inicio);
+		for (r=0; r<repeticiones; r++)
+		{
+			posicion = haySitioEnCampeonato(campeonatoPrueba);
+			liberaHueco(campeonatoPrueba, posicion); // Se devuelve para que la siguiente vuelta también lo encuentre.
+		}
+		publica("sitio", huecos[h], repeticiones, segundosDesde(&inicio));
+	}
+	(void)posicion;
+}
+
+
+void pruebaEleccion()
+{
+	int huecos[3] = {10, 1000, 10000};
+	struct timespec inicio;
+	volatile int elegido;
+	int ayuda;
+	long repeticiones;
+	long r;
+	int h;
+	int i;
+
+	// La mitad de los huecos tienen atletas esperando repartidos entre las tarimas.
+	campeonatoPrueba->numTarimas = 4;
+	for (h=0; h<3; h++)
+	{
+		preparaAtletas(huecos[h]);
+		for (i=0; i<huecos[h]; i+=2)
+		{
+			campeonatoPrueba->atletas[i].id = i+1;
+			meteEnCola(campeonatoPrueba, i, 1 + calculaAleatorios(0, campeonatoPrueba->numTarimas-1));
+		}
+
+		repeticiones = (rapido ? 1000000L : 20000000L)/huecos[h];
+		clock_gettime(CLOCK_MONOTONIC, &inicio);
+		for (r=0; r<repeticiones; r++)
+		{
+			elegido = eligeAtleta(campeonatoPrueba, 1 + r%campeonatoPrueba->numTarimas, &ayuda);
+		}
+		publica("eleccion", huecos[h], repeticiones, segundosDesde(&inicio));
+	}
+	(void)elegido;
+}
+
+
+void pruebaPodio()
+{
+	struct timespec inicio;
+	long repeticiones = rapido ? 100000 : 20000000;
+	long r;
+
+	preparaAtletas(1);
+	memset(campeonatoPrueba->podio, 0, sizeof(campeonatoPrueba->podio));
+	memset(campeonatoPrueba->finPodio, 0, sizeof(campeonatoPrueba->finPodio));
+
+	clock_gettime(CLOCK_MONOTONIC, &inicio);
+	for (r=0; r<repeticiones; r++)
+	{
+		actualizaPodio(campeonatoPrueba, r+1, 60 + (r*7919)%241, r);
+	}
+	publica("podio", 3, repeticiones, segundosDesde(&inicio));
+}
+
+
+void pruebaAleatorios()
+{
+	struct timespec inicio;
+	struct generador g;
+	int32_t lote[TAMLOTE];
+	int32_t referencia[TAMLOTE];
+	long repeticiones = rapido ? 1000 : 200000; // Lotes de TAMLOTE números.
+	long suma = 0;
+	long r;
+	int nivel;
+	int i;
+
+	// Lo de antes: un rand()%n por número.
+	clock_gettime(CLOCK_MONOTONIC, &inicio);
+	for (r=0; r<repeticiones; r++)
+	{
+		for (i=0; i<TAMLOTE; i++)
+		{
+			lote[i] = calculaAleatorios(60, 300);
+		}
+		suma += lote[r%TAMLOTE];
+	}
+	publica("aleatorios", -1, repeticiones*TAMLOTE, segundosDesde(&inicio));
+
+	// Lotes con cada nivel que tenga el procesador; todos tienen que sacar lo mismo con la misma semilla.
+	iniciaGenerador(&g, 1);
+	eligeSimd(SIMD_ESCALAR);
+	llenaAleatorios(&g, referencia, TAMLOTE, 60, 300);
+	for (nivel=SIMD_ESCALAR; nivel<=SIMD_AVX2; nivel++)
+	{
+		if (eligeSimd(nivel)!=nivel) break;
+
+		iniciaGenerador(&g, 1);
+		llenaAleatorios(&g, lote, TAMLOTE, 60, 300);
+		if (memcmp(lote, referencia, sizeof(lote))!=0)
+		{
+			fprintf(stderr, "El nivel %d no saca la misma secuencia que el escalar.\n", nivel);
+			exit(-1);
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &inicio);
+		for (r=0; r<repeticiones; r++)
+		{
+			llenaAleatorios(&g, lote, TAMLOTE, 60, 300);
+			suma += lote[r%TAMLOTE];
+		}
+		publica("aleatorios", nivel, repeticiones*TAMLOTE, segundosDesde(&inicio));
+	}
+	eligeSimd(-1);
+	(void)suma;
+}
+
+
+void pruebaColumnas()
+{
+	struct exportacion e;
+	struct registroLevantamiento levantamiento = {0};
+	struct ficheroColumnas f;
+	struct timespec inicio;
+	FILE *texto;
+	char linea[TAMLINEA];
+	char *mensaje;
+	int64_t *valores;
+	long levantamientos = rapido ? 20000 : 1000000;
+	long esperada = 0;
+	long suma;
+	long sumaColumna;
+	long r;
+	int dorsal;
+	int puntuacion;
+
+	// Los mismos levantamientos en el log, como los lee ahora el análisis de temporada, y exportados en columnas.
+	iniciaExportacion(&e);
+	texto = fopen("benchmarks-texto.log", "w");
+	for (r=0; r<levantamientos; r++)
+	{
+		levantamiento.dorsal = r+1;
+		levantamiento.tarima = 1 + r%NUMEROTARIMAS;
+		levantamiento.resultado = (r%10==0) ? RESULTADO_NULO_FUERZA : RESULTADO_VALIDO;
+		levantamiento.puntuacion = (levantamiento.resultado==RESULTADO_VALIDO) ? 60 + (r*7919)%241 : 0;
+		levantamiento.t_inscripcion = r*1000000;
+		levantamiento.t_llamada = levantamiento.t_inscripcion + (r*104729)%3000000000;
+		levantamiento.t_fin = levantamiento.t_llamada + 2000000000 + (r*1299709)%6000000000;
+		levantamiento.necesita_beber = (r%10==1);
+		anadeAExportacion(&e, &levantamiento, 1);
+		fprintf(texto, "[ 19/ 10/ 26  12: 00: 00.000000]  Juez %d:  El dorsal %d hizo un levantamiento asombroso: %d puntos.\n",
+			levantamiento.tarima, levantamiento.dorsal, levantamiento.puntuacion);
+		esperada += levantamiento.puntuacion;
+	}
+	fclose(texto);
+
+	// 0: se sacan las puntuaciones del texto.
+	clock_gettime(CLOCK_MONOTONIC, &inicio);
+	texto = fopen("benchmarks-texto.log", "r");
+	suma = 0;
+	while (fgets(linea, sizeof(linea), texto)!=NULL)
+	{
+		mensaje = strstr(linea, "El dorsal ");
+		if (mensaje!=NULL && sscanf(mensaje, "El dorsal %d hizo un levantamiento asombroso: %d", &dorsal, &puntuacion)==2) suma += puntuacion;
+	}
+	fclose(texto);
+	publica("columnas", 0, levantamientos, segundosDesde(&inicio));
+
+	// 1: se exportan.
+	clock_gettime(CLOCK_MONOTONIC, &inicio);
+	escribeColumnas(&e, "benchmarks.col", 1, 1000000000, 0);
+	publica("columnas", 1, levantamientos, segundosDesde(&inicio));
+
+	// 2: se lee sólo la columna de las puntuaciones.
+	valores = (int64_t*)malloc(sizeof(int64_t)*levantamientos);
+	clock_gettime(CLOCK_MONOTONIC, &inicio);
+	abreColumnas("benchmarks.col", &f);
+	decodificaColumna(&f, COLUMNA_PUNTUACION, valores);
+	sumaColumna = 0;
+	for (r=0; r<levantamientos; r++)
+	{
+		sumaColumna += valores[r];
+	}
+	cierraColumnas(&f);
+	publica("columnas", 2, levantamientos, segundosDesde(&inicio));
+
+	if (suma!=esperada || sumaColumna!=esperada)
+	{
+		fprintf(stderr, "El texto da %ld puntos y las columnas %ld en vez de %ld.\n", suma, sumaColumna, esperada);
+		exit(-1);
+	}
+	free(valores);
+	liberaExportacion(&e);
+	unlink("benchmarks-texto.log");
+	unlink("benchmarks.col");
+}
+
+
+void pruebaSucesos()
+{
+	int hilos[4] = {1, 2, 4, 8};
+	pthread_t productores[8];
+	struct timespec inicio;
+	int total = rapido ? 200000 : 8000000;
+	int h;
+	int i;
+
+	// Cada productor publica en la cola sin semáforos y la tarea del bus reparte a un suscriptor que sólo cuenta.
+	arrancaPlanificador();
+	for (h=0; h<4; h++)
+	{
+		operacionesPorHilo = total/hilos[h];
+		recibidos = 0;
+		iniciaBus(&busesPrueba[h]);
+		suscribe(&busesPrueba[h], TODOS_SUCESOS, cuentaSuceso, &recibidos);
+
+		clock_gettime(CLOCK_MONOTONIC, &inicio);
+		for (i=0; i<hilos[h]; i++)
+		{
+			pthread_create(&productores[i], NULL, productor, (void*)&busesPrueba[h]);
+		}
+		for (i=0; i<hilos[h]; i++)
+		{
+			pthread_join(productores[i], NULL);
+		}
+		cancelaTarea(&busesPrueba[h].tarea);
+		vaciaBus(&busesPrueba[h]);
+		publica("sucesos", hilos[h], (long)operacionesPorHilo*hilos[h], segundosDesde(&inicio));
+
+		if (recibidos!=(long)operacionesPorHilo*hilos[h])
+		{
+			fprintf(stderr, "El bus ha repartido %ld sucesos de %ld.\n", recibidos, (long)operacionesPorHilo*hilos[h]);
+			exit(-1);
+		}
+	}
+}
+
+
+void pruebaEtapas()
+{
+	struct campeonato *c = campeonatoPrueba;
+	struct registroLevantamiento levantamiento = {0};
+	struct suceso suceso = {0};
+	struct timespec inicio;
+	long repeticiones = rapido ? 20000 : 1000000;
+	long r;
+	int modo;
+
+	arrancaPlanificador();
+	abreResultados("benchmarks.dat", "benchmarks.idx", "benchmarks.dor", "benchmarks.tar");
+	suceso.tipo = SUCESO_PUNTUADO;
+	suceso.tarima = 1;
+	suceso.resultado = RESULTADO_VALIDO;
+	levantamiento.tarima = 1;
+	levantamiento.resultado = RESULTADO_VALIDO;
+	levantamiento.campeonato = 1;
+
+	for (modo=0; modo<3; modo++)
+	{
+		clock_gettime(CLOCK_MONOTONIC, &inicio);
+		for (r=0; r<repeticiones; r++)
+		{
+			if (modo==0) // Como lo hacía el juez antes de las etapas.
+			{
+				levantamiento.dorsal = r+1;
+				levantamiento.puntuacion = 60 + (r*7919)%241;
+				levantamiento.t_fin = marcaTiempo();
+				registraEvento(c, EVENTO_VALIDO, 1, levantamiento.dorsal, levantamiento.puntuacion);
+				actualizaPodio(c, levantamiento.dorsal, levantamiento.puntuacion, levantamiento.t_fin);
+				guardaLevantamiento(&levantamiento);
+			}
+			else
+			{
+				suceso.dorsal = r+1;
+				suceso.valor = 60 + (r*7919)%241;
+				suceso.hora = marcaTiempo();
+				publicaSuceso(&c->bus, &suceso);
+			}
+		}
+		if (modo==2) vaciaEtapas(c);
+		publica("etapas", modo, repeticiones, segundosDesde(&inicio));
+		vaciaEtapas(c); // La siguiente medida empieza con las etapas vacías.
+	}
+
+	cierraResultados();
+	unlink("benchmarks.dat");
+	unlink("benchmarks.idx");
+	unlink("benchmarks.dor");
+	unlink("benchmarks.tar");
+}
+
+
+void pruebaDurabilidad()
+{
+	struct durabilidad d;
+	struct registrosPendientes pendientes = {0};
+	struct registroLevantamiento levantamiento = {0};
+	struct timespec inicio;
+	int modos[3] = {DURABILIDAD_NADA, DURABILIDAD_PERIODICA, DURABILIDAD_GRUPO};
+	long repeticiones;
+	long r;
+	int modo;
+
+	// Cada levantamiento se escribe y se apunta como en la etapa del almacén; al final se espera a que todo sea durable.
+	arrancaPlanificador();
+	levantamiento.tarima = 1;
+	levantamiento.resultado = RESULTADO_VALIDO;
+	levantamiento.campeonato = 1;
+	for (modo=0; modo<4; modo++)
+	{
+		repeticiones = (modo==3) ? (rapido ? 200 : 5000) : (rapido ? 20000 : 500000); // Uno a uno es mucho más lento.
+		abreResultados("benchmarks.dat", "benchmarks.idx", "benchmarks.dor", "benchmarks.tar");
+		iniciaDurabilidad(&d, modo<3 ? modos[modo] : DURABILIDAD_NADA, modo==1 ? 100 : LATENCIA_DURABILIDAD_MS, 1);
+		anadeFichero(&d, ficheroResultados());
+		arrancaDurabilidad(&d);
+
+		clock_gettime(CLOCK_MONOTONIC, &inicio);
+		for (r=0; r<repeticiones; r++)
+		{
+			levantamiento.dorsal = r+1;
+			levantamiento.puntuacion = 60 + (r*7919)%241;
+			guardaLevantamiento(&levantamiento);
+			if (modo==3) fdatasync(ficheroResultados());
+			else
+			{
+				apuntaRegistro(&d, &pendientes, 0);
+				apuntaEscritura(&d, ficheroResultados(), &pendientes);
+			}
+		}
+		paraDurabilidad(&d);
+		sincronizaAlCerrar(&d, ficheroResultados());
+		publica("durabilidad", modo, repeticiones, segundosDesde(&inicio));
+
+		liberaDurabilidad(&d);
+		cierraResultados();
+		unlink("benchmarks.dat");
+		unlink("benchmarks.idx");
+		unlink("benchmarks.dor");
+		unlink("benchmarks.tar");
+	}
+}
+
+
+void pruebaCampeonato()
+{
+	int cuantos[2] = {1, 8};
+	struct campeonato *jugando[8];
+	struct timespec inicio;
+	struct timespec pausa = {0, 100000};
+	double duracion = rapido ? 1.0 : 5.0;
+	long levantamientos;
+	int llenos;
+	int n;
+	int i;
+	int j;
+
+	// Campeonatos completos en tiempo virtual: se mantienen todos los huecos ocupados y se cuentan los levantamientos de todos.
+	tiempoVirtual = 1000;
+	modoAnfitrion = 1; // Cada campeonato con su log.
+	arrancaPlanificador();
+	for (n=0; n<2; n++)
+	{
+		campeonatosActivos = cuantos[n];
+		for (j=0; j<cuantos[n]; j++)
+		{
+			jugando[j] = creaCampeonato(j+1, 64, 4, 4);
+			inicializaCampeonato(jugando[j]);
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &inicio);
+		i = 0;
+		while (segundosDesde(&inicio)<duracion)
+		{
+			llenos = 0;
+			for (j=0; j<cuantos[n]; j++)
+			{
+				if (inscribeAtleta(jugando[j], 1 + i%4)==-1) llenos++;
+			}
+			if (llenos==cuantos[n])
+			{
+				nanosleep(&pausa, NULL);
+			}
+			i++;
+		}
+
+		levantamientos = 0;
+		for (j=0; j<cuantos[n]; j++)
+		{
+			for (i=0; i<jugando[j]->numTarimas; i++)
+			{
+				levantamientos += jugando[j]->punteroTarimas[i].contador;
+			}
+		}
+		publica("campeonato", cuantos[n], levantamientos, segundosDesde(&inicio));
+	}
+}
+
+
+void pruebaMultitud()
+{
+	int cuantos = rapido ? 100000 : 1000000;
+	struct campeonato *multitud;
+	struct timespec inicio;
+	int i;
+
+	// En tiempo real casi todos siguen en la cola al acabar de inscribirlos: duermen hasta que se deshidratan o los llaman.
+	tiempoVirtual = -1;
+	modoAnfitrion = 1;
+	nivelLog = NIVEL_NADA; // Sin log: sólo cuenta lo que cuesta tenerlos a todos esperando.
+	arrancaPlanificador();
+	multitud = creaCampeonato(9, cuantos, 16, 16);
+	inicializaCampeonato(multitud);
+
+	clock_gettime(CLOCK_MONOTONIC, &inicio);
+	for (i=0; i<cuantos; i++)
+	{
+		inscribeAtleta(multitud, 1 + i%16);
+	}
+	publica("multitud", cuantos, cuantos, segundosDesde(&inicio));
+}
+
+
+
+/* Función principal. */
+
+
+int main (int argc, char *argv[])
+{
+	char *prueba = NULL;
+	int opcion;
+	char logCampeonato[TAMNOMBRE];
+	int i;
+	struct option opciones[] =
+	{
+		{"etiqueta", required_argument, NULL, 'e'},
+		{"prueba", required_argument, NULL, 'p'},
+		{"rapido", no_argument, NULL, 'r'},
+		{NULL, 0, NULL, 0}
+	};
+
+	while ((opcion = getopt_long(argc, argv, "", opciones, NULL))!=-1)
+	{
+		if (opcion=='e') etiqueta = optarg;
+		else if (opcion=='p') prueba = optarg;
+		else if (opcion=='r') rapido = 1;
+		else
+		{
+			fprintf(stderr, "Uso: %s [--etiqueta=TEXTO] [--prueba=registro|sitio|eleccion|podio|aleatorios|columnas|sucesos|etapas|durabilidad|campeonato|multitud] [--rapido]\n", argv[0]);
+			exit(-1);
+		}
+	}
+
+
+	// Los mensajes sólo van a un fichero temporal.
+	nombreArchivo = "benchmarks.log";
+	nivelConsola = NIVEL_NADA;
+	nivelLog = NIVEL_EVENTOS;
+	intervaloVaciado = VACIADO_MS;
+	tiempoVirtual = -1;
+	iniciaReloj(HORA_LOCAL);
+	preparaPlantillas();
+	descansoCada = DESCANSO_CADA;
+	descansoDuracion = DESCANSO_SEGUNDOS;
+	esperaP90 = ESPERA_P90;
+	periodoControl = PERIODO_CONTROL;
+	campeonatoPrueba = creaCampeonato(1, 1, NUMEROTARIMAS, 4); // Con hueco para las 4 tarimas de la prueba de elección.
+	if (campeonatoPrueba==NULL)
+	{
+		perror("Error en la creación del fichero.\n");
+		exit(-1);
+	}
+	srand(1);
+
+	if (prueba==NULL || strcmp(prueba, "registro")==0) pruebaRegistro();
+	if (prueba==NULL || strcmp(prueba, "sitio")==0) pruebaSitio();
+	if (prueba==NULL || strcmp(prueba, "eleccion")==0) pruebaEleccion();
+	if (prueba==NULL || strcmp(prueba, "podio")==0) pruebaPodio();
+	if (prueba==NULL || strcmp(prueba, "aleatorios")==0) pruebaAleatorios();
+	if (prueba==NULL || strcmp(prueba, "columnas")==0) pruebaColumnas();
+	if (prueba==NULL || strcmp(prueba, "sucesos")==0) pruebaSucesos();
+	if (prueba==NULL || strcmp(prueba, "etapas")==0) pruebaEtapas();
+	if (prueba==NULL || strcmp(prueba, "durabilidad")==0) pruebaDurabilidad();
+	if (prueba==NULL || strcmp(prueba, "campeonato")==0) pruebaCampeonato();
+	if (prueba==NULL || strcmp(prueba, "multitud")==0) pruebaMultitud();
+
+	cierraSumideros(campeonatoPrueba);
+	unlink(nombreArchivo);
+	for (i=1; i<=8; i++)
+	{
+		snprintf(logCampeonato, TAMNOMBRE, FORMATO_LOG_CAMPEONATO, i);
+		unlink(logCampeonato);
+	}
+	return 0;
+}
@@ -0,0 +1,49 @@
+#!/bin/sh
+# Compara las pruebas de rendimiento de un commit (por defecto HEAD) con las del árbol actual.
+#
+#   sh bench/compara.sh [REF [repeticiones]]
+#
+# Se compilan las dos versiones y se ejecutan alternándolas para que las dos sufran por igual lo que pase en la máquina.
+# Se imprime la mediana de ns por operación de cada prueba y la relación actual/base (menos de 1 es mejora).
+# Todas las líneas JSON quedan en bench/comparacion.json. Con OPCIONES se pasan opciones a las pruebas (p. ej. OPCIONES=--rapido).
+
+REF=${1:-HEAD}
+REPETICIONES=${2:-3}
+RAIZ=$(cd "$(dirname "$0")/.." && pwd)
+BASE=$(mktemp -d)
+SALIDA="$RAIZ/bench/comparacion.json"
+
+trap 'git -C "$RAIZ" worktree remove --force "$BASE" >/dev/null 2>&1; rm -rf "$BASE"' EXIT
+
+git -C "$RAIZ" worktree add --detach "$BASE" "$REF" >/dev/null || exit 1
+make -s -C "$BASE" bench/benchmarks || exit 1
+make -s -C "$RAIZ" bench/benchmarks || exit 1
+
+: > "$SALIDA"
+i=0
+while [ $i -lt "$REPETICIONES" ]
+do
+	(cd "$BASE/bench" && ./benchmarks --etiqueta=base $OPCIONES) >> "$SALIDA" || exit 1
+	(cd "$RAIZ/bench" && ./benchmarks --etiqueta=actual $OPCIONES) >> "$SALIDA" || exit 1
+	i=$((i+1))
+done
+
+# Cada línea JSON pasa a "etiqueta prueba parametro ns_por_op"; se ordena y se saca la mediana de cada grupo.
+awk -F'"' '{ split($11, p, /[:,]/); split($17, n, /[:,]/); print $4, $8, p[2], n[2] }' "$SALIDA" |
+sort -k2,2 -k3,3n -k1,1 -k4,4g |
+awk '
+	function cierra() { if (num>0) mediana[clave] = (num%2) ? v[(num+1)/2] : (v[num/2]+v[num/2+1])/2 }
+	{
+		if ($1" "$2" "$3!=clave) { cierra(); clave = $1" "$2" "$3; num = 0; if (!($2" "$3 in visto)) { visto[$2" "$3] = 1; orden[++pruebas] = $2" "$3 } }
+		v[++num] = $4
+	}
+	END {
+		cierra()
+		printf "%-12s %10s %14s %14s %8s\n", "prueba", "parametro", "base ns/op", "actual ns/op", "relacion"
+		for (i=1; i<=pruebas; i++)
+		{
+			split(orden[i], c, " ")
+			b = mediana["base " orden[i]]; a = mediana["actual " orden[i]]
+			printf "%-12s %10s %14.2f %14.2f %8.3f\n", c[1], c[2], b, a, (b>0) ? a/b : 0
+		}
+	}'
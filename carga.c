@@ -0,0 +1,235 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "carga.h"
+
+
+
+/* Implementación de las funciones. */
+
+
+static void pasoCarga(struct tarea *tarea);
+
+
+static int leeTraza (char *nombre, struct carga *carga)
+{
+	FILE *fichero;
+	char linea[256];
+	double segundo;
+	double primero = 0;
+	int tarima;
+	int leidos;
+	int numLinea = 0;
+	int capacidad = 1024;
+
+	fichero = fopen(nombre, "r");
+	if (fichero==NULL)
+	{
+		perror("Error en la apertura de la traza de la carga.\n");
+		return -1;
+	}
+
+	carga->traza = (struct llegada*)malloc(sizeof(struct llegada)*capacidad);
+	carga->numTraza = 0;
+	while (fgets(linea, sizeof(linea), fichero)!=NULL)
+	{
+		numLinea++;
+		tarima = 0;
+		leidos = sscanf(linea, "%lf %d", &segundo, &tarima);
+		if (leidos<1) continue; // Líneas en blanco y comentarios.
+
+		// Las horas pueden ser absolutas: cuenta la distancia a la primera llegada, que tienen que ir en orden.
+		if (carga->numTraza==0) primero = segundo;
+		segundo -= primero;
+		if (carga->numTraza>0 && segundo<carga->traza[carga->numTraza-1].segundo)
+		{
+			fprintf(stderr, "La traza de la carga no está en orden (línea %d).\n", numLinea);
+			fclose(fichero);
+			return -1;
+		}
+
+		if (carga->numTraza==capacidad)
+		{
+			capacidad *= 2;
+			carga->traza = (struct llegada*)realloc(carga->traza, sizeof(struct llegada)*capacidad);
+		}
+		carga->traza[carga->numTraza].segundo = segundo;
+		carga->traza[carga->numTraza].tarima = tarima;
+		carga->numTraza++;
+	}
+	fclose(fichero);
+
+	if (carga->numTraza==0)
+	{
+		fprintf(stderr, "La traza de la carga no tiene ninguna llegada.\n");
+		return -1;
+	}
+	return 0;
+}
+
+
+int leeCarga (char *texto, struct carga *carga)
+{
+	memset(carga, 0, sizeof(struct carga));
+
+	if (strncmp(texto, "poisson:", 8)==0)
+	{
+		carga->tipo = CARGA_RAFAGAS;
+		carga->rafaga = 1;
+		if (sscanf(texto+8, "%lf,%lf", &carga->tasa, &carga->duracion)<1) return -1;
+	}
+	else if (strncmp(texto, "rafagas:", 8)==0)
+	{
+		carga->tipo = CARGA_RAFAGAS;
+		if (sscanf(texto+8, "%lf,%lf,%lf", &carga->tasa, &carga->rafaga, &carga->duracion)<2 || carga->rafaga<1) return -1;
+	}
+	else
+	{
+		carga->tipo = CARGA_TRAZA;
+		return leeTraza(texto, carga);
+	}
+
+	if (carga->tasa<=0 || carga->duracion<0) return -1;
+	return 0;
+}
+
+
+static double uniforme (struct carga *carga)
+{
+	if (carga->quedan==0)
+	{
+		llenaAleatorios(&carga->generador, carga->uniformes, CARRILES, 1, 1<<24);
+		carga->quedan = CARRILES;
+	}
+	return carga->uniformes[--carga->quedan]/16777216.0; // En (0, 1].
+}
+
+
+static void siguienteLlegada (struct carga *carga)
+{
+	double p;
+
+	if (carga->tipo==CARGA_TRAZA)
+	{
+		carga->hayProxima = carga->siguienteTraza<carga->numTraza;
+		if (carga->hayProxima) carga->proxima = carga->traza[carga->siguienteTraza++];
+		return;
+	}
+
+	// Los de la misma ráfaga llegan a la vez y a la misma tarima.
+	if (carga->enRafaga>0)
+	{
+		carga->enRafaga--;
+		return;
+	}
+
+	// Las ráfagas llegan como un proceso de Poisson y cada una trae un número geométrico de atletas con media rafaga.
+	carga->reloj += -log(uniforme(carga))*carga->rafaga/carga->tasa;
+	if (carga->rafaga>1)
+	{
+		p = 1.0/carga->rafaga;
+		carga->enRafaga = (int)(log(uniforme(carga))/log(1.0-p));
+	}
+	carga->proxima.segundo = carga->reloj;
+	carga->proxima.tarima = 1 + (int)(uniforme(carga)*carga->tarimas);
+	if (carga->proxima.tarima>carga->tarimas) carga->proxima.tarima = carga->tarimas;
+	carga->hayProxima = (carga->duracion==0 || carga->reloj<=carga->duracion);
+}
+
+
+void arrancaCarga (struct carga *carga, int64_t escala, int tarimas, uint64_t semilla, void (*inscribe)(int tarima), int (*sigue)(), void (*acaba)())
+{
+	carga->escala = escala;
+	carga->tarimas = tarimas;
+	carga->inscribe = inscribe;
+	carga->sigue = sigue;
+	carga->acaba = acaba;
+	iniciaGenerador(&carga->generador, semilla);
+	siguienteLlegada(carga);
+
+	iniciaTarea(&carga->tarea, pasoCarga, carga);
+	carga->inicio = relojMonotonico();
+	programaTarea(&carga->tarea, (int64_t)(carga->proxima.segundo*carga->escala));
+}
+
+
+static void pasoCarga (struct tarea *tarea)
+{
+	struct carga *carga = (struct carga*)tarea->datos;
+	int64_t ahora = relojMonotonico();
+	int64_t cuando = 0;
+	int64_t retraso;
+	int inscritas = 0;
+
+	if (carga->sigue()==0) return; // El campeonato se ha acabado antes que la carga.
+
+	while (carga->hayProxima)
+	{
+		cuando = carga->inicio + (int64_t)(carga->proxima.segundo*carga->escala);
+		if (cuando>ahora) break;
+
+		if (inscritas==LLEGADAS_POR_PASO)
+		{
+			programaTarea(tarea, 0);
+			return;
+		}
+
+		carga->inscribe(carga->proxima.tarima);
+		ahora = relojMonotonico();
+		retraso = ahora-cuando;
+		carga->retrasoTotal += retraso;
+		if (retraso>carga->retrasoMaximo) carga->retrasoMaximo = retraso;
+		carga->llegadas++;
+		carga->ultimaProgramada = carga->proxima.segundo;
+		carga->ultimaReal = ahora;
+		inscritas++;
+
+		siguienteLlegada(carga);
+	}
+
+	if (!carga->hayProxima)
+	{
+		carga->acaba();
+		return;
+	}
+	programaTarea(tarea, cuando-ahora);
+}
+
+
+void paraCarga (struct carga *carga)
+{
+	cancelaTarea(&carga->tarea);
+}
+
+
+int ritmosCarga (struct carga *carga, int *pedido, int *conseguido)
+{
+	double segundos;
+
+	// Lo pedido son las llegadas inscritas entre la hora a la que estaba programada la última (en la traza o en lo sorteado
+	// del perfil, así no cuenta la suerte del sorteo) y lo conseguido, entre la hora a la que se inscribió de verdad.
+	*pedido = 0;
+	*conseguido = 0;
+	if (carga->llegadas==0) return 1;
+
+	// Si todas estaban en el segundo 0 no hay ritmo pedido: se devuelven los milisegundos que tardó en inscribirlas.
+	segundos = (double)(carga->ultimaReal-carga->inicio)/carga->escala;
+	if (carga->ultimaProgramada<=0)
+	{
+		*conseguido = (int)(segundos*1000+0.5);
+		return 0;
+	}
+
+	*pedido = (int)(carga->llegadas*60/carga->ultimaProgramada+0.5);
+	if (segundos>0) *conseguido = (int)(carga->llegadas*60/segundos+0.5);
+	return 1;
+}
+
+
+void liberaCarga (struct carga *carga)
+{
+	free(carga->traza);
+	carga->traza = NULL;
+}
@@ -0,0 +1,86 @@
+#ifndef CARGA_H
+#define CARGA_H
+
+#include <stdint.h>
+
+#include "planificador.h"
+#include "aleatorios.h"
+
+
+/*
+ * Generador de carga: inscribe atletas a las horas que marca una traza (líneas "SEGUNDOS [TARIMA]", como las de una
+ * temporada anterior) o un perfil de llegadas (poisson:TASA[,SEGUNDOS] o rafagas:TASA,RAFAGA[,SEGUNDOS], con TASA en
+ * llegadas por segundo y RAFAGA atletas de media que llegan juntos a la misma tarima). Las horas son del campeonato, así
+ * que con tiempo virtual la carga va igual de deprisa que todo lo demás.
+ *
+ * Una tarea del planificador duerme hasta la hora de la siguiente llegada, inscribe todas las que ya tocan y apunta con
+ * cuánto retraso lo ha hecho; al final se compara el ritmo conseguido con el pedido.
+ */
+
+
+// Definición de constantes.
+#define CARGA_TRAZA 0
+#define CARGA_RAFAGAS 1 // Poisson es el caso de ráfagas de un atleta.
+#define LLEGADAS_POR_PASO 64 // Llegadas que se inscriben como mucho en un paso antes de dejar sitio a las demás tareas.
+
+
+
+/* Estructuras. */
+
+
+struct llegada
+{
+	double segundo; // Segundos del campeonato desde que empieza la carga.
+	int tarima; // 0 para la de cola más corta.
+};
+
+
+struct carga
+{
+	int tipo;
+
+	// Traza.
+	struct llegada *traza;
+	int numTraza;
+	int siguienteTraza;
+
+	// Perfil.
+	double tasa; // Llegadas por segundo del campeonato.
+	double rafaga; // Atletas que llegan juntos, de media.
+	double duracion; // Segundos del campeonato (0 sin límite).
+	double reloj; // Hora de la última ráfaga sorteada.
+	int enRafaga; // Atletas que faltan por llegar de esa ráfaga.
+	int tarimas;
+	struct generador generador;
+	int32_t uniformes[CARRILES];
+	int quedan;
+
+	struct llegada proxima;
+	int hayProxima;
+	int64_t escala; // Nanosegundos reales que dura un segundo del campeonato.
+	int64_t inicio; // Reloj monotónico al arrancar.
+	void (*inscribe)(int tarima);
+	int (*sigue)(); // 0 cuando ya no hay a quién inscribir.
+	void (*acaba)(); // Al acabarse la traza o el perfil.
+	struct tarea tarea;
+
+	// Estadísticas (sólo las toca la tarea de la carga).
+	long llegadas;
+	double ultimaProgramada; // Segundo de la última llegada inscrita.
+	int64_t ultimaReal; // Reloj monotónico al inscribirla.
+	int64_t retrasoTotal;
+	int64_t retrasoMaximo;
+};
+
+
+
+/* Declaración de las funciones. */
+
+
+int leeCarga(char *texto, struct carga *carga); // FICHERO, poisson:... o rafagas:...; devuelve -1 si no es válida.
+void arrancaCarga(struct carga *carga, int64_t escala, int tarimas, uint64_t semilla, void (*inscribe)(int tarima), int (*sigue)(), void (*acaba)());
+void paraCarga(struct carga *carga);
+int ritmosCarga(struct carga *carga, int *pedido, int *conseguido); // Llegadas por minuto del campeonato; 0 si todas eran en el segundo 0 (conseguido: ms hasta la última).
+void liberaCarga(struct carga *carga);
+
+#endif
@@ -0,0 +1,451 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "columnas.h"
+
+
+
+/* Declaración de las variables globales de la exportación. */
+
+
+char *nombresColumnas[NUMCOLUMNAS] = {"dorsal", "tarima", "resultado", "puntuacion", "espera", "juez", "agua"};
+char *nombresCodificaciones[4] = {"bits", "delta", "tramos", "fija16"};
+
+// Codificación que se intenta para cada columna (si no vale, por ejemplo una puntuación que no cabe en 16 bits, van en bits).
+static int codificacionPreferida[NUMCOLUMNAS] = {CODIFICACION_DELTA, CODIFICACION_BITS, CODIFICACION_TRAMOS, CODIFICACION_FIJA16, CODIFICACION_BITS, CODIFICACION_BITS, CODIFICACION_TRAMOS};
+
+
+
+/* Implementación de las funciones. */
+
+
+void iniciaExportacion (struct exportacion *e)
+{
+	e->levantamientos = NULL;
+	e->numLevantamientos = 0;
+	e->capacidad = 0;
+}
+
+
+void anadeAExportacion (struct exportacion *e, struct registroLevantamiento *levantamientos, int cuantos)
+{
+	if (e->numLevantamientos+cuantos>e->capacidad)
+	{
+		e->capacidad = (e->capacidad==0) ? 1024 : e->capacidad*2;
+		if (e->capacidad<e->numLevantamientos+cuantos) e->capacidad = e->numLevantamientos+cuantos;
+
+		e->levantamientos = (struct registroLevantamiento*)realloc(e->levantamientos, sizeof(struct registroLevantamiento)*e->capacidad);
+		if (e->levantamientos==NULL)
+		{
+			perror("Error en la reserva de los levantamientos que se exportan.\n");
+			exit(-1);
+		}
+	}
+	memcpy(&e->levantamientos[e->numLevantamientos], levantamientos, sizeof(struct registroLevantamiento)*cuantos);
+	e->numLevantamientos += cuantos;
+}
+
+
+void liberaExportacion (struct exportacion *e)
+{
+	free(e->levantamientos);
+	iniciaExportacion(e);
+}
+
+
+static int porDorsal (const void *a, const void *b)
+{
+	const struct registroLevantamiento *x = (const struct registroLevantamiento*)a;
+	const struct registroLevantamiento *y = (const struct registroLevantamiento*)b;
+
+	if (x->dorsal!=y->dorsal) return (x->dorsal<y->dorsal) ? -1 : 1;
+	if (x->t_fin!=y->t_fin) return (x->t_fin<y->t_fin) ? -1 : 1;
+	return 0;
+}
+
+
+static int anchoBits (uint64_t valor)
+{
+	return (valor==0) ? 0 : 64-__builtin_clzll(valor);
+}
+
+
+static int64_t bytesBits (int64_t n, int ancho)
+{
+	return (n*ancho+63)/64*8; // Palabras de 64 bits completas.
+}
+
+
+static void escribeBits (uint64_t *palabras, int64_t i, int ancho, uint64_t valor)
+{
+	int64_t bit = i*ancho;
+	int desde = bit & 63;
+
+	if (ancho==0) return;
+	palabras[bit>>6] |= valor<<desde;
+	if (desde+ancho>64) palabras[(bit>>6)+1] |= valor>>(64-desde);
+}
+
+
+static uint64_t leeBits (const uint64_t *palabras, int64_t i, int ancho)
+{
+	int64_t bit = i*ancho;
+	int desde = bit & 63;
+	uint64_t valor;
+
+	if (ancho==0) return 0;
+	valor = palabras[bit>>6]>>desde;
+	if (desde+ancho>64) valor |= palabras[(bit>>6)+1]<<(64-desde);
+	if (ancho<64) valor &= ((uint64_t)1<<ancho)-1;
+	return valor;
+}
+
+
+static int64_t valorColumna (struct registroLevantamiento *l, int columna)
+{
+	switch (columna)
+	{
+		case COLUMNA_DORSAL: return l->dorsal;
+		case COLUMNA_TARIMA: return l->tarima;
+		case COLUMNA_RESULTADO: return l->resultado;
+		case COLUMNA_PUNTUACION: return l->puntuacion;
+		case COLUMNA_ESPERA: return (l->t_llamada-l->t_inscripcion)/1000;
+		case COLUMNA_JUEZ: return (l->t_fin-l->t_llamada)/1000;
+		default: return l->necesita_beber;
+	}
+}
+
+
+static uint8_t *codificaColumna (int64_t *valores, int64_t n, int preferida, struct columnaExportada *columna)
+{
+	uint8_t *bloque;
+	int32_t *tramos;
+	int64_t minimo = 0;
+	int64_t maximo = 0;
+	int64_t mayorSalto = 0;
+	int64_t numTramos = 0;
+	int creciente = 1;
+	int64_t i;
+
+	for (i=0; i<n; i++)
+	{
+		if (i==0 || valores[i]<minimo) minimo = valores[i];
+		if (i==0 || valores[i]>maximo) maximo = valores[i];
+		if (i==0 || valores[i]!=valores[i-1]) numTramos++;
+		if (i>0 && valores[i]<valores[i-1]) creciente = 0;
+		if (i>0 && valores[i]-valores[i-1]>mayorSalto) mayorSalto = valores[i]-valores[i-1];
+	}
+
+	// Se queda la preferida si vale para estos valores (y si ocupa menos, en el caso de los tramos); si no, en bits.
+	columna->codificacion = CODIFICACION_BITS;
+	columna->base = minimo;
+	columna->ancho = anchoBits((uint64_t)(maximo-minimo));
+	columna->numTramos = 0;
+	columna->bytes = bytesBits(n, columna->ancho);
+
+	if (preferida==CODIFICACION_DELTA && creciente && n>0)
+	{
+		columna->codificacion = CODIFICACION_DELTA;
+		columna->base = valores[0];
+		columna->ancho = anchoBits((uint64_t)mayorSalto);
+		columna->bytes = bytesBits(n-1, columna->ancho);
+	}
+	else if (preferida==CODIFICACION_TRAMOS && numTramos*2*(int64_t)sizeof(int32_t)<columna->bytes && minimo>=INT32_MIN && maximo<=INT32_MAX && n<=INT32_MAX)
+	{
+		columna->codificacion = CODIFICACION_TRAMOS;
+		columna->base = 0;
+		columna->ancho = 0;
+		columna->numTramos = numTramos;
+		columna->bytes = numTramos*2*sizeof(int32_t);
+	}
+	else if (preferida==CODIFICACION_FIJA16 && minimo>=INT16_MIN && maximo<=INT16_MAX)
+	{
+		columna->codificacion = CODIFICACION_FIJA16;
+		columna->base = 0;
+		columna->ancho = 16;
+		columna->bytes = n*sizeof(int16_t);
+	}
+
+	bloque = (uint8_t*)calloc(columna->bytes+8, 1); // Con una palabra de más para no reservar 0 bytes.
+	if (bloque==NULL)
+	{
+		perror("Error en la reserva de una columna.\n");
+		exit(-1);
+	}
+
+	switch (columna->codificacion)
+	{
+		case CODIFICACION_DELTA:
+			for (i=1; i<n; i++)
+			{
+				escribeBits((uint64_t*)bloque, i-1, columna->ancho, (uint64_t)(valores[i]-valores[i-1]));
+			}
+			break;
+
+		case CODIFICACION_TRAMOS:
+			tramos = (int32_t*)bloque;
+			numTramos = 0;
+			for (i=0; i<n; i++)
+			{
+				if (i==0 || valores[i]!=valores[i-1])
+				{
+					tramos[2*numTramos] = (int32_t)valores[i];
+					numTramos++;
+				}
+				tramos[2*numTramos-1]++;
+			}
+			break;
+
+		case CODIFICACION_FIJA16:
+			for (i=0; i<n; i++)
+			{
+				((int16_t*)bloque)[i] = (int16_t)valores[i];
+			}
+			break;
+
+		default:
+			for (i=0; i<n; i++)
+			{
+				escribeBits((uint64_t*)bloque, i, columna->ancho, (uint64_t)(valores[i]-columna->base));
+			}
+	}
+	return bloque;
+}
+
+
+static int escribeEn (int fichero, void *datos, int64_t tam, int64_t desplazamiento)
+{
+	char *p = (char*)datos;
+	ssize_t escritos;
+
+	while (tam>0)
+	{
+		escritos = pwrite(fichero, p, tam, desplazamiento);
+		if (escritos<0) return -1;
+		p += escritos;
+		tam -= escritos;
+		desplazamiento += escritos;
+	}
+	return 0;
+}
+
+
+int64_t escribeColumnas (struct exportacion *e, char *nombre, int campeonato, int64_t escala, int sincronizar)
+{
+	struct cabeceraColumnas cabecera;
+	struct registroLevantamiento *ordenados;
+	int64_t *valores;
+	uint8_t *bloque;
+	char temporal[512];
+	int64_t n = e->numLevantamientos;
+	int64_t fin;
+	int64_t escritos = sizeof(struct cabeceraColumnas);
+	int64_t i;
+	int fichero;
+	int error = 0;
+	int c;
+
+	// Se escribe en un temporal y se renombra al final: quien lo lea nunca ve un fichero a medias.
+	snprintf(temporal, sizeof(temporal), "%s.tmp", nombre);
+	fichero = open(temporal, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+	if (fichero<0)
+	{
+		perror("Error en la apertura del fichero de columnas.\n");
+		return -1;
+	}
+
+	ordenados = (struct registroLevantamiento*)malloc(sizeof(struct registroLevantamiento)*(n+1));
+	valores = (int64_t*)malloc(sizeof(int64_t)*(n+1));
+	if (ordenados==NULL || valores==NULL)
+	{
+		perror("Error en la reserva de la exportación en columnas.\n");
+		exit(-1);
+	}
+	if (n>0) memcpy(ordenados, e->levantamientos, sizeof(struct registroLevantamiento)*n);
+	qsort(ordenados, n, sizeof(struct registroLevantamiento), porDorsal); // Llegan en el orden en que se puntuaron.
+
+	memset(&cabecera, 0, sizeof(cabecera));
+	memcpy(cabecera.magia, MAGIA_COLUMNAS, sizeof(cabecera.magia));
+	cabecera.version = VERSION_COLUMNAS;
+	cabecera.numColumnas = NUMCOLUMNAS;
+	cabecera.numLevantamientos = n;
+	cabecera.escala = escala;
+	cabecera.campeonato = campeonato;
+	cabecera.alineacion = ALINEACION_COLUMNAS;
+
+	// Cada columna va en su bloque, detrás de la anterior y empezando en una página nueva.
+	fin = sizeof(cabecera);
+	for (c=0; c<NUMCOLUMNAS && error==0; c++)
+	{
+		for (i=0; i<n; i++)
+		{
+			valores[i] = valorColumna(&ordenados[i], c);
+		}
+		cabecera.columnas[c].columna = c;
+		bloque = codificaColumna(valores, n, codificacionPreferida[c], &cabecera.columnas[c]);
+		cabecera.columnas[c].desplazamiento = (fin+ALINEACION_COLUMNAS-1)/ALINEACION_COLUMNAS*ALINEACION_COLUMNAS;
+		fin = cabecera.columnas[c].desplazamiento + cabecera.columnas[c].bytes;
+		escritos += cabecera.columnas[c].bytes;
+		if (escribeEn(fichero, bloque, cabecera.columnas[c].bytes, cabecera.columnas[c].desplazamiento)!=0) error = 1;
+		free(bloque);
+	}
+	free(valores);
+	free(ordenados);
+
+	if (error==0 && escribeEn(fichero, &cabecera, sizeof(cabecera), 0)!=0) error = 1;
+	if (error==0 && ftruncate(fichero, fin)!=0) error = 1;
+	if (error==0 && sincronizar && fdatasync(fichero)!=0) error = 1;
+	if (error!=0) perror("Error al escribir el fichero de columnas.\n");
+	close(fichero);
+
+	if (error==0 && rename(temporal, nombre)!=0)
+	{
+		perror("Error al renombrar el fichero de columnas.\n");
+		error = 1;
+	}
+	if (error!=0)
+	{
+		unlink(temporal);
+		return -1;
+	}
+	return escritos;
+}
+
+
+static int64_t bytesNecesarios (struct columnaExportada *columna, int64_t n)
+{
+	if (n<0 || columna->ancho<0 || columna->ancho>64 || columna->numTramos<0) return INT64_MAX; // Cabecera estropeada.
+
+	switch (columna->codificacion)
+	{
+		case CODIFICACION_BITS: return bytesBits(n, columna->ancho);
+		case CODIFICACION_DELTA: return (n>0) ? bytesBits(n-1, columna->ancho) : 0;
+		case CODIFICACION_TRAMOS: return (int64_t)columna->numTramos*2*sizeof(int32_t);
+		case CODIFICACION_FIJA16: return n*sizeof(int16_t);
+		default: return INT64_MAX;
+	}
+}
+
+
+int abreColumnas (char *nombre, struct ficheroColumnas *f)
+{
+	struct stat info;
+	struct columnaExportada *columna;
+	int fichero;
+	int c;
+
+	fichero = open(nombre, O_RDONLY);
+	if (fichero<0)
+	{
+		perror("Error en la apertura del fichero de columnas.\n");
+		return -1;
+	}
+	if (fstat(fichero, &info)!=0 || info.st_size<(off_t)sizeof(struct cabeceraColumnas))
+	{
+		fprintf(stderr, "%s no es un fichero de columnas.\n", nombre);
+		close(fichero);
+		return -1;
+	}
+
+	// Se proyecta entero: las páginas de las columnas que no se lean nunca se traen del disco.
+	f->tamano = info.st_size;
+	f->mapa = (uint8_t*)mmap(NULL, f->tamano, PROT_READ, MAP_SHARED, fichero, 0);
+	close(fichero);
+	if (f->mapa==MAP_FAILED)
+	{
+		perror("Error al proyectar el fichero de columnas.\n");
+		return -1;
+	}
+	f->cabecera = (struct cabeceraColumnas*)f->mapa;
+
+	if (memcmp(f->cabecera->magia, MAGIA_COLUMNAS, sizeof(f->cabecera->magia))!=0 || f->cabecera->version!=VERSION_COLUMNAS || f->cabecera->numColumnas!=NUMCOLUMNAS)
+	{
+		fprintf(stderr, "%s no es un fichero de columnas (o es de otra versión).\n", nombre);
+		cierraColumnas(f);
+		return -1;
+	}
+	for (c=0; c<NUMCOLUMNAS; c++)
+	{
+		columna = &f->cabecera->columnas[c];
+		if (columna->desplazamiento<0 || columna->desplazamiento%ALINEACION_COLUMNAS!=0 || columna->bytes<bytesNecesarios(columna, f->cabecera->numLevantamientos)
+			|| columna->desplazamiento+columna->bytes>(int64_t)f->tamano)
+		{
+			fprintf(stderr, "%s está incompleto (columna %s).\n", nombre, nombresColumnas[c]);
+			cierraColumnas(f);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+
+int buscaColumna (char *nombre)
+{
+	int c;
+
+	for (c=0; c<NUMCOLUMNAS; c++)
+	{
+		if (strcmp(nombre, nombresColumnas[c])==0) return c;
+	}
+	return -1;
+}
+
+
+void decodificaColumna (struct ficheroColumnas *f, int columna, int64_t *valores)
+{
+	struct columnaExportada *col = &f->cabecera->columnas[columna];
+	uint8_t *bloque = f->mapa + col->desplazamiento;
+	int64_t n = f->cabecera->numLevantamientos;
+	int32_t *tramos = (int32_t*)bloque;
+	int64_t i;
+	int64_t k = 0;
+	int t;
+	int r;
+
+	switch (col->codificacion)
+	{
+		case CODIFICACION_DELTA:
+			if (n>0) valores[0] = col->base;
+			for (i=1; i<n; i++)
+			{
+				valores[i] = valores[i-1] + (int64_t)leeBits((uint64_t*)bloque, i-1, col->ancho);
+			}
+			break;
+
+		case CODIFICACION_TRAMOS:
+			for (t=0; t<col->numTramos; t++)
+			{
+				for (r=0; r<tramos[2*t+1] && k<n; r++)
+				{
+					valores[k++] = tramos[2*t];
+				}
+			}
+			break;
+
+		case CODIFICACION_FIJA16:
+			for (i=0; i<n; i++)
+			{
+				valores[i] = ((int16_t*)bloque)[i];
+			}
+			break;
+
+		default:
+			for (i=0; i<n; i++)
+			{
+				valores[i] = col->base + (int64_t)leeBits((uint64_t*)bloque, i, col->ancho);
+			}
+	}
+}
+
+
+void cierraColumnas (struct ficheroColumnas *f)
+{
+	munmap(f->mapa, f->tamano);
+	f->mapa = NULL;
+	f->cabecera = NULL;
+}
@@ -0,0 +1,122 @@
+#ifndef COLUMNAS_H
+#define COLUMNAS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "resultados.h"
+
+
+/*
+ * Exportación en columnas de los levantamientos de un campeonato, para los análisis de temporada que leen miles de
+ * campeonatos. Al final del campeonato se escribe un fichero con una cabecera de ancho fijo y después, cada una en un bloque
+ * contiguo que empieza en un múltiplo de ALINEACION_COLUMNAS (se puede proyectar con mmap sólo la que haga falta), las
+ * columnas de todos los levantamientos ordenados por dorsal:
+ *
+ *   dorsal      creciente: el primero en la base y las diferencias con el anterior empaquetadas en bits (CODIFICACION_DELTA)
+ *   tarima      lo que pasa de la base empaquetado en bits (CODIFICACION_BITS)
+ *   resultado   por tramos de valores repetidos (CODIFICACION_TRAMOS) o en bits, lo que ocupe menos
+ *   puntuacion  int16_t tal cual (CODIFICACION_FIJA16)
+ *   espera      microsegundos desde la inscripción hasta que lo llama el juez, en bits
+ *   juez        microsegundos desde que lo llama el juez hasta que termina el levantamiento, en bits
+ *   agua        1 si necesita beber, por tramos o en bits
+ *
+ * Los bits van de menos a más significativo en palabras de 64 bits (el valor i empieza en el bit i*ancho). Todo se escribe
+ * en el orden de bytes de la máquina, como el almacén de resultados.
+ */
+
+
+// Definición de constantes.
+#define FICHERO_COLUMNAS "levantamientos.col"
+#define MAGIA_COLUMNAS "PLCOLUM1"
+#define VERSION_COLUMNAS 1
+#define ALINEACION_COLUMNAS 4096 // Una página: cada columna se puede proyectar sola (los huecos entre ellas no ocupan disco).
+
+// Columnas.
+#define COLUMNA_DORSAL 0
+#define COLUMNA_TARIMA 1
+#define COLUMNA_RESULTADO 2
+#define COLUMNA_PUNTUACION 3
+#define COLUMNA_ESPERA 4
+#define COLUMNA_JUEZ 5
+#define COLUMNA_AGUA 6
+#define NUMCOLUMNAS 7
+
+// Codificaciones.
+#define CODIFICACION_BITS 0 // valor = base + ancho bits.
+#define CODIFICACION_DELTA 1 // El primero es la base y cada uno es el anterior + ancho bits.
+#define CODIFICACION_TRAMOS 2 // Pares de int32_t (valor, veces seguidas).
+#define CODIFICACION_FIJA16 3 // int16_t por valor.
+
+
+
+/* Estructuras del fichero (todos los campos son de ancho fijo). */
+
+
+// Descripción de una columna (40 bytes).
+struct columnaExportada
+{
+	int32_t columna;
+	int32_t codificacion;
+	int32_t ancho; // Bits por valor (CODIFICACION_BITS y CODIFICACION_DELTA).
+	int32_t numTramos; // CODIFICACION_TRAMOS.
+	int64_t base;
+	int64_t desplazamiento; // Bytes desde el principio del fichero (múltiplo de ALINEACION_COLUMNAS).
+	int64_t bytes;
+};
+
+
+// Cabecera (320 bytes).
+struct cabeceraColumnas
+{
+	char magia[8];
+	int32_t version;
+	int32_t numColumnas;
+	int64_t numLevantamientos;
+	int64_t escala; // Nanosegundos reales que dura un segundo del campeonato (0 con --tiempo-virtual=0).
+	int32_t campeonato;
+	int32_t alineacion;
+	struct columnaExportada columnas[NUMCOLUMNAS];
+};
+
+
+
+/* Estructuras en memoria. */
+
+
+// Levantamientos que se van juntando para exportarlos al final.
+struct exportacion
+{
+	struct registroLevantamiento *levantamientos;
+	int numLevantamientos;
+	int capacidad;
+};
+
+
+// Fichero de columnas proyectado en memoria para leerlo.
+struct ficheroColumnas
+{
+	struct cabeceraColumnas *cabecera;
+	uint8_t *mapa;
+	size_t tamano;
+};
+
+
+
+/* Declaración de las funciones. */
+
+
+extern char *nombresColumnas[NUMCOLUMNAS];
+extern char *nombresCodificaciones[4];
+
+void iniciaExportacion(struct exportacion *e);
+void anadeAExportacion(struct exportacion *e, struct registroLevantamiento *levantamientos, int cuantos);
+int64_t escribeColumnas(struct exportacion *e, char *nombre, int campeonato, int64_t escala, int sincronizar); // Devuelve los bytes escritos (sin los huecos) o -1.
+void liberaExportacion(struct exportacion *e);
+
+int abreColumnas(char *nombre, struct ficheroColumnas *f); // Devuelve -1 si no se puede abrir o no es un fichero de columnas.
+int buscaColumna(char *nombre); // Número de la columna con ese nombre (-1 si no hay ninguna).
+void decodificaColumna(struct ficheroColumnas *f, int columna, int64_t *valores); // Sólo lee el bloque de esa columna.
+void cierraColumnas(struct ficheroColumnas *f);
+
+#endif
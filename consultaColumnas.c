@@ -0,0 +1,189 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "columnas.h"
+
+
+/*
+ * Consultas sobre la exportación en columnas de un campeonato (levantamientos.col).
+ *
+ *   consultaColumnas [-f fichero] resumen
+ *   consultaColumnas [-f fichero] columnas NOMBRE...
+ *   consultaColumnas [-f fichero] filas [N]
+ *
+ * resumen escribe cómo va guardada cada columna; columnas da el mínimo, el máximo, la media y la suma de las que se nombran
+ * (dorsal, tarima, resultado, puntuacion, espera, juez o agua) y sólo lee sus bloques; filas las escribe todas como CSV.
+ */
+
+
+
+/* Declaración de las variables globales. */
+
+
+struct ficheroColumnas fichero;
+
+
+
+/* Declaración de las funciones. */
+
+
+void resumen();
+void estadisticas(int columna);
+void filas(int64_t maximo);
+void uso(char *programa);
+
+
+
+/* Función principal. */
+
+
+int main (int argc, char *argv[])
+{
+	char *nombre = FICHERO_COLUMNAS;
+	int opcion;
+	int columna;
+	int i;
+
+	while ((opcion = getopt(argc, argv, "f:"))!=-1)
+	{
+		if (opcion=='f') nombre = optarg;
+		else uso(argv[0]);
+	}
+
+	if (argc-optind<1) uso(argv[0]);
+	if (abreColumnas(nombre, &fichero)!=0) exit(-1);
+
+	if (strcmp(argv[optind], "resumen")==0)
+	{
+		resumen();
+	}
+	else if (strcmp(argv[optind], "columnas")==0 && argc-optind>=2)
+	{
+		for (i=optind+1; i<argc; i++)
+		{
+			columna = buscaColumna(argv[i]);
+			if (columna<0)
+			{
+				fprintf(stderr, "No hay ninguna columna %s.\n", argv[i]);
+				exit(-1);
+			}
+			estadisticas(columna);
+		}
+	}
+	else if (strcmp(argv[optind], "filas")==0)
+	{
+		filas(argc-optind>=2 ? atol(argv[optind+1]) : INT64_MAX);
+	}
+	else
+	{
+		uso(argv[0]);
+	}
+
+	cierraColumnas(&fichero);
+	return 0;
+}
+
+
+
+/* Implementación de las funciones. */
+
+
+void uso (char *programa)
+{
+	fprintf(stderr, "Uso: %s [-f fichero] resumen | columnas NOMBRE... | filas [N]\n", programa);
+	exit(-1);
+}
+
+
+int64_t *reservaValores()
+{
+	int64_t *valores = (int64_t*)malloc(sizeof(int64_t)*(fichero.cabecera->numLevantamientos+1));
+
+	if (valores==NULL)
+	{
+		perror("Error en la reserva de los valores de una columna.\n");
+		exit(-1);
+	}
+	return valores;
+}
+
+
+void resumen()
+{
+	struct cabeceraColumnas *cabecera = fichero.cabecera;
+	struct columnaExportada *columna;
+	int64_t datos = 0;
+	int c;
+
+	printf("Campeonato %d: %ld levantamientos", cabecera->campeonato, (long)cabecera->numLevantamientos);
+	if (cabecera->escala>0) printf(" (un segundo del campeonato son %ld us)", (long)(cabecera->escala/1000));
+	printf(".\n");
+
+	printf("%-12s %-8s %6s %12s %10s %10s\n", "COLUMNA", "CODIF.", "BITS", "BASE", "BYTES", "DESDE");
+	for (c=0; c<NUMCOLUMNAS; c++)
+	{
+		columna = &cabecera->columnas[c];
+		printf("%-12s %-8s %6d %12ld %10ld %10ld\n", nombresColumnas[c], nombresCodificaciones[columna->codificacion], columna->ancho, (long)columna->base,
+			(long)columna->bytes, (long)columna->desplazamiento);
+		datos += columna->bytes;
+	}
+
+	// Lo que ocuparían los mismos levantamientos en el almacén de resultados, para comparar.
+	printf("Datos: %ld bytes (%.2f por levantamiento; %d en resultados.dat).\n", (long)datos,
+		cabecera->numLevantamientos>0 ? (double)datos/cabecera->numLevantamientos : 0.0, (int)sizeof(struct registroLevantamiento));
+}
+
+
+void estadisticas (int columna)
+{
+	int64_t *valores = reservaValores();
+	int64_t n = fichero.cabecera->numLevantamientos;
+	int64_t minimo = 0;
+	int64_t maximo = 0;
+	int64_t suma = 0;
+	int64_t i;
+
+	decodificaColumna(&fichero, columna, valores);
+	for (i=0; i<n; i++)
+	{
+		if (i==0 || valores[i]<minimo) minimo = valores[i];
+		if (i==0 || valores[i]>maximo) maximo = valores[i];
+		suma += valores[i];
+	}
+
+	printf("%s: %ld valores, mínimo %ld, máximo %ld, media %.2f, suma %ld.\n", nombresColumnas[columna], (long)n, (long)minimo, (long)maximo,
+		n>0 ? (double)suma/n : 0.0, (long)suma);
+	free(valores);
+}
+
+
+void filas (int64_t maximo)
+{
+	int64_t *valores[NUMCOLUMNAS];
+	int64_t n = fichero.cabecera->numLevantamientos;
+	int64_t i;
+	int c;
+
+	if (maximo<n) n = maximo;
+	for (c=0; c<NUMCOLUMNAS; c++)
+	{
+		valores[c] = reservaValores();
+		decodificaColumna(&fichero, c, valores[c]);
+		printf("%s%s", nombresColumnas[c], c<NUMCOLUMNAS-1 ? "," : "\n");
+	}
+
+	for (i=0; i<n; i++)
+	{
+		for (c=0; c<NUMCOLUMNAS; c++)
+		{
+			printf("%ld%s", (long)valores[c][i], c<NUMCOLUMNAS-1 ? "," : "\n");
+		}
+	}
+
+	for (c=0; c<NUMCOLUMNAS; c++)
+	{
+		free(valores[c]);
+	}
+}
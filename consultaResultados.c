@@ -0,0 +1,440 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include "resultados.h"
+
+
+/*
+ * Consultas sobre el almacén de resultados (resultados.dat, resultados.idx, resultados.dor y resultados.tar).
+ *
+ *   consultaResultados [-d datos] [-i indice] [-x dorsales] [-t tarimas] dorsal X [ejecucion [campeonato]]
+ *   consultaResultados [-d datos] [-i indice] [-x dorsales] [-t tarimas] tarima K [ejecucion [campeonato]]
+ *   consultaResultados [-d datos] [-i indice] [-x dorsales] [-t tarimas] top N [desde hasta]
+ *
+ * Las horas se dan en segundos desde la época o como AAAA-MM-DDTHH:MM:SS (hora local).
+ * Sólo se leen del fichero de datos los bloques cuyo resumen en el índice puede contener la respuesta. Un dorsal o una
+ * tarima se buscan en su índice (cada bloque tiene de todas las tarimas, y los dorsales empiezan de nuevo en cada
+ * campeonato) y se leen sólo sus levantamientos; los que aún no estén en ese índice se buscan por bloques.
+ */
+
+
+
+/* Declaración de las variables globales. */
+
+
+int ficheroDatos;
+int ficheroDorsales;
+int ficheroTarimas;
+int64_t numRegistros;
+struct bloqueIndice *bloques; // Índice completo en memoria (más los registros que hubieran quedado fuera).
+int numBloques;
+struct registroLevantamiento *lectura; // Registros del bloque que se está leyendo.
+int64_t bloquesLeidos; // Para saber cuánto del fichero ha hecho falta leer.
+int64_t lecturasIndice; // Lecturas del índice por dorsal o por tarima y levantamientos leídos de uno en uno.
+int64_t registrosLeidos;
+
+
+char *nombresResultado[3] = {"válido", "nulo (indumentaria)", "nulo (fuerza)"};
+
+
+
+/* Declaración de las funciones. */
+
+
+void cargaIndice(char *nombreDatos, char *nombreIndice, char *nombreDorsales, char *nombreTarimas);
+int leeBloque(int b);
+int leeEntradas(int fichero, int64_t desplazamiento, struct entradaClave *entradas, int cuantas);
+int64_t leeHora(char *texto);
+void imprimeCabecera();
+void imprimeLevantamiento(struct registroLevantamiento *levantamiento);
+int coincide(struct registroLevantamiento *levantamiento, int tipo, int clave, int64_t ejecucion, int campeonato);
+int64_t buscaEnIndice(int fichero, int clave, int64_t ejecucion, int campeonato); // Devuelve los registros que cubre el índice.
+void buscaPorBloques(int64_t cubiertos, int tipo, int clave, int64_t ejecucion, int campeonato);
+void consultaClave(int tipo, int clave, int64_t ejecucion, int campeonato); // Por dorsal o por tarima; ejecución y campeonato 0: todos.
+void consultaMejores(int n, int64_t desde, int64_t hasta);
+void uso(char *programa);
+
+
+
+/* Función principal. */
+
+
+int main (int argc, char *argv[])
+{
+	char *nombreDatos = FICHERO_RESULTADOS;
+	char *nombreIndice = FICHERO_INDICE;
+	char *nombreDorsales = FICHERO_DORSALES;
+	char *nombreTarimas = FICHERO_TARIMAS;
+	int opcion;
+	int64_t desde;
+	int64_t hasta;
+
+	while ((opcion = getopt(argc, argv, "d:i:x:t:"))!=-1)
+	{
+		if (opcion=='d') nombreDatos = optarg;
+		else if (opcion=='i') nombreIndice = optarg;
+		else if (opcion=='x') nombreDorsales = optarg;
+		else if (opcion=='t') nombreTarimas = optarg;
+		else uso(argv[0]);
+	}
+
+	if (argc-optind<2) uso(argv[0]);
+
+	cargaIndice(nombreDatos, nombreIndice, nombreDorsales, nombreTarimas);
+	lectura = (struct registroLevantamiento*)malloc(sizeof(struct registroLevantamiento)*REGISTROS_POR_BLOQUE);
+
+	if (strcmp(argv[optind], "dorsal")==0 || strcmp(argv[optind], "tarima")==0)
+	{
+		consultaClave((argv[optind][0]=='d') ? CLAVE_DORSAL : CLAVE_TARIMA, atoi(argv[optind+1]), (argc-optind>=3) ? atoll(argv[optind+2]) : 0, (argc-optind>=4) ? atoi(argv[optind+3]) : 0);
+	}
+	else if (strcmp(argv[optind], "top")==0)
+	{
+		desde = 0;
+		hasta = INT64_MAX;
+		if (argc-optind>=4)
+		{
+			desde = leeHora(argv[optind+2]);
+			hasta = leeHora(argv[optind+3]);
+		}
+		consultaMejores(atoi(argv[optind+1]), desde, hasta);
+	}
+	else
+	{
+		uso(argv[0]);
+	}
+
+	fprintf(stderr, "Bloques leídos: %ld de %d.\n", (long)bloquesLeidos, numBloques);
+	if (lecturasIndice>0) fprintf(stderr, "Índice por %s: %ld lecturas y %ld levantamientos leídos.\n", argv[optind], (long)lecturasIndice, (long)registrosLeidos);
+
+	free(lectura);
+	free(bloques);
+	close(ficheroDatos);
+	if (ficheroDorsales>=0) close(ficheroDorsales);
+	if (ficheroTarimas>=0) close(ficheroTarimas);
+	return 0;
+}
+
+
+
+/* Implementación de las funciones. */
+
+
+void uso (char *programa)
+{
+	fprintf(stderr, "Uso: %s [-d datos] [-i indice] [-x dorsales] [-t tarimas] dorsal X [ejecucion [campeonato]] | tarima K [ejecucion [campeonato]] | top N [desde hasta]\n", programa);
+	exit(-1);
+}
+
+
+void cargaIndice (char *nombreDatos, char *nombreIndice, char *nombreDorsales, char *nombreTarimas)
+{
+	struct stat info;
+	int ficheroIndice;
+	int64_t cubiertos;
+	int64_t i;
+	struct registroLevantamiento levantamiento;
+
+	ficheroDatos = open(nombreDatos, O_RDONLY);
+	if (ficheroDatos<0)
+	{
+		perror("Error en la apertura del fichero de resultados.\n");
+		exit(-1);
+	}
+	if (!compruebaCabecera(ficheroDatos))
+	{
+		fprintf(stderr, "%s no es un almacén de resultados de esta versión.\n", nombreDatos);
+		exit(-1);
+	}
+	fstat(ficheroDatos, &info);
+	numRegistros = (info.st_size-sizeof(struct cabeceraResultados))/sizeof(struct registroLevantamiento);
+	ficheroDorsales = open(nombreDorsales, O_RDONLY); // Sin ellos se busca por bloques.
+	ficheroTarimas = open(nombreTarimas, O_RDONLY);
+
+
+	// Se carga el índice entero (ocupa un bloque por cada REGISTROS_POR_BLOQUE levantamientos).
+	numBloques = 0;
+	ficheroIndice = open(nombreIndice, O_RDONLY);
+	if (ficheroIndice>=0)
+	{
+		fstat(ficheroIndice, &info);
+		numBloques = info.st_size/sizeof(struct bloqueIndice);
+	}
+
+	bloques = (struct bloqueIndice*)malloc(sizeof(struct bloqueIndice)*(numBloques + numRegistros/REGISTROS_POR_BLOQUE + 1));
+	if (numBloques>0 && pread(ficheroIndice, bloques, sizeof(struct bloqueIndice)*numBloques, 0)!=(ssize_t)(sizeof(struct bloqueIndice)*numBloques))
+	{
+		perror("Error en la lectura del índice.\n");
+		exit(-1);
+	}
+	if (ficheroIndice>=0) close(ficheroIndice);
+
+	// Se descartan las entradas que apunten más allá de los datos.
+	while (numBloques>0 && bloques[numBloques-1].primer_registro+bloques[numBloques-1].num_registros>numRegistros)
+	{
+		numBloques--;
+	}
+
+
+	// Los registros que no estén en el índice (campeonato en curso o cortado) se resumen ahora.
+	cubiertos = 0;
+	if (numBloques>0) cubiertos = bloques[numBloques-1].primer_registro + bloques[numBloques-1].num_registros;
+
+	for (i=cubiertos; i<numRegistros; i++)
+	{
+		if ((i-cubiertos)%REGISTROS_POR_BLOQUE==0)
+		{
+			iniciaBloque(&bloques[numBloques], i);
+			numBloques++;
+		}
+		pread(ficheroDatos, &levantamiento, sizeof(struct registroLevantamiento), POSICION_REGISTRO(i));
+		anadeABloque(&bloques[numBloques-1], &levantamiento);
+	}
+}
+
+
+int leeBloque (int b)
+{
+	ssize_t tam = sizeof(struct registroLevantamiento)*bloques[b].num_registros;
+
+	if (pread(ficheroDatos, lectura, tam, POSICION_REGISTRO(bloques[b].primer_registro))!=tam)
+	{
+		perror("Error en la lectura del fichero de resultados.\n");
+		exit(-1);
+	}
+	bloquesLeidos++;
+	return bloques[b].num_registros;
+}
+
+
+int64_t leeHora (char *texto)
+{
+	struct tm fecha;
+	char *fin;
+
+	memset(&fecha, 0, sizeof(struct tm));
+	fin = strptime(texto, "%Y-%m-%dT%H:%M:%S", &fecha);
+	if (fin!=NULL && *fin=='\0')
+	{
+		fecha.tm_isdst = -1;
+		return (int64_t)mktime(&fecha)*1000000000;
+	}
+	return (int64_t)atoll(texto)*1000000000;
+}
+
+
+int leeEntradas (int fichero, int64_t desplazamiento, struct entradaClave *entradas, int cuantas)
+{
+	ssize_t leidos = pread(fichero, entradas, sizeof(struct entradaClave)*cuantas, desplazamiento);
+
+	if (leidos<(ssize_t)sizeof(struct entradaClave))
+	{
+		perror("Error en la lectura del índice por dorsal o por tarima.\n");
+		exit(-1);
+	}
+	lecturasIndice++;
+	return leidos/sizeof(struct entradaClave);
+}
+
+
+void imprimeCabecera()
+{
+	printf("ejecución\tcampeonato\tdorsal\ttarima\tresultado\tpuntos\tinscripción\tllamada\tfin\tbebe\n");
+}
+
+
+void imprimeHora (int64_t ns)
+{
+	time_t segundos = ns/1000000000;
+	struct tm fecha;
+	char texto[32];
+
+	localtime_r(&segundos, &fecha);
+	strftime(texto, sizeof(texto), "%d/%m/%y %H:%M:%S", &fecha);
+	printf("%s.%03d", texto, (int)(ns%1000000000/1000000));
+}
+
+
+void imprimeLevantamiento (struct registroLevantamiento *levantamiento)
+{
+	const char *resultado = "?";
+
+	if (levantamiento->resultado>=0 && levantamiento->resultado<3) resultado = nombresResultado[levantamiento->resultado];
+
+	printf("%lld\t%d\t%d\t%d\t%s\t%d\t", (long long)levantamiento->ejecucion, levantamiento->campeonato, levantamiento->dorsal, levantamiento->tarima, resultado, levantamiento->puntuacion);
+	imprimeHora(levantamiento->t_inscripcion);
+	printf("\t");
+	imprimeHora(levantamiento->t_llamada);
+	printf("\t");
+	imprimeHora(levantamiento->t_fin);
+	printf("\t%s\n", levantamiento->necesita_beber ? "sí" : "no");
+}
+
+
+int coincide (struct registroLevantamiento *levantamiento, int tipo, int clave, int64_t ejecucion, int campeonato)
+{
+	if (((tipo==CLAVE_DORSAL) ? levantamiento->dorsal : levantamiento->tarima)!=clave) return 0;
+	if (ejecucion!=0 && levantamiento->ejecucion!=ejecucion) return 0;
+	return campeonato==0 || levantamiento->campeonato==campeonato;
+}
+
+
+int64_t buscaEnIndice (int fichero, int clave, int64_t ejecucion, int campeonato)
+{
+	struct stat info;
+	struct tramoClaves tramo;
+	struct entradaClave buscada;
+	struct entradaClave entradas[REGISTROS_POR_BLOQUE];
+	struct registroLevantamiento levantamiento;
+	int64_t desplazamiento = 0;
+	int64_t cubiertos = 0;
+	int64_t primera;
+	int64_t bajo;
+	int64_t alto;
+	int64_t medio;
+	int n;
+	int i;
+	int sigue;
+
+	if (fichero<0) return 0;
+
+	// Primera entrada que puede coincidir: con ejecución y campeonato a 0 va delante de todas las de esa clave.
+	buscada.clave = clave;
+	buscada.campeonato = campeonato;
+	buscada.ejecucion = ejecucion;
+	buscada.registro = -1;
+
+	// En cada tramo (los mismos que acepta abreResultados) se busca por bisección y se sigue mientras coincida la clave.
+	fstat(fichero, &info);
+	while (desplazamiento+(int64_t)sizeof(struct tramoClaves)<=info.st_size)
+	{
+		if (pread(fichero, &tramo, sizeof(struct tramoClaves), desplazamiento)!=(ssize_t)sizeof(struct tramoClaves)) break;
+		lecturasIndice++;
+		if (tramo.primer_registro!=cubiertos || tramo.num_entradas<=0 || cubiertos+tramo.num_entradas>numRegistros) break;
+		if (desplazamiento+(int64_t)sizeof(struct tramoClaves)+tramo.num_entradas*(int64_t)sizeof(struct entradaClave)>info.st_size) break;
+
+		primera = desplazamiento + sizeof(struct tramoClaves);
+		desplazamiento = primera + tramo.num_entradas*sizeof(struct entradaClave);
+		cubiertos += tramo.num_entradas;
+		if (ejecucion!=0 && (ejecucion<tramo.ejecucion_min || ejecucion>tramo.ejecucion_max)) continue;
+
+		bajo = 0;
+		alto = tramo.num_entradas;
+		while (bajo<alto)
+		{
+			medio = (bajo+alto)/2;
+			leeEntradas(fichero, primera + medio*sizeof(struct entradaClave), entradas, 1);
+			if (comparaEntradas(&entradas[0], &buscada)<0) bajo = medio+1;
+			else alto = medio;
+		}
+
+		// Las entradas que siguen se leen de REGISTROS_POR_BLOQUE en REGISTROS_POR_BLOQUE y de cada una sólo su levantamiento.
+		for (sigue=1; sigue==1 && bajo<tramo.num_entradas; bajo+=n)
+		{
+			n = (tramo.num_entradas-bajo<REGISTROS_POR_BLOQUE) ? (int)(tramo.num_entradas-bajo) : REGISTROS_POR_BLOQUE;
+			n = leeEntradas(fichero, primera + bajo*sizeof(struct entradaClave), entradas, n);
+			for (i=0; i<n && sigue==1; i++)
+			{
+				if (entradas[i].clave!=clave || (ejecucion!=0 && entradas[i].ejecucion!=ejecucion)) sigue = 0;
+				else if (campeonato==0 || entradas[i].campeonato==campeonato)
+				{
+					if (pread(ficheroDatos, &levantamiento, sizeof(struct registroLevantamiento), POSICION_REGISTRO(entradas[i].registro))!=(ssize_t)sizeof(struct registroLevantamiento))
+					{
+						perror("Error en la lectura del fichero de resultados.\n");
+						exit(-1);
+					}
+					registrosLeidos++;
+					imprimeLevantamiento(&levantamiento);
+				}
+			}
+		}
+	}
+	return cubiertos;
+}
+
+
+void buscaPorBloques (int64_t cubiertos, int tipo, int clave, int64_t ejecucion, int campeonato)
+{
+	uint64_t bit = bitTarima(clave);
+	int b;
+	int i;
+	int n;
+
+	// Los levantamientos que aún no están en el índice (campeonato en curso o cortado) se buscan con el resumen de los bloques.
+	for (b=0; b<numBloques; b++)
+	{
+		if (bloques[b].primer_registro+bloques[b].num_registros<=cubiertos) continue;
+		if (tipo==CLAVE_DORSAL && (clave<bloques[b].dorsal_min || clave>bloques[b].dorsal_max)) continue;
+		if (tipo==CLAVE_TARIMA && (bloques[b].mascara_tarimas & bit)==0) continue;
+		if (ejecucion!=0 && (ejecucion<bloques[b].ejecucion_min || ejecucion>bloques[b].ejecucion_max)) continue;
+
+		n = leeBloque(b);
+		for (i=0; i<n; i++)
+		{
+			if (bloques[b].primer_registro+i>=cubiertos && coincide(&lectura[i], tipo, clave, ejecucion, campeonato)) imprimeLevantamiento(&lectura[i]);
+		}
+	}
+}
+
+
+void consultaClave (int tipo, int clave, int64_t ejecucion, int campeonato)
+{
+	imprimeCabecera();
+	buscaPorBloques(buscaEnIndice((tipo==CLAVE_DORSAL) ? ficheroDorsales : ficheroTarimas, clave, ejecucion, campeonato), tipo, clave, ejecucion, campeonato);
+}
+
+
+int comparaBloques (const void *a, const void *b)
+{
+	return ((struct bloqueIndice*)b)->puntuacion_max - ((struct bloqueIndice*)a)->puntuacion_max;
+}
+
+
+void consultaMejores (int n, int64_t desde, int64_t hasta)
+{
+	struct registroLevantamiento *mejores;
+	int numMejores = 0;
+	int b;
+	int i;
+	int j;
+	int leidos;
+
+	if (n<=0) return;
+	mejores = (struct registroLevantamiento*)malloc(sizeof(struct registroLevantamiento)*n);
+
+	// Se recorren los bloques de mayor a menor puntuación máxima para poder parar en cuanto ninguno pueda entrar.
+	qsort(bloques, numBloques, sizeof(struct bloqueIndice), comparaBloques);
+
+	for (b=0; b<numBloques; b++)
+	{
+		if (numMejores==n && bloques[b].puntuacion_max<=mejores[n-1].puntuacion) break;
+		if (bloques[b].t_max<desde || bloques[b].t_min>hasta) continue;
+
+		leidos = leeBloque(b);
+		for (i=0; i<leidos; i++)
+		{
+			if (lectura[i].t_fin<desde || lectura[i].t_fin>hasta) continue;
+			if (numMejores==n && lectura[i].puntuacion<=mejores[n-1].puntuacion) continue;
+
+			// Inserción ordenada en la lista de los mejores.
+			if (numMejores<n) numMejores++;
+			for (j=numMejores-1; j>0 && mejores[j-1].puntuacion<lectura[i].puntuacion; j--)
+			{
+				mejores[j] = mejores[j-1];
+			}
+			mejores[j] = lectura[i];
+		}
+	}
+
+	imprimeCabecera();
+	for (i=0; i<numMejores; i++)
+	{
+		imprimeLevantamiento(&mejores[i]);
+	}
+	free(mejores);
+}
@@ -0,0 +1,326 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "durabilidad.h"
+
+
+
+/* Implementación de las funciones. */
+
+
+static void pasoDurabilidad(struct tarea *tarea);
+
+
+static int esModo (char *texto, char *nombre)
+{
+	int n = strlen(nombre);
+
+	return strncmp(texto, nombre, n)==0 && (texto[n]=='\0' || texto[n]==':');
+}
+
+
+int leeDurabilidad (char *texto, int *modo, int *milisegundos)
+{
+	char *dosPuntos = strchr(texto, ':');
+
+	if (strcmp(texto, "nada")==0)
+	{
+		*modo = DURABILIDAD_NADA;
+		*milisegundos = 0;
+		return 0;
+	}
+	else if (esModo(texto, "periodica"))
+	{
+		*modo = DURABILIDAD_PERIODICA;
+		*milisegundos = PERIODO_DURABILIDAD_MS;
+	}
+	else if (esModo(texto, "grupo"))
+	{
+		*modo = DURABILIDAD_GRUPO;
+		*milisegundos = LATENCIA_DURABILIDAD_MS;
+	}
+	else return -1;
+
+	if (dosPuntos!=NULL)
+	{
+		*milisegundos = atoi(dosPuntos+1);
+		if (*milisegundos<=0) return -1;
+	}
+	return 0;
+}
+
+
+void iniciaDurabilidad (struct durabilidad *d, int modo, int milisegundos, int maxFicheros)
+{
+	memset(d, 0, sizeof(struct durabilidad));
+	d->modo = modo;
+	d->intervalo = (int64_t)milisegundos*1000000;
+	if (modo==DURABILIDAD_NADA) return;
+
+	if (pthread_mutex_init(&d->semaforo, NULL)!=0 || pthread_mutex_init(&d->semaforo_sincroniza, NULL)!=0)
+	{
+		perror("Error en la creación de los semáforos de la durabilidad.\n");
+		exit(-1);
+	}
+
+	d->maxFicheros = maxFicheros;
+	d->ficheros = (struct ficheroDurable*)malloc(sizeof(struct ficheroDurable)*maxFicheros);
+	d->aSincronizar = (int*)malloc(sizeof(int)*maxFicheros);
+	if (d->ficheros==NULL || d->aSincronizar==NULL)
+	{
+		perror("Error en la reserva de los ficheros durables.\n");
+		exit(-1);
+	}
+	d->base = relojMonotonico();
+	iniciaTarea(&d->tarea, pasoDurabilidad, d);
+}
+
+
+void vaciaAntesDeSincronizar (struct durabilidad *d, void (*vaciar)(void *datos), void *datos)
+{
+	d->vaciar = vaciar;
+	d->datosVaciar = datos;
+}
+
+
+static void bloquea (pthread_mutex_t *semaforo)
+{
+	if (pthread_mutex_lock(semaforo)!=0)
+	{
+		perror("Error en el bloqueo del semáforo de la durabilidad.\n");
+		exit(-1);
+	}
+}
+
+
+static void desbloquea (pthread_mutex_t *semaforo)
+{
+	if (pthread_mutex_unlock(semaforo)!=0)
+	{
+		perror("Error en el desbloqueo del semáforo de la durabilidad.\n");
+		exit(-1);
+	}
+}
+
+
+void arrancaDurabilidad (struct durabilidad *d)
+{
+	if (d->modo==DURABILIDAD_NADA) return;
+
+	bloquea(&d->semaforo);
+		d->enMarcha = 1;
+		if (d->modo==DURABILIDAD_PERIODICA) programaTarea(&d->tarea, d->intervalo);
+	desbloquea(&d->semaforo);
+}
+
+
+static void programaGrupo (struct durabilidad *d, int64_t hora)
+{
+	int64_t espera;
+
+	// El primero que queda pendiente fija cuándo se confirma todo el grupo: a la latencia máxima de cuando ocurrió.
+	if (d->modo!=DURABILIDAD_GRUPO || d->enMarcha==0 || d->programada==1) return;
+
+	d->programada = 1;
+	espera = hora + d->intervalo - (relojMonotonico()-d->base);
+	programaTarea(&d->tarea, espera>0 ? espera : 0);
+} // Se llama con semaforo.
+
+
+static struct ficheroDurable *buscaFichero (struct durabilidad *d, int fd)
+{
+	int i;
+
+	for (i=0; i<d->numFicheros; i++)
+	{
+		if (d->ficheros[i].fd==fd) return &d->ficheros[i];
+	}
+	return NULL;
+} // Se llama con semaforo.
+
+
+void anadeFichero (struct durabilidad *d, int fd)
+{
+	if (d->modo==DURABILIDAD_NADA || fd<0) return;
+
+	bloquea(&d->semaforo);
+
+		if (d->numFicheros==d->maxFicheros)
+		{
+			fprintf(stderr, "Demasiados ficheros durables.\n");
+			exit(-1);
+		}
+		memset(&d->ficheros[d->numFicheros], 0, sizeof(struct ficheroDurable));
+		d->ficheros[d->numFicheros].fd = fd;
+		d->numFicheros++;
+
+	desbloquea(&d->semaforo);
+}
+
+
+void apuntaRegistro (struct durabilidad *d, struct registrosPendientes *pendientes, int64_t hora)
+{
+	if (d->modo==DURABILIDAD_NADA) return;
+	hora = ((hora!=0) ? hora : relojMonotonico()) - d->base;
+
+	if (pendientes->registros==0 || hora<pendientes->masAntiguo) pendientes->masAntiguo = hora;
+	pendientes->registros++;
+	pendientes->sumaHoras += hora;
+
+	// Con el primero del buffer se programa el grupo aunque aún no se haya escrito (los demás ya llegan a tiempo).
+	if (d->modo==DURABILIDAD_GRUPO && pendientes->registros==1)
+	{
+		bloquea(&d->semaforo);
+			programaGrupo(d, hora);
+		desbloquea(&d->semaforo);
+	}
+}
+
+
+void apuntaEscritura (struct durabilidad *d, int fd, struct registrosPendientes *pendientes)
+{
+	struct ficheroDurable *f;
+
+	if (d->modo==DURABILIDAD_NADA || pendientes->registros<=0) return;
+
+	bloquea(&d->semaforo);
+
+		f = buscaFichero(d, fd);
+		if (f!=NULL)
+		{
+			if (f->pendientes==0 || pendientes->masAntiguo<f->masAntiguo) f->masAntiguo = pendientes->masAntiguo;
+			f->pendientes += pendientes->registros;
+			f->sumaHoras += pendientes->sumaHoras;
+
+			// Por si la ronda que los esperaba ya ha pasado sin ellos (una tanda que no se vacía desde fuera).
+			programaGrupo(d, pendientes->masAntiguo);
+		}
+
+	desbloquea(&d->semaforo);
+
+	pendientes->registros = 0;
+	pendientes->sumaHoras = 0;
+}
+
+
+static void cuentaSincronizacion (struct durabilidad *d, long registros, int64_t sumaHoras, int64_t masAntiguo, int llamadas)
+{
+	int64_t fin = relojMonotonico()-d->base;
+
+	bloquea(&d->semaforo);
+
+		d->llamadas += llamadas;
+		if (registros>0)
+		{
+			d->sincronizaciones++;
+			d->registros += registros;
+			d->latenciaTotal += registros*fin-sumaHoras;
+			if (fin-masAntiguo>d->latenciaMaxima) d->latenciaMaxima = fin-masAntiguo;
+		}
+
+	desbloquea(&d->semaforo);
+}
+
+
+static void sincroniza (struct durabilidad *d)
+{
+	struct ficheroDurable *f;
+	long registros = 0;
+	int64_t sumaHoras = 0;
+	int64_t masAntiguo = 0;
+	int numSincronizar = 0;
+	int i;
+
+	bloquea(&d->semaforo_sincroniza);
+
+		// Se toma lo pendiente de cada fichero; lo que se escriba mientras se sincroniza también se queda en el disco, pero
+		// se cuenta en la ronda siguiente.
+		bloquea(&d->semaforo);
+			for (i=0; i<d->numFicheros; i++)
+			{
+				f = &d->ficheros[i];
+				if (f->pendientes==0) continue;
+
+				if (registros==0 || f->masAntiguo<masAntiguo) masAntiguo = f->masAntiguo;
+				registros += f->pendientes;
+				sumaHoras += f->sumaHoras;
+				d->aSincronizar[numSincronizar++] = f->fd;
+				f->pendientes = 0;
+				f->sumaHoras = 0;
+			}
+		desbloquea(&d->semaforo);
+
+		for (i=0; i<numSincronizar; i++)
+		{
+			if (fdatasync(d->aSincronizar[i])!=0) perror("Error en la sincronización de un fichero.\n");
+		}
+		cuentaSincronizacion(d, registros, sumaHoras, masAntiguo, numSincronizar);
+
+	desbloquea(&d->semaforo_sincroniza);
+}
+
+
+static void pasoDurabilidad (struct tarea *tarea)
+{
+	struct durabilidad *d = (struct durabilidad*)tarea->datos;
+
+	// Lo que llegue desde aquí programa otra ronda; lo de antes, aunque siga en un buffer, se escribe y entra en ésta.
+	bloquea(&d->semaforo);
+		d->programada = 0;
+	desbloquea(&d->semaforo);
+	if (d->vaciar!=NULL) d->vaciar(d->datosVaciar);
+
+	sincroniza(d);
+
+	bloquea(&d->semaforo);
+		if (d->modo==DURABILIDAD_PERIODICA && d->enMarcha==1) programaTarea(tarea, d->intervalo);
+	desbloquea(&d->semaforo);
+}
+
+
+void sincronizaAlCerrar (struct durabilidad *d, int fd)
+{
+	struct ficheroDurable *f;
+	struct ficheroDurable quitado = {0};
+
+	if (d->modo==DURABILIDAD_NADA || fd<0) return;
+
+	bloquea(&d->semaforo_sincroniza);
+
+		bloquea(&d->semaforo);
+			f = buscaFichero(d, fd);
+			if (f!=NULL)
+			{
+				quitado = *f;
+				*f = d->ficheros[--d->numFicheros];
+			}
+		desbloquea(&d->semaforo);
+
+		// Aunque no tenga nada apuntado (el log del coordinador, por ejemplo) se deja en el disco antes de cerrarlo.
+		if (fdatasync(fd)!=0) perror("Error en la sincronización de un fichero.\n");
+		cuentaSincronizacion(d, quitado.pendientes, quitado.sumaHoras, quitado.masAntiguo, 1);
+
+	desbloquea(&d->semaforo_sincroniza);
+}
+
+
+void paraDurabilidad (struct durabilidad *d)
+{
+	if (d->modo==DURABILIDAD_NADA) return;
+
+	bloquea(&d->semaforo);
+		d->enMarcha = 0; // Ya no se programa más.
+	desbloquea(&d->semaforo);
+	cancelaTarea(&d->tarea);
+}
+
+
+void liberaDurabilidad (struct durabilidad *d)
+{
+	free(d->ficheros);
+	free(d->aSincronizar);
+	d->ficheros = NULL;
+	d->aSincronizar = NULL;
+}
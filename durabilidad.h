@@ -0,0 +1,97 @@
+#ifndef DURABILIDAD_H
+#define DURABILIDAD_H
+
+#include <stdint.h>
+#include <pthread.h>
+
+#include "planificador.h"
+
+
+/*
+ * Durabilidad de los ficheros log y del almacén de resultados. Con DURABILIDAD_NADA se deja todo en la caché del sistema
+ * (como siempre); con DURABILIDAD_PERIODICA una tarea hace fdatasync cada cierto tiempo de los ficheros en los que se ha
+ * escrito algo; con DURABILIDAD_GRUPO el primer registro que queda sin sincronizar programa la tarea para dentro de la
+ * latencia máxima, y un solo fdatasync por fichero confirma todos los registros que se han escrito mientras tanto.
+ *
+ * Cada registro (mensaje o levantamiento) se apunta con apuntaRegistro y la hora a la que ocurrió lo que cuenta, antes de
+ * esperar en los buffers y en las tandas; al escribirlo (write) se pasa al fichero con apuntaEscritura. Así la latencia
+ * que se mide, y la que acota el modo grupo, va desde el suceso hasta que está en el disco: el grupo se programa con el
+ * primer registro que queda pendiente, y antes de sincronizar se vacían los buffers (vaciaAntesDeSincronizar).
+ * Al cerrar un fichero se sincroniza por última vez con sincronizaAlCerrar.
+ */
+
+
+// Definición de constantes.
+#define DURABILIDAD_NADA 0
+#define DURABILIDAD_PERIODICA 1
+#define DURABILIDAD_GRUPO 2
+
+#define PERIODO_DURABILIDAD_MS 1000 // Por defecto para periodica.
+#define LATENCIA_DURABILIDAD_MS 10 // Por defecto para grupo.
+
+
+
+/* Estructuras. */
+
+
+// Registros pendientes de escribir en un buffer o en una tanda (los protege quien los escribe).
+struct registrosPendientes
+{
+	int registros;
+	int64_t sumaHoras; // Suma de las horas a las que ocurrieron (para la latencia media).
+	int64_t masAntiguo; // Hora del primero.
+};
+
+
+struct ficheroDurable
+{
+	int fd;
+	long pendientes; // Registros escritos desde la última sincronización.
+	int64_t sumaHoras; // Suma de las horas a las que ocurrieron (para la latencia media).
+	int64_t masAntiguo; // Hora del primero que espera.
+};
+
+
+struct durabilidad
+{
+	int modo;
+	int64_t intervalo; // Nanosegundos: el periodo o la latencia máxima.
+
+	pthread_mutex_t semaforo; // Para apuntar escrituras (se coge poco tiempo).
+	pthread_mutex_t semaforo_sincroniza; // Uno sincroniza a la vez, y no se quita un fichero mientras tanto.
+	struct ficheroDurable *ficheros;
+	int numFicheros;
+	int maxFicheros;
+	int *aSincronizar; // Hueco para los descriptores de cada ronda.
+	int64_t base; // Las horas se cuentan desde aquí (así las sumas no se desbordan).
+	int programada; // 1 si la tarea ya está programada para confirmar un grupo.
+	int enMarcha; // 1 entre arrancaDurabilidad y paraDurabilidad (sólo entonces se programa la tarea).
+	struct tarea tarea;
+	void (*vaciar)(void *datos); // Escribe lo que espera en los buffers antes de cada ronda (puede ser NULL).
+	void *datosVaciar;
+
+	// Estadísticas (con semaforo).
+	long sincronizaciones; // Rondas de sincronización con algo pendiente.
+	long llamadas; // fdatasync que se han hecho.
+	long registros; // Registros que han pasado a ser durables.
+	int64_t latenciaTotal; // Nanosegundos desde que ocurrió cada registro hasta que se sincronizó.
+	int64_t latenciaMaxima;
+};
+
+
+
+/* Declaración de las funciones. */
+
+
+int leeDurabilidad(char *texto, int *modo, int *milisegundos); // nada, periodica[:MS] o grupo[:MS]; devuelve -1 si no es válido.
+void iniciaDurabilidad(struct durabilidad *d, int modo, int milisegundos, int maxFicheros);
+void vaciaAntesDeSincronizar(struct durabilidad *d, void (*vaciar)(void *datos), void *datos);
+void arrancaDurabilidad(struct durabilidad *d); // Con el planificador ya en marcha.
+void anadeFichero(struct durabilidad *d, int fd);
+void apuntaRegistro(struct durabilidad *d, struct registrosPendientes *pendientes, int64_t hora); // Hora del reloj monotónico (0: ahora).
+void apuntaEscritura(struct durabilidad *d, int fd, struct registrosPendientes *pendientes); // Después de escribirlos (write) en el fichero; los deja a 0.
+void sincronizaAlCerrar(struct durabilidad *d, int fd); // Antes de cerrarlo: lo sincroniza y lo quita.
+void paraDurabilidad(struct durabilidad *d);
+void liberaDurabilidad(struct durabilidad *d);
+
+#endif
@@ -0,0 +1,202 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "fragmentos.h"
+
+
+
+/* Declaración de las variables globales de los fragmentos. */
+
+
+static pthread_mutex_t semaforo_clasificacion = PTHREAD_MUTEX_INITIALIZER; // Los jueces de un mismo fragmento publican de uno en uno.
+
+struct clasificado
+{
+	int dorsal;
+	int puntuacion;
+	int64_t fin;
+};
+
+
+
+/* Implementación de las funciones. */
+
+
+struct zonaFragmentos *creaZonaFragmentos (char *nombre, int numFragmentos)
+{
+	struct zonaFragmentos *zona;
+	int fd;
+
+	shm_unlink(nombre); // Por si quedó una de un coordinador anterior con el mismo pid.
+	fd = shm_open(nombre, O_RDWR|O_CREAT|O_EXCL, 0600);
+	if (fd<0) return NULL;
+
+	if (ftruncate(fd, sizeof(struct zonaFragmentos))!=0)
+	{
+		close(fd);
+		shm_unlink(nombre);
+		return NULL;
+	}
+
+	// Los fragmentos se crean con fork y heredan la proyección, así que no necesitan abrirla por su nombre.
+	zona = (struct zonaFragmentos*)mmap(NULL, sizeof(struct zonaFragmentos), PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (zona==MAP_FAILED)
+	{
+		shm_unlink(nombre);
+		return NULL;
+	}
+
+	memset(zona, 0, sizeof(struct zonaFragmentos));
+	zona->numFragmentos = numFragmentos;
+	return zona;
+}
+
+
+void borraZonaFragmentos (char *nombre, struct zonaFragmentos *zona)
+{
+	munmap(zona, sizeof(struct zonaFragmentos));
+	shm_unlink(nombre);
+}
+
+
+int vaDelante (int puntuacion, int64_t fin, int dorsal, int otraPuntuacion, int64_t otroFin, int otroDorsal)
+{
+	// El podio de cada campeonato, la clasificación parcial de cada fragmento y la mezcla del coordinador desempatan igual
+	// que el podio de siempre: el levantamiento que llega después se queda el puesto.
+	if (puntuacion!=otraPuntuacion) return puntuacion>otraPuntuacion;
+	if (fin!=otroFin) return fin>otroFin;
+	return dorsal>otroDorsal;
+}
+
+
+void apuntaLevantamiento (struct fragmentoCompartido *fragmento, int dorsal, int puntuacion, int64_t fin)
+{
+	int i;
+	int j;
+
+	if (pthread_mutex_lock(&semaforo_clasificacion)!=0)
+	{
+		perror("Error en el bloqueo del semáforo de la clasificación.\n");
+		exit(-1);
+	}
+
+		fragmento->version++; // Impar: el coordinador no se fía de lo que lea hasta que vuelva a ser par.
+		__sync_synchronize();
+
+		fragmento->levantamientos++;
+
+		// Se mete en su sitio de la clasificación parcial.
+		for (i=0; i<fragmento->numClasificados && !vaDelante(puntuacion, fin, dorsal, fragmento->puntuacion[i], fragmento->fin[i], fragmento->dorsal[i]); i++);
+		if (i<TOPFRAGMENTO)
+		{
+			if (fragmento->numClasificados<TOPFRAGMENTO) fragmento->numClasificados++;
+			for (j=fragmento->numClasificados-1; j>i; j--)
+			{
+				fragmento->dorsal[j] = fragmento->dorsal[j-1];
+				fragmento->puntuacion[j] = fragmento->puntuacion[j-1];
+				fragmento->fin[j] = fragmento->fin[j-1];
+			}
+			fragmento->dorsal[i] = dorsal;
+			fragmento->puntuacion[i] = puntuacion;
+			fragmento->fin[i] = fin;
+		}
+
+		__sync_synchronize();
+		fragmento->version++;
+
+	if (pthread_mutex_unlock(&semaforo_clasificacion)!=0)
+	{
+		perror("Error en el desbloqueo del semáforo de la clasificación.\n");
+		exit(-1);
+	}
+}
+
+
+void leeFragmento (struct fragmentoCompartido *fragmento, struct fragmentoCompartido *copia)
+{
+	volatile uint32_t *version = &fragmento->version;
+	uint32_t antes;
+
+	// Se repite la copia mientras el fragmento esté a mitad de un cambio.
+	do
+	{
+		antes = *version;
+		__sync_synchronize();
+		memcpy(copia, fragmento, sizeof(struct fragmentoCompartido));
+		__sync_synchronize();
+	}while ((antes & 1)!=0 || antes!=*version);
+}
+
+
+int fragmentoMenosCargado (struct zonaFragmentos *zona, int *pendientes)
+{
+	struct fragmentoCompartido *f;
+	int64_t carga;
+	int64_t menor = -1;
+	int elegido = 0;
+	int i;
+
+	// La carga es la parte ocupada de los huecos contando las inscripciones que aún no ha leído.
+	for (i=0; i<zona->numFragmentos; i++)
+	{
+		f = &zona->fragmentos[i];
+		if (f->capacidad<=0) continue;
+
+		carga = (int64_t)(f->ocupados + pendientes[i] - f->recibidos)*1000000/f->capacidad;
+		if (menor==-1 || carga<menor)
+		{
+			menor = carga;
+			elegido = i;
+		}
+	}
+	return elegido;
+}
+
+
+int comparaClasificados (const void *a, const void *b)
+{
+	const struct clasificado *x = (const struct clasificado*)a;
+	const struct clasificado *y = (const struct clasificado*)b;
+
+	if (vaDelante(x->puntuacion, x->fin, x->dorsal, y->puntuacion, y->fin, y->dorsal)) return -1;
+	return vaDelante(y->puntuacion, y->fin, y->dorsal, x->puntuacion, x->fin, x->dorsal);
+}
+
+
+int mezclaClasificacion (struct zonaFragmentos *zona, int *dorsales, int *puntuaciones, int cuantos)
+{
+	struct clasificado todos[MAXFRAGMENTOS*TOPFRAGMENTO];
+	struct fragmentoCompartido copia;
+	int n = 0;
+	int i;
+	int j;
+
+	// Los mejores de todo el campeonato están entre los mejores de cada fragmento.
+	for (i=0; i<zona->numFragmentos; i++)
+	{
+		leeFragmento(&zona->fragmentos[i], &copia);
+		for (j=0; j<copia.numClasificados; j++)
+		{
+			todos[n].dorsal = copia.dorsal[j];
+			todos[n].puntuacion = copia.puntuacion[j];
+			todos[n].fin = copia.fin[j];
+			n++;
+		}
+	}
+	qsort(todos, n, sizeof(struct clasificado), comparaClasificados);
+
+	if (n>cuantos) n = cuantos;
+	for (i=0; i<n; i++)
+	{
+		dorsales[i] = todos[i].dorsal;
+		puntuaciones[i] = todos[i].puntuacion;
+	}
+	return n;
+}
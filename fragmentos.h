@@ -0,0 +1,60 @@
+#ifndef FRAGMENTOS_H
+#define FRAGMENTOS_H
+
+#include <stdint.h>
+
+
+/*
+ * Campeonato repartido entre varios procesos (fragmentos). Cada fragmento lleva sus propias tarimas y atletas, y el
+ * coordinador manda cada inscripción al que esté menos cargado. Todos publican su carga y su clasificación parcial en
+ * una zona de memoria compartida POSIX, de donde el coordinador saca el podio y la clasificación de todo el campeonato.
+ */
+
+
+// Definición de constantes.
+#define MAXFRAGMENTOS 64
+#define TOPFRAGMENTO 10 // Mejores levantamientos que publica cada fragmento.
+#define FORMATO_ZONA_FRAGMENTOS "/powerlifting-%d" // Nombre de la memoria compartida (con el pid del coordinador).
+
+
+
+/* Estructuras de la memoria compartida (todos los campos son de ancho fijo). */
+
+
+// Lo que publica cada fragmento. Sólo escribe el propio fragmento; el coordinador lee.
+struct fragmentoCompartido
+{
+	int32_t pid;
+	int32_t capacidad; // Huecos para atletas.
+	int32_t ocupados; // Huecos ocupados ahora mismo.
+	int32_t recibidos; // Inscripciones que ya ha leído de su tubería.
+	int32_t inscritos;
+	int32_t levantamientos;
+	uint32_t version; // Impar mientras se está cambiando la clasificación (el lector repite la copia).
+	int32_t numClasificados;
+	int32_t dorsal[TOPFRAGMENTO]; // Clasificación parcial, de mayor a menor puntuación.
+	int32_t puntuacion[TOPFRAGMENTO];
+	int64_t fin[TOPFRAGMENTO]; // Hora a la que acabó cada levantamiento (desempata).
+};
+
+struct zonaFragmentos
+{
+	int32_t numFragmentos;
+	struct fragmentoCompartido fragmentos[MAXFRAGMENTOS];
+};
+
+
+
+/* Declaración de las funciones. */
+
+
+struct zonaFragmentos *creaZonaFragmentos(char *nombre, int numFragmentos); // NULL si no se puede crear.
+void borraZonaFragmentos(char *nombre, struct zonaFragmentos *zona);
+
+int vaDelante(int puntuacion, int64_t fin, int dorsal, int otraPuntuacion, int64_t otroFin, int otroDorsal); // Orden de toda clasificación: más puntos y, si empatan, el último en acabar (y el dorsal más alto).
+void apuntaLevantamiento(struct fragmentoCompartido *fragmento, int dorsal, int puntuacion, int64_t fin);
+void leeFragmento(struct fragmentoCompartido *fragmento, struct fragmentoCompartido *copia); // Copia coherente aunque se esté escribiendo.
+int fragmentoMenosCargado(struct zonaFragmentos *zona, int *pendientes);
+int mezclaClasificacion(struct zonaFragmentos *zona, int *dorsales, int *puntuaciones, int cuantos); // Devuelve cuántos ha puesto.
+
+#endif
@@ -0,0 +1,625 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <signal.h>
+#include <pthread.h>
+
+#include "planificador.h"
+
+
+
+/* Declaración de las variables globales del planificador. */
+
+
+// Cada grupo tiene su semáforo, su lista y sus temporizadores: los hilos de un grupo no esperan a los de otro.
+struct grupo
+{
+	pthread_mutex_t semaforo; // Protege el montículo y la lista.
+	pthread_cond_t condicion; // Para despertar a los hilos cuando hay algo que hacer o cambia el primer temporizador.
+
+	struct tarea **monticulo; // Tareas que esperan, ordenadas por la hora a la que les toca.
+	int numMonticulo;
+	int tamMonticulo;
+
+	struct tarea *primeraLista; // Tareas listas para ejecutarse (en orden de llegada).
+	struct tarea *ultimaLista;
+
+	int activo;
+	struct colocacion colocacion;
+};
+
+struct trabajador
+{
+	pthread_t hilo;
+	int grupo;
+	int claseFallida; // Vale 1 si no se pudo poner la clase de planificación pedida (por ejemplo, sin permisos para tiempo real).
+};
+
+static struct grupo grupos[MAXGRUPOS];
+static int numGrupos = 1; // Las tareas van al general hasta que se arranca el planificador.
+static int numJueces; // Grupos de un hilo para los jueces (del 1 al numJueces).
+
+static struct trabajador *trabajadores;
+static int numTrabajadores;
+
+
+
+/* Implementación de las funciones. */
+
+
+int64_t relojMonotonico()
+{
+	struct timespec ahora;
+
+	clock_gettime(CLOCK_MONOTONIC, &ahora);
+	return (int64_t)ahora.tv_sec*1000000000 + ahora.tv_nsec;
+}
+
+
+int numeroNucleos()
+{
+	long nucleos = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return (nucleos>0) ? (int)nucleos : 1;
+}
+
+
+void iniciaColocacion (struct colocacion *colocacion, int hilos)
+{
+	colocacion->hilos = hilos;
+	CPU_ZERO(&colocacion->nucleos);
+	colocacion->pila = 0;
+	colocacion->politica = SCHED_OTHER;
+	colocacion->prioridad = 0;
+}
+
+
+int leeNucleos (char *texto, cpu_set_t *nucleos)
+{
+	cpu_set_t permitidos;
+	char *p = texto;
+	char *fin;
+	long desde;
+	long hasta;
+	long i;
+
+	CPU_ZERO(nucleos);
+	if (sched_getaffinity(0, sizeof(cpu_set_t), &permitidos)!=0) return -1;
+
+	while (*p!='\0')
+	{
+		desde = strtol(p, &fin, 10);
+		if (fin==p || desde<0) return -1;
+		hasta = desde;
+		p = fin;
+		if (*p=='-')
+		{
+			hasta = strtol(p+1, &fin, 10);
+			if (fin==p+1 || hasta<desde) return -1;
+			p = fin;
+		}
+		if (*p==',') p++;
+		else if (*p!='\0') return -1;
+
+		for (i=desde; i<=hasta; i++)
+		{
+			if (i>=CPU_SETSIZE || !CPU_ISSET(i, &permitidos)) return -1; // Sólo núcleos en los que puede correr el proceso.
+			CPU_SET(i, nucleos);
+		}
+	}
+	return (CPU_COUNT(nucleos)>0) ? 0 : -1;
+}
+
+
+int leeClase (char *texto, int *politica, int *prioridad)
+{
+	*prioridad = 0;
+	if (strcmp(texto, "normal")==0) *politica = SCHED_OTHER;
+	else if (strcmp(texto, "batch")==0) *politica = SCHED_BATCH;
+	else if (strcmp(texto, "idle")==0) *politica = SCHED_IDLE;
+	else if (sscanf(texto, "fifo:%d", prioridad)==1) *politica = SCHED_FIFO;
+	else if (sscanf(texto, "rr:%d", prioridad)==1) *politica = SCHED_RR;
+	else return -1;
+
+	if ((*politica==SCHED_FIFO || *politica==SCHED_RR) && (*prioridad<sched_get_priority_min(*politica) || *prioridad>sched_get_priority_max(*politica))) return -1;
+	return 0;
+}
+
+
+void iniciaTarea (struct tarea *tarea, void (*funcion)(struct tarea *tarea), void *datos)
+{
+	tarea->funcion = funcion;
+	tarea->datos = datos;
+	tarea->cuando = 0;
+	tarea->posicion = -1;
+	tarea->enLista = 0;
+	tarea->ejecutando = 0;
+	tarea->pendiente = -1;
+	tarea->grupo = GRUPO_GENERAL;
+	tarea->siguiente = NULL;
+}
+
+
+static void intercambia (struct grupo *g, int a, int b)
+{
+	struct tarea *t = g->monticulo[a];
+
+	g->monticulo[a] = g->monticulo[b];
+	g->monticulo[b] = t;
+	g->monticulo[a]->posicion = a;
+	g->monticulo[b]->posicion = b;
+}
+
+
+static void sube (struct grupo *g, int i)
+{
+	while (i>0 && g->monticulo[(i-1)/2]->cuando>g->monticulo[i]->cuando)
+	{
+		intercambia(g, i, (i-1)/2);
+		i = (i-1)/2;
+	}
+}
+
+
+static void baja (struct grupo *g, int i)
+{
+	int menor;
+
+	while (1)
+	{
+		menor = i;
+		if (2*i+1<g->numMonticulo && g->monticulo[2*i+1]->cuando<g->monticulo[menor]->cuando) menor = 2*i+1;
+		if (2*i+2<g->numMonticulo && g->monticulo[2*i+2]->cuando<g->monticulo[menor]->cuando) menor = 2*i+2;
+		if (menor==i) return;
+
+		intercambia(g, i, menor);
+		i = menor;
+	}
+}
+
+
+static void meteMonticulo (struct grupo *g, struct tarea *tarea)
+{
+	if (g->numMonticulo==g->tamMonticulo)
+	{
+		g->tamMonticulo = (g->tamMonticulo==0) ? 256 : 2*g->tamMonticulo;
+		g->monticulo = (struct tarea**)realloc(g->monticulo, sizeof(struct tarea*)*g->tamMonticulo);
+		if (g->monticulo==NULL)
+		{
+			perror("Error al reservar memoria para los temporizadores.\n");
+			exit(-1);
+		}
+	}
+
+	g->monticulo[g->numMonticulo] = tarea;
+	tarea->posicion = g->numMonticulo;
+	g->numMonticulo++;
+	sube(g, g->numMonticulo-1);
+}
+
+
+static void quitaMonticulo (struct grupo *g, struct tarea *tarea)
+{
+	int i = tarea->posicion;
+
+	g->numMonticulo--;
+	if (i!=g->numMonticulo)
+	{
+		g->monticulo[i] = g->monticulo[g->numMonticulo];
+		g->monticulo[i]->posicion = i;
+		sube(g, i);
+		baja(g, g->monticulo[i]->posicion);
+	}
+	tarea->posicion = -1;
+}
+
+
+static void meteLista (struct grupo *g, struct tarea *tarea)
+{
+	tarea->siguiente = NULL;
+	tarea->enLista = 1;
+	if (g->ultimaLista==NULL) g->primeraLista = tarea;
+	else g->ultimaLista->siguiente = tarea;
+	g->ultimaLista = tarea;
+}
+
+
+static void quitaLista (struct grupo *g, struct tarea *tarea)
+{
+	struct tarea *anterior = NULL;
+	struct tarea *t = g->primeraLista;
+
+	while (t!=NULL && t!=tarea)
+	{
+		anterior = t;
+		t = t->siguiente;
+	}
+	if (t==NULL) return;
+
+	if (anterior==NULL) g->primeraLista = t->siguiente;
+	else anterior->siguiente = t->siguiente;
+	if (g->ultimaLista==t) g->ultimaLista = anterior;
+	t->enLista = 0;
+}
+
+
+static void *accionesTrabajador (void *arg)
+{
+	struct grupo *g = &grupos[((struct trabajador*)arg)->grupo];
+	struct tarea *tarea;
+	struct timespec limite;
+	int64_t ahora;
+
+	if (pthread_mutex_lock(&g->semaforo)!=0)
+	{
+		perror("Error en el bloqueo del semáforo del planificador.\n");
+		exit(-1);
+	}
+
+	while (g->activo==1)
+	{
+		// Se pasan a la lista las tareas cuya hora ya ha llegado.
+		ahora = relojMonotonico();
+		while (g->numMonticulo>0 && g->monticulo[0]->cuando<=ahora)
+		{
+			tarea = g->monticulo[0];
+			quitaMonticulo(g, tarea);
+			meteLista(g, tarea);
+		}
+
+		if (g->primeraLista!=NULL)
+		{
+			tarea = g->primeraLista;
+			g->primeraLista = tarea->siguiente;
+			if (g->primeraLista==NULL) g->ultimaLista = NULL;
+			tarea->enLista = 0;
+			tarea->ejecutando = 1;
+			tarea->pendiente = -1;
+			if (g->primeraLista!=NULL) pthread_cond_signal(&g->condicion); // Que otro hilo coja la siguiente.
+
+			// El paso se ejecuta sin el semáforo; lo que se programe mientras tanto se aplica al acabar, así nunca se ejecuta en dos hilos a la vez.
+			pthread_mutex_unlock(&g->semaforo);
+			tarea->funcion(tarea);
+			pthread_mutex_lock(&g->semaforo);
+
+			tarea->ejecutando = 0;
+			if (tarea->pendiente>=0)
+			{
+				tarea->cuando = tarea->pendiente;
+				tarea->pendiente = -1;
+				if (tarea->cuando<=relojMonotonico()) meteLista(g, tarea);
+				else meteMonticulo(g, tarea);
+			}
+		}
+		else if (g->numMonticulo>0)
+		{
+			limite.tv_sec = g->monticulo[0]->cuando/1000000000;
+			limite.tv_nsec = g->monticulo[0]->cuando%1000000000;
+			pthread_cond_timedwait(&g->condicion, &g->semaforo, &limite);
+		}
+		else
+		{
+			pthread_cond_wait(&g->condicion, &g->semaforo);
+		}
+	}
+
+	if (pthread_mutex_unlock(&g->semaforo)!=0)
+	{
+		perror("Error en el desbloqueo del semáforo del planificador.\n");
+		exit(-1);
+	}
+	return NULL;
+}
+
+
+static void iniciaGrupo (int numero, struct colocacion *colocacion)
+{
+	struct grupo *g = &grupos[numero];
+	pthread_condattr_t atributos;
+
+	memset(g, 0, sizeof(struct grupo));
+	g->colocacion = *colocacion;
+	g->activo = 1;
+
+	if (pthread_mutex_init(&g->semaforo, NULL)!=0)
+	{
+		perror("Error en la creación del semáforo del planificador.\n");
+		exit(-1);
+	}
+
+	pthread_condattr_init(&atributos);
+	pthread_condattr_setclock(&atributos, CLOCK_MONOTONIC); // Los temporizadores van con el reloj monotónico.
+	if (pthread_cond_init(&g->condicion, &atributos)!=0)
+	{
+		perror("Error en la creación de la condición del planificador.\n");
+		exit(-1);
+	}
+	pthread_condattr_destroy(&atributos);
+}
+
+
+static void lanzaTrabajador (int numero, struct colocacion *colocacion, cpu_set_t *nucleos)
+{
+	struct trabajador *t = &trabajadores[numTrabajadores];
+	struct sched_param parametros;
+	pthread_attr_t atributos;
+
+	t->grupo = numero;
+	t->claseFallida = 0;
+
+	pthread_attr_init(&atributos);
+	if (colocacion->pila>0 && pthread_attr_setstacksize(&atributos, colocacion->pila)!=0)
+	{
+		perror("Error en el tamaño de la pila de los hilos del planificador.\n");
+		exit(-1);
+	}
+	if (CPU_COUNT(nucleos)>0) pthread_attr_setaffinity_np(&atributos, sizeof(cpu_set_t), nucleos); // Desde el principio, sin pasar por otros núcleos.
+
+	if (pthread_create(&t->hilo, &atributos, accionesTrabajador, (void*)t)!=0)
+	{
+		perror("Error en la creación de los hilos del planificador.\n");
+		exit(-1);
+	}
+	pthread_attr_destroy(&atributos);
+
+	// La clase de tiempo real suele necesitar permisos: si no se puede, el hilo sigue con la normal y se dice en el informe.
+	if (colocacion->politica!=SCHED_OTHER)
+	{
+		parametros.sched_priority = colocacion->prioridad;
+		if (pthread_setschedparam(t->hilo, colocacion->politica, &parametros)!=0) t->claseFallida = 1;
+	}
+	numTrabajadores++;
+}
+
+
+void iniciaPlanificador (int hilos)
+{
+	struct colocacion general;
+
+	iniciaColocacion(&general, hilos);
+	iniciaPlanificadorColocado(&general, NULL);
+}
+
+
+void iniciaPlanificadorColocado (struct colocacion *general, struct colocacion *jueces)
+{
+	struct colocacion colocacionGeneral = *general;
+	cpu_set_t todos;
+	cpu_set_t uno;
+	sigset_t todas;
+	sigset_t anteriores;
+	int nucleo = -1;
+	int i;
+
+	numJueces = (jueces!=NULL) ? jueces->hilos : 0;
+	if (numJueces>MAXHILOSJUECES) numJueces = MAXHILOSJUECES;
+	numGrupos = 1+numJueces;
+
+	// Sin núcleos propios el grupo general se queda fuera de los de los jueces (si le queda alguno).
+	if (numJueces>0 && CPU_COUNT(&colocacionGeneral.nucleos)==0 && CPU_COUNT(&jueces->nucleos)>0 && sched_getaffinity(0, sizeof(cpu_set_t), &todos)==0)
+	{
+		for (i=0; i<CPU_SETSIZE; i++)
+		{
+			if (CPU_ISSET(i, &jueces->nucleos)) CPU_CLR(i, &todos);
+		}
+		if (CPU_COUNT(&todos)>0) colocacionGeneral.nucleos = todos;
+	}
+
+	// El hilo que arranca el planificador (el principal) también se queda en los núcleos del grupo general.
+	if (CPU_COUNT(&colocacionGeneral.nucleos)>0) pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &colocacionGeneral.nucleos);
+
+	// Los hilos del planificador no atienden señales: así los manejadores nunca interrumpen a un hilo que tenga el semáforo.
+	sigfillset(&todas);
+	pthread_sigmask(SIG_BLOCK, &todas, &anteriores);
+
+	trabajadores = (struct trabajador*)malloc(sizeof(struct trabajador)*(colocacionGeneral.hilos+numJueces));
+	numTrabajadores = 0;
+
+	iniciaGrupo(GRUPO_GENERAL, &colocacionGeneral);
+	for (i=0; i<colocacionGeneral.hilos; i++)
+	{
+		lanzaTrabajador(GRUPO_GENERAL, &colocacionGeneral, &colocacionGeneral.nucleos);
+	}
+
+	// Cada hilo de jueces se fija a uno de sus núcleos, por turnos.
+	for (i=0; i<numJueces; i++)
+	{
+		iniciaGrupo(1+i, jueces);
+		CPU_ZERO(&uno);
+		if (CPU_COUNT(&jueces->nucleos)>0)
+		{
+			do
+			{
+				nucleo = (nucleo+1)%CPU_SETSIZE;
+			}while (!CPU_ISSET(nucleo, &jueces->nucleos));
+			CPU_SET(nucleo, &uno);
+		}
+		lanzaTrabajador(1+i, jueces, &uno);
+	}
+
+	pthread_sigmask(SIG_SETMASK, &anteriores, NULL);
+}
+
+
+int grupoJuez (int numero)
+{
+	if (numJueces==0) return GRUPO_GENERAL;
+	return 1 + (numero-1)%numJueces;
+}
+
+
+void asignaGrupo (struct tarea *tarea, int grupo)
+{
+	tarea->grupo = (grupo>=0 && grupo<numGrupos) ? grupo : GRUPO_GENERAL;
+}
+
+
+static int escribeNucleos (char *texto, int tam, cpu_set_t *nucleos)
+{
+	int longitud = 0;
+	int desde;
+	int i;
+
+	for (i=0; i<CPU_SETSIZE && longitud<tam-16; i++)
+	{
+		if (!CPU_ISSET(i, nucleos)) continue;
+
+		desde = i;
+		while (i+1<CPU_SETSIZE && CPU_ISSET(i+1, nucleos)) i++;
+		if (desde==i) longitud += snprintf(texto+longitud, tam-longitud, "%s%d", longitud>0 ? "," : "", desde);
+		else longitud += snprintf(texto+longitud, tam-longitud, "%s%d-%d", longitud>0 ? "," : "", desde, i);
+	}
+	return longitud;
+}
+
+
+int describeHilo (int hilo, char *texto, int tam)
+{
+	struct trabajador *t;
+	struct sched_param parametros;
+	pthread_attr_t atributos;
+	cpu_set_t nucleos;
+	size_t pila = 0;
+	int politica = SCHED_OTHER;
+	char lista[256];
+	char clase[32];
+
+	if (hilo<0 || hilo>=numTrabajadores) return 0;
+	t = &trabajadores[hilo];
+
+	// Se cuenta lo que tiene de verdad el hilo, no lo que se pidió.
+	CPU_ZERO(&nucleos);
+	pthread_getaffinity_np(t->hilo, sizeof(cpu_set_t), &nucleos);
+	escribeNucleos(lista, sizeof(lista), &nucleos);
+	if (pthread_getattr_np(t->hilo, &atributos)==0)
+	{
+		pthread_attr_getstacksize(&atributos, &pila);
+		pthread_attr_destroy(&atributos);
+	}
+	parametros.sched_priority = 0;
+	pthread_getschedparam(t->hilo, &politica, &parametros);
+
+	if (politica==SCHED_FIFO) snprintf(clase, sizeof(clase), "fifo:%d", parametros.sched_priority);
+	else if (politica==SCHED_RR) snprintf(clase, sizeof(clase), "rr:%d", parametros.sched_priority);
+	else if (politica==SCHED_BATCH) snprintf(clase, sizeof(clase), "batch");
+	else if (politica==SCHED_IDLE) snprintf(clase, sizeof(clase), "idle");
+	else snprintf(clase, sizeof(clase), "normal");
+
+	if (t->grupo==GRUPO_GENERAL) snprintf(texto, tam, "General, %s %s, pila de %d KB, clase %s%s.", CPU_COUNT(&nucleos)==1 ? "núcleo" : "núcleos", lista, (int)(pila/1024), clase, t->claseFallida ? " (no se ha podido cambiar)" : "");
+	else snprintf(texto, tam, "Jueces %d, %s %s, pila de %d KB, clase %s%s.", t->grupo, CPU_COUNT(&nucleos)==1 ? "núcleo" : "núcleos", lista, (int)(pila/1024), clase, t->claseFallida ? " (no se ha podido cambiar)" : "");
+	return 1;
+}
+
+
+void programaTarea (struct tarea *tarea, int64_t retraso)
+{
+	struct grupo *g = &grupos[tarea->grupo];
+
+	if (pthread_mutex_lock(&g->semaforo)!=0)
+	{
+		perror("Error en el bloqueo del semáforo del planificador.\n");
+		exit(-1);
+	}
+
+		if (tarea->ejecutando==1)
+		{
+			tarea->pendiente = relojMonotonico()+(retraso>0 ? retraso : 0); // Lo aplica el hilo que la ejecuta cuando acabe el paso.
+		}
+		else if (tarea->enLista==1 && retraso<=0)
+		{
+			// Ya está lista: se queda en su sitio de la lista.
+		}
+		else
+		{
+			if (tarea->posicion>=0) quitaMonticulo(g, tarea);
+			if (tarea->enLista==1) quitaLista(g, tarea);
+
+			if (retraso<=0)
+			{
+				meteLista(g, tarea);
+				pthread_cond_signal(&g->condicion);
+			}
+			else
+			{
+				tarea->cuando = relojMonotonico()+retraso;
+				meteMonticulo(g, tarea);
+				if (tarea->posicion==0) pthread_cond_signal(&g->condicion); // Hay un temporizador más cercano.
+			}
+		}
+
+	if (pthread_mutex_unlock(&g->semaforo)!=0)
+	{
+		perror("Error en el desbloqueo del semáforo del planificador.\n");
+		exit(-1);
+	}
+}
+
+
+int cancelaTarea (struct tarea *tarea)
+{
+	struct grupo *g = &grupos[tarea->grupo];
+	int cancelada = 0;
+
+	if (pthread_mutex_lock(&g->semaforo)!=0)
+	{
+		perror("Error en el bloqueo del semáforo del planificador.\n");
+		exit(-1);
+	}
+
+		if (tarea->posicion>=0)
+		{
+			quitaMonticulo(g, tarea);
+			cancelada = 1;
+		}
+		else if (tarea->enLista==1)
+		{
+			quitaLista(g, tarea);
+			cancelada = 1;
+		}
+		else if (tarea->ejecutando==1 && tarea->pendiente>=0)
+		{
+			tarea->pendiente = -1; // El paso que se está ejecutando ya no se repite.
+			cancelada = 1;
+		}
+
+	if (pthread_mutex_unlock(&g->semaforo)!=0)
+	{
+		perror("Error en el desbloqueo del semáforo del planificador.\n");
+		exit(-1);
+	}
+	return cancelada;
+} // Si la tarea se está ejecutando y todavía no se ha vuelto a programar devuelve 0.
+
+
+void paraPlanificador()
+{
+	int i;
+
+	for (i=0; i<numGrupos; i++)
+	{
+		pthread_mutex_lock(&grupos[i].semaforo);
+		grupos[i].activo = 0;
+		pthread_cond_broadcast(&grupos[i].condicion);
+		pthread_mutex_unlock(&grupos[i].semaforo);
+	}
+
+	for (i=0; i<numTrabajadores; i++)
+	{
+		pthread_join(trabajadores[i].hilo, NULL);
+	}
+	free(trabajadores);
+	numTrabajadores = 0;
+
+	for (i=0; i<numGrupos; i++)
+	{
+		free(grupos[i].monticulo);
+		pthread_mutex_destroy(&grupos[i].semaforo);
+		pthread_cond_destroy(&grupos[i].condicion);
+		memset(&grupos[i], 0, sizeof(struct grupo));
+	}
+	numGrupos = 1;
+	numJueces = 0;
+}
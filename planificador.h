@@ -0,0 +1,73 @@
+#ifndef PLANIFICADOR_H
+#define PLANIFICADOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sched.h> // cpu_set_t (hace falta _GNU_SOURCE antes del primer include).
+
+
+/*
+ * Planificador compartido: unos pocos hilos (por defecto uno por núcleo) ejecutan los pasos de todas las tareas
+ * de todos los campeonatos, y un montículo de temporizadores guarda las que esperan a una hora concreta.
+ *
+ * Los hilos van por grupos, cada uno con su lista y sus temporizadores. El grupo 0 es el general; si se piden hilos
+ * para los jueces, cada uno es un grupo de un solo hilo fijado a un núcleo y cada tarima va siempre al mismo.
+ */
+
+
+// Definición de constantes.
+#define GRUPO_GENERAL 0
+#define MAXHILOSJUECES 64
+#define MAXGRUPOS (1+MAXHILOSJUECES)
+
+
+// Tarea que ejecutan los hilos del planificador. Cada llamada a funcion es un paso corto que no se bloquea;
+// si la tarea tiene que seguir, la propia función vuelve a programarla (o la despierta otra tarea con programaTarea).
+// Una tarea nunca se ejecuta en dos hilos a la vez y su memoria tiene que durar hasta paraPlanificador.
+struct tarea
+{
+	void (*funcion)(struct tarea *tarea);
+	void *datos;
+	int64_t cuando; // Hora del reloj monotónico (en nanosegundos) a la que toca ejecutarla.
+	int posicion; // Posición en el montículo de temporizadores (-1 si no está).
+	int enLista; // Vale 1 si está en la lista de tareas listas para ejecutarse.
+	int ejecutando; // Vale 1 mientras un hilo ejecuta su paso.
+	int64_t pendiente; // Hora a la que se ha programado mientras se ejecutaba (-1 si no), se aplica al acabar el paso.
+	int grupo; // Grupo de hilos que la ejecuta.
+	struct tarea *siguiente;
+};
+
+
+// Dónde y cómo corren los hilos de un grupo.
+struct colocacion
+{
+	int hilos;
+	cpu_set_t nucleos; // Núcleos permitidos (vacío: los del proceso).
+	size_t pila; // Bytes de pila (0: la del sistema).
+	int politica; // SCHED_OTHER, SCHED_BATCH, SCHED_IDLE, SCHED_FIFO o SCHED_RR.
+	int prioridad; // Sólo para SCHED_FIFO y SCHED_RR.
+};
+
+
+
+/* Declaración de las funciones. */
+
+
+int64_t relojMonotonico();
+int numeroNucleos();
+
+void iniciaColocacion(struct colocacion *colocacion, int hilos); // Sin fijar núcleos y con la pila y la clase del sistema.
+int leeNucleos(char *texto, cpu_set_t *nucleos); // Lista del tipo 0-3,6; devuelve -1 si no es válida.
+int leeClase(char *texto, int *politica, int *prioridad); // normal, batch, idle, fifo:P o rr:P; devuelve -1 si no es válida.
+
+void iniciaTarea(struct tarea *tarea, void (*funcion)(struct tarea *tarea), void *datos);
+void iniciaPlanificador(int hilos);
+void iniciaPlanificadorColocado(struct colocacion *general, struct colocacion *jueces); // jueces puede ser NULL.
+int grupoJuez(int numero); // Grupo que ejecuta al juez de la tarima numero (el general si no hay hilos de jueces).
+void asignaGrupo(struct tarea *tarea, int grupo); // Antes de programarla por primera vez.
+int describeHilo(int hilo, char *texto, int tam); // Devuelve 0 cuando ya no hay más hilos.
+void programaTarea(struct tarea *tarea, int64_t retraso); // Retraso en nanosegundos (0 para ejecutarla ya); sustituye a lo que tuviera programado.
+int cancelaTarea(struct tarea *tarea); // Devuelve 1 si estaba programada y se ha quitado.
+void paraPlanificador();
+
+#endif
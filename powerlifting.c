@@ -1,3 +1,4 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -7,1089 +8,3275 @@
 #include <time.h>
 #include <signal.h>
 #include <pthread.h>
+#include <sched.h>
 #include <sys/syscall.h>
-#include <ctype.h> 
+#include <ctype.h>
+#include <getopt.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <errno.h>
+
+#include "resultados.h"
+#include "planificador.h"
+#include "fragmentos.h"
+#include "aleatorios.h"
+#include "sucesos.h"
+#include "carga.h"
+#include "durabilidad.h"
+#include "columnas.h"
 
 
 // Definición de constantes.
 #define MAXIMOATLETAS 10
 #define NUMEROTARIMAS 2
 
+#define MAXCAMPEONATOS 256 // Campeonatos que puede llevar a la vez el modo anfitrión.
+#define TAMNOMBRE 256
+#define FORMATO_LOG_CAMPEONATO "registroTiempos-%d.log" // Log de cada campeonato en el modo anfitrión.
+#define FORMATO_LOG_FRAGMENTO "registroTiempos-fragmento-%d.log" // Log de cada proceso cuando el campeonato se reparte.
+#define FORMATO_DATOS_FRAGMENTO "resultados-%d.dat" // Almacén de resultados de cada fragmento.
+#define FORMATO_INDICE_FRAGMENTO "resultados-%d.idx"
+#define FORMATO_DORSALES_FRAGMENTO "resultados-%d.dor"
+#define FORMATO_TARIMAS_FRAGMENTO "resultados-%d.tar"
+#define FORMATO_COLUMNAS_CAMPEONATO "levantamientos-%d.col" // Exportación en columnas de cada campeonato en el modo anfitrión.
+#define FORMATO_COLUMNAS_FRAGMENTO "levantamientos-fragmento-%d.col"
+
+#define TAMHORA 64 // Tamaño de la hora que encabeza cada mensaje del log.
+
+// Formatos de la hora del log.
+#define HORA_LOCAL 0 // Día y hora local con microsegundos.
+#define HORA_ISO 1 // ISO-8601 con nanosegundos y zona horaria.
+#define HORA_NS 2 // Nanosegundos desde la época.
+
+// Mensajes que se escriben en pantalla y en el log (índices de la tabla de plantillas).
+#define EVENTO_ENTRA_TARIMA 0
+#define EVENTO_DESHIDRATADO 1
+#define EVENTO_CALIENTA 2
+#define EVENTO_FINALIZA 3
+#define EVENTO_APRIETA_BOTON 4
+#define EVENTO_SIN_FUERZA_FUENTE 5
+#define EVENTO_HA_BEBIDO 6
+#define EVENTO_VALIDO 7
+#define EVENTO_NULO_INDUMENTARIA 8
+#define EVENTO_NULO_FUERZA 9
+#define EVENTO_NECESITA_BEBER 10
+#define EVENTO_DESCANSA 11
+#define EVENTO_FIN_DESCANSO 12
+#define EVENTO_FIN_PROGRAMA 13
+#define EVENTO_SIN_BEBER 14
+#define EVENTO_TOTAL_TARIMA 15
+#define EVENTO_PRIMERO 16
+#define EVENTO_SEGUNDO 17
+#define EVENTO_TERCERO 18
+
+#define EVENTO_PID 19
+#define EVENTO_COMIENZO 20
+#define EVENTO_SOLICITUD 21
+#define EVENTO_INSCRITO 22
+#define EVENTO_PREPARADO 23
+#define EVENTO_SIN_SITIO 24
+#define EVENTO_PULSADO_FIN 25
+#define EVENTO_RESULTADOS 26
+#define EVENTO_APLAZA_DESCANSO 27
+#define EVENTO_DESCANSOS 28
+#define EVENTO_DESCANSOS_PERDIDOS 29
+#define EVENTO_PERDIDOS_TOTAL 30
+#define EVENTO_ABRE_TARIMA 31
+#define EVENTO_CIERRA_TARIMA 32
+#define EVENTO_TARIMA_RECOGIDA 33
+#define EVENTO_CAMBIA_TARIMA 34
+#define EVENTO_TARIMAS_TOTAL 35
+#define EVENTO_CLASIFICACION 36
+#define EVENTO_FRAGMENTOS 37
+#define EVENTO_TOTAL_FRAGMENTO 38
+#define EVENTO_HILO 39 // El mensaje lo compone el planificador (se escribe con registraTexto).
+#define EVENTO_SUCESOS 40
+#define EVENTO_METRICAS_ATLETAS 41
+#define EVENTO_METRICAS_LEVANTAMIENTOS 42
+#define EVENTO_METRICAS_ESPERAS 43
+#define EVENTO_METRICAS_FUENTE 44
+#define EVENTO_ETAPAS 45
+#define EVENTO_CARGA 46
+#define EVENTO_CARGA_RITMO 47
+#define EVENTO_CARGA_RETRASO 48
+#define EVENTO_DURABILIDAD 49
+#define EVENTO_DURABILIDAD_LATENCIA 50
+#define EVENTO_COLUMNAS 51
+#define EVENTO_SIN_CONTROL 52
+#define EVENTO_CARGA_SIN_RITMO 53
+#define NUMEVENTOS 54
+
+#define MAXVALORES 2 // Números que puede llevar como mucho cada parte de un mensaje.
+#define TAMQUIEN 64
+#define TAMMENSAJE 256
+#define TAMLINEA 512
+
+// Niveles de detalle de los mensajes: cada sumidero escribe los de su nivel o menos.
+#define NIVEL_NADA 0
+#define NIVEL_ERRORES 1
+#define NIVEL_RESUMENES 2 // Comienzo, fin, totales y podio.
+#define NIVEL_EVENTOS 3 // Todo lo que hacen los atletas y los jueces.
+
+// Adónde va cada mensaje.
+#define DESTINO_CONSOLA 1
+#define DESTINO_LOG 2 // Fichero log, tuberías y syslog.
+#define DESTINO_TODOS 3
+
+// Tipos de sumidero.
+#define SUMIDERO_CONSOLA 0
+#define SUMIDERO_FICHERO 1
+#define SUMIDERO_TUBERIA 2
+#define SUMIDERO_SYSLOG 3
+
+#define MAXSUMIDEROS 8
+#define TAMSUMIDERO 65536 // Mensajes que se acumulan en cada sumidero antes de escribirlos de golpe.
+#define VACIADO_MS 100 // Cada cuánto se vacían los sumideros aunque no estén llenos.
+
+// Descansos de los jueces.
+#define DESCANSO_CADA 4 // Atletas entre dos descansos.
+#define DESCANSO_SEGUNDOS 10
+
+// Estado de cada hueco de tarima.
+#define TARIMA_CERRADA 0
+#define TARIMA_ABIERTA 1
+#define TARIMA_CERRANDO 2 // No recibe atletas nuevos y el juez se va cuando acaba con el que tiene.
+
+#define VENTANA_ESPERAS 64 // Esperas de cada tarima que se guardan entre dos revisiones para calcular el percentil 90.
+#define ESPERA_MINIMA_NS 1000000 // Espera real mínima de lo que se vuelve a mirar cada cierto tiempo (con --tiempo-virtual=0 no daría vueltas sin parar).
+#define ESPERA_P90 60 // Segundos de espera (percentil 90) a partir de los que se abre otra tarima.
+#define PERIODO_CONTROL 10 // Segundos entre dos revisiones de las colas.
+
+// Pasos de las tareas de los atletas.
+#define ATLETA_ENTRA 0
+#define ATLETA_EN_COLA 1 // Duerme hasta que lo llama un juez o hasta la comprobación de salud en la que se deshidrata.
+#define ATLETA_CALENTANDO 2
+#define ATLETA_ESPERA_FIN 3
+
+// Avisos entre el atleta y su juez: el que llega primero se queda dormido y el otro lo despierta.
+#define AVISO_PENDIENTE 0
+#define AVISO_HECHO 1
+#define AVISO_ESPERANDO 2
+
+// Pasos de las tareas de los jueces.
+#define JUEZ_ELIGE 0
+#define JUEZ_LLAMA 1
+#define JUEZ_ESPERA_CALENTAMIENTO 2
+#define JUEZ_PUNTUA 3
+#define JUEZ_ESPERA_DESCANSO 4 // Le toca descansar pero descansan ya demasiados jueces.
+#define JUEZ_FIN_DESCANSO 5
 
 
-/* Declaración de las variables globales. */
-
-
-int contadorAtletas; // Contador de atletas que participan a lo largo del campeonato.
-
 
-// Semáforos y condiciones.
-pthread_mutex_t semaforo_atletas; // Semáforo para la entrada de nuevos atletas.
-pthread_mutex_t semaforo_tarimas; // Semáforo para la cola de las tarimas.
-pthread_mutex_t semaforo_escribir; // Semáforo para escribir en el log.
-pthread_mutex_t semaforo_fuente; // Semáforo que controla el acceso a la fuente.
-pthread_cond_t condicion; // Condición para la fuente.
+/* Declaración de las variables globales. */
 
 
 // Estructura de punteros para la lista de atletas con sus datos.
-struct atletasCompeticion 
+struct atletasCompeticion
 {
 	int id;
 	int ha_competido;
 	int tarima_asignada;
 	int puntuacion;
 	int necesita_beber;
-	int calentamiento; // Para que espere los 4 segundos en la tarima antes de realizar el levantamiento.
-	pthread_t atleta;
+	int calentamiento; // AVISO_*: el juez espera los 4 segundos del calentamiento antes de realizar el levantamiento.
+	int levantado; // AVISO_*: el atleta espera a que el juez lo puntúe.
+	int siguienteCola; // Vecinos en la cola de su tarima (-1 si no hay).
+	int anteriorCola;
+	int64_t t_inscripcion; // Hora de inscripción para el almacén de resultados.
+	int paso; // Uno de los ATLETA_*.
+	struct campeonato *campeonato;
+	struct tarea *juez; // Tarea del juez que lo ha llamado.
+	struct tarea tarea;
 };
-struct atletasCompeticion *atletas;
 
 
 // Estructura de punteros para las tarimas con sus datos.
 struct tarimasCompeticion
 {
 	int id;
-	int descansa; // Cuenta hasta cuatro para descansar y después se pone a cero.
+	int descansa; // Cuenta los atletas desde el último descanso y después se pone a cero.
 	int contador; // Cuenta todos los atletas que han pasado por la tarima.
-	pthread_t tatami;
+	int descansos;
+	int aplazados; // Descansos que se han retrasado por tener la cola larga o por descansar ya demasiados jueces.
+	int64_t t_descanso; // Nanosegundos que ha pasado el juez descansando.
+	int estado; // Uno de los TARIMA_*.
+	int64_t t_apertura; // Hora a la que se abrió por última vez.
+	int64_t t_abierta; // Nanosegundos que ha estado abierta antes de la última apertura.
+	int64_t esperas[VENTANA_ESPERAS]; // Últimas esperas (desde la inscripción hasta que el juez lo llama) en nanosegundos.
+	int numEsperas;
+
+	// Cola de atletas esperando, por orden de dorsal (se toca con semaforo_tarimas).
+	int primeroCola;
+	int ultimoCola;
+	int enCola;
+
+	// Lo que el juez recuerda de un paso al siguiente.
+	int paso; // Uno de los JUEZ_*.
+	int atleta_cogido; // Se guarda la posición del atleta en la cola que va a entrar en la tarima.
+	int ayuda; // Vale 1 si la propia cola está vacía y se coge (o se busca) un atleta de otra tarima.
+	int ocioso; // Vale 1 si no había nadie en ninguna cola y duerme hasta que entre alguien (se toca con semaforo_tarimas).
+	int comportamiento;
+	int64_t inicioDescanso;
+	int64_t t_llamada; // Hora a la que empezó el levantamiento del atleta cogido.
+	struct campeonato *campeonato;
+	struct tarea tatami;
 };
-struct tarimasCompeticion *punteroTarimas;
 
 
-// Fichero.
-FILE *registro;
-char *nombreArchivo = "registroTiempos.log";
+// Sumideros de los mensajes (pantalla, fichero log, tuberías y syslog). Se escriben con semaforo_escribir.
+struct sumidero
+{
+	int tipo;
+	int nivel;
+	int fd;
+	FILE *tuberia; // Sólo para las tuberías (se cierran con pclose).
+	char *buffer; // Mensajes pendientes de escribir (salvo syslog, que manda cada mensaje aparte).
+	int ocupado;
+	struct registrosPendientes durables; // Mensajes que hay en el buffer y cuándo ocurrieron (para la durabilidad).
+};
 
 
-int podio[2][3]; // Matriz del podio donde se incluye tanto la puntuación como el identificador de los tres mejores atletas.
+// Lo que cuenta el suscriptor de métricas a partir de los sucesos (sólo lo toca el que reparte el bus).
+struct metricasCampeonato
+{
+	int inscritos;
+	int llamados;
+	int calentados;
+	int validos;
+	int nulos;
+	int necesitanAgua;
+	int bebidos;
+	int deshidratados;
+	int64_t esperaTotal; // Nanosegundos esperando en la cola de los que han llamado.
+	int64_t duracionTotal; // Nanosegundos de levantamiento de los puntuados.
+};
 
 
-// Variables para el número máximo de atletas y el número de tarimas.
-int maxAtletas;
-int numTarimas;
+// Todo lo que es propio de un campeonato. El modo anfitrión juega varios a la vez en el mismo proceso y con los mismos hilos.
+struct campeonato
+{
+	int numero;
+	char prefijo[32]; // Se antepone a lo que se escribe en pantalla cuando hay varios campeonatos.
+	char nombreArchivo[TAMNOMBRE];
+
+	int contadorAtletas; // Contador de atletas que participan a lo largo del campeonato.
+	int primerDorsal; // Dorsales primerDorsal, primerDorsal+saltoDorsal, ... (así no se repiten entre fragmentos).
+	int saltoDorsal;
+
+	pthread_mutex_t semaforo_atletas; // Semáforo para la entrada de nuevos atletas.
+	pthread_mutex_t semaforo_tarimas; // Semáforo para la cola de las tarimas.
+	pthread_mutex_t semaforo_escribir; // Semáforo para escribir en el log.
+	pthread_mutex_t semaforo_descansos; // Semáforo para saber cuántos jueces descansan a la vez.
+	pthread_mutex_t semaforo_huecos; // Semáforo de la pila de huecos libres.
+
+	struct atletasCompeticion *atletas;
+	int maxAtletas;
+	int *huecos; // Pila de posiciones libres de atletas (la primera en salir es la más baja al empezar).
+	int numHuecos;
+	struct tarimasCompeticion *punteroTarimas;
+	int numTarimas; // Huecos de tarima que se han usado alguna vez (abiertos, cerrándose o ya cerrados).
+
+	// Tarimas que se abren y se cierran según las colas.
+	int minTarimas; // Tarimas con las que empieza el campeonato, que no se cierran nunca.
+	int maxTarimas; // Huecos reservados en punteroTarimas.
+	int tarimasAbiertas;
+	int tarimasAbiertasTotal; // Aperturas y cierres durante el campeonato.
+	int tarimasCerradasTotal;
+	int periodosQuietos; // Revisiones seguidas sin abrir ni cerrar ninguna tarima.
+	int juecesOciosos; // Jueces dormidos hasta que alguien entre en una cola (se toca con semaforo_tarimas).
+	int64_t *esperasControl; // Hueco para ordenar las esperas al calcular el percentil 90.
+
+	int podio[2][3]; // Matriz del podio donde se incluye tanto la puntuación como el identificador de los tres mejores atletas.
+	int64_t finPodio[3]; // Hora a la que acabó cada levantamiento del podio (desempata).
+
+	// Fuente (sólo la toca su suscriptor del bus).
+	int colaFuente; // Dorsal del que espera para beber en la fuente.
+	int estadoFuente; // Bandera de la fuente para saber si está vacía (0) u ocupada (1).
+
+	int finalizar; // Bandera para finalizar cuando sea igual a 1.
+	int finPedido;
+	int pasoFin;
+
+	int juecesDescansando;
+	int64_t inicioCampeonato; // Para calcular qué parte del campeonato se ha ido en descansos.
+
+	struct sumidero sumideros[MAXSUMIDEROS];
+	int numSumideros;
+
+	struct bus bus; // Sucesos que publican atletas y jueces para el podio, las métricas y la fuente.
+	struct metricasCampeonato metricas;
+	int sinSitioCarga; // Llegadas de la carga que no han cabido (sólo las toca la tarea de la carga).
+
+	// Etapas que van detrás del bus: el log y el almacén de resultados se escriben por tandas fuera de las tarimas.
+	struct bus etapaLog;
+	struct bus etapaAlmacen;
+	struct registroLevantamiento tandaAlmacen[TAMTANDA]; // Levantamientos de la tanda del almacén que se está repartiendo.
+	int enTandaAlmacen;
+	struct registrosPendientes durablesAlmacen; // Lo mismo para la durabilidad.
+	struct exportacion exportacion; // Todos los levantamientos, para exportarlos en columnas al final (con --columnas).
+
+	int tareasVivas; // Tareas de atletas, jueces, control y vaciado que aún no han acabado.
+	struct tarea controlador;
+	struct tarea vaciado;
+	struct tarea fin;
+};
 
 
-// Fuente.
-struct atletasCompeticion colaFuente[1]; // Estructura para guardar los datos del que espera para beber en la fuente.
-int estadoFuente; // Bandera de la fuente para saber si está vacía (0) u ocupada (1).
+// Campeonatos del proceso (sólo uno si no se usa --campeonatos).
+struct campeonato *campeonatos[MAXCAMPEONATOS];
+int numCampeonatos;
+int campeonatosActivos;
+int modoAnfitrion;
+int64_t inicioEjecucion; // Identifica en el almacén los campeonatos de esta ejecución (los fragmentos la heredan del coordinador).
+int tuberiaFin[2]; // El último campeonato en terminar avisa por aquí al hilo principal.
+int numHilos; // Hilos del planificador compartido.
+struct colocacion colocacionGeneral; // Núcleos, pila y clase de los hilos del planificador.
+struct colocacion colocacionJueces; // Hilos propios de los jueces (ninguno por defecto).
 
 
-int finalizar; // Bandera para finalizar cuando sea igual a 1.
+// Campeonato repartido entre procesos (--fragmentos).
+int numFragmentos;
+int fragmento; // Número de este fragmento (0 en el coordinador o si no se reparte).
+char nombreZona[64];
+struct zonaFragmentos *zonaFragmentos; // Memoria compartida con la carga y la clasificación de cada fragmento.
+struct fragmentoCompartido *miFragmento; // Lo que publica este proceso (NULL si no es un fragmento).
+pid_t pidsFragmentos[MAXFRAGMENTOS];
+int tuberiasFragmentos[MAXFRAGMENTOS]; // Por aquí manda el coordinador las inscripciones (la tarima pedida) a cada fragmento.
+int enviados[MAXFRAGMENTOS];
+int tuberiaPedidos = -1; // Extremo de lectura en el fragmento.
 
 
+// Carga generada a partir de una traza o de un perfil de llegadas (--carga).
+struct carga carga;
+int conCarga;
 
-/* Declaración de las funciones. */
 
+// Durabilidad de los ficheros log y del almacén de resultados (--durabilidad).
+struct durabilidad durabilidad;
+int modoDurabilidad;
+int msDurabilidad;
 
-int calculaAleatorios(int min, int max);
 
-void inicializaCampeonato(int maxAtletas, int numTarimas);
-int haySitioEnCampeonato(); // Para saber si hay sitio (y si lo hay devuelve el primer hueco) para que entre un atleta a competir.
-void nuevoCompetidor(int sig); 
-void eliminaAtleta(int pos);
-void meteEnFuente(int pos);
-void finalizaCompeticion(int sig);
+// Exportación en columnas de los levantamientos de cada campeonato al final (--columnas).
+int exportaColumnas;
+
+
+// Fichero.
+char *nombreArchivo = "registroTiempos.log";
 
-void *accionesAtleta(void *arg); // El argumento que se le pasa es el atleta.
-void *accionesTarima(void *arg); // El argumento que se le pasa es la tarima.
 
-void  writeLogMessage(char *id, char *msg);
+// Lo que se pide por la terminal y vale para todos los campeonatos.
+int atletasPedidos;
+int tarimasPedidas;
+int tarimasMaximas;
 
+int nivelConsola; // Niveles de la pantalla y del fichero log.
+int nivelLog;
+char *sumiderosPedidos[MAXSUMIDEROS]; // Sumideros extra pedidos con --sumidero=NIVEL,TIPO[:DESTINO].
+int numSumiderosPedidos;
+int intervaloVaciado; // Milisegundos entre dos vaciados.
 
+int tiempoVirtual; // Microsegundos reales que dura cada segundo del campeonato (-1 para usar el tiempo real).
 
-/* Función principal. */
+
+// Descansos de los jueces.
+int descansoCada; // Atletas que juzga cada juez antes de descansar.
+int descansoDuracion; // Segundos que dura cada descanso.
+int maxDescansando; // Jueces que pueden descansar a la vez (0 sin límite).
+int colaLarga; // Con al menos tantos atletas esperando en su cola el juez aplaza el descanso (0 no se aplaza nunca).
 
 
-int main (int argc, char *argv[]) 
+// Tarimas que se abren y se cierran según las colas.
+int esperaP90; // Segundos de espera (percentil 90) a partir de los que se abre otra tarima.
+int periodoControl; // Segundos entre dos revisiones de las colas.
+
+
+// Plantillas de los mensajes: cada texto se parte al arrancar en los trozos literales que hay entre sus %d.
+struct textoPlantilla
 {
-	// Parte opcional --> Asignación estática de recursos (faltarían implementar las señales correspondientes a las tarimas añadidas).
-	maxAtletas = MAXIMOATLETAS; // Se inicializa con el máximo de atletas por defecto.
-	numTarimas = NUMEROTARIMAS; // Se inicializa con el número de tarimas por defecto.	
-	
-	
-	// Se crea el fichero log y se comprueba si hay errores.
-	registro = fopen (nombreArchivo,"w");
-	if (registro==NULL)
-	{
-		perror("Error en la creación del fichero.\n");
-		exit(-1);
-	}
-	else
-	{
-		fclose(registro); // Se cierra para guardar los datos.
-		printf("El pid del campeonato es %d.\n", getpid());
-		writeLogMessage("Árbitro", "Comienza el campeonato de levantamiento de pesas, cuidado con los pinreles."); // Aquí no se necesita semáforo porque todavía no hay hilos creados.
+	int numTrozos; // Número de %d.
+	char *trozo[MAXVALORES+1];
+	int longitud[MAXVALORES+1];
+};
 
+struct plantillaEvento
+{
+	int nivel;
+	int destino;
+	char *formatoQuien; // Quién escribe el mensaje (su %d es el dorsal o el número de juez).
+	char *formatoMensaje;
+	struct textoPlantilla quien;
+	struct textoPlantilla mensaje;
+};
 
-		// Si se introducen argumentos por la terminal el primero será para el máximo de atletas y el segundo para el número de tarimas.
-		if (argc==2) maxAtletas=atoi(argv[1]);
-		if (argc==3)
-		{
-			 maxAtletas=atoi(argv[1]);
-			 numTarimas=atoi(argv[2]);
-		}
-		
+struct plantillaEvento plantillas[NUMEVENTOS] =
+{
+	{NIVEL_EVENTOS, DESTINO_TODOS, "Atleta %d", "He entrado a la tarima %d, ¡os vais a enterar!"},
+	{NIVEL_EVENTOS, DESTINO_TODOS, "Atleta %d", "Estoy deshidratado de tanto estrés y no puedo realizar el levantamiento."},
+	{NIVEL_EVENTOS, DESTINO_TODOS, "Atleta %d", "Voy a calentar un poco los pies antes de realizar el levantamiento."},
+	{NIVEL_EVENTOS, DESTINO_TODOS, "Atleta %d", "He finalizado el levantamiento y me duelen los pies."},
+	{NIVEL_EVENTOS, DESTINO_TODOS, "Atleta %d", "Voy a beber a la fuente, pero ... ¡vaya por Dios! No me toca beber sino apretar el botón."},
+	{NIVEL_EVENTOS, DESTINO_TODOS, "Atleta %d", "Voy a beber a la fuente, pero ... ¡qué lástima! No soy capaz de apretar el botón, no tengo fuerza."},
+	{NIVEL_EVENTOS, DESTINO_TODOS, "Atleta %d", "Ya he bebido, pero el agua está caliente como en mi gimnasio."},
+	{NIVEL_EVENTOS, DESTINO_TODOS, "Juez %d", "El dorsal %d hizo un levantamiento asombroso: %d puntos."},
+	{NIVEL_EVENTOS, DESTINO_TODOS, "Juez %d", "El dorsal %d no lleva pantalones: ¡un CERO!."},
+	{NIVEL_EVENTOS, DESTINO_TODOS, "Juez %d", "El dorsal %d es un enclenque: ¡un CERO!."},
+	{NIVEL_EVENTOS, DESTINO_TODOS, "Juez %d", "Dorsal %d necesitas ir a beber a la fuente."},
+	{NIVEL_EVENTOS, DESTINO_TODOS, "Juez %d", "Esto es muy aburrido, me voy a descansar."},
+	{NIVEL_EVENTOS, DESTINO_TODOS, "Juez %d", "Ya he acabado de descansar."},
+	{NIVEL_RESUMENES, DESTINO_TODOS, "FIN DEL PROGRAMA", "Se acabó este suplicio.\n"},
+	{NIVEL_EVENTOS, DESTINO_TODOS, "Atleta %d", "Me voy sin beber así que dadme agua, pero que esté bien fresquita."},
+	{NIVEL_RESUMENES, DESTINO_TODOS, "Total atletas tarima %d", "%d"},
+	{NIVEL_RESUMENES, DESTINO_TODOS, "PRIMERA POSICIÓN", "Atleta %d con %d puntos."},
+	{NIVEL_RESUMENES, DESTINO_TODOS, "SEGUNDA POSICIÓN", "Atleta %d con %d puntos."},
+	{NIVEL_RESUMENES, DESTINO_TODOS, "TERCERA POSICIÓN", "Atleta %d con %d puntos."},
+	{NIVEL_RESUMENES, DESTINO_CONSOLA, "", "El pid del campeonato es %d."},
+	{NIVEL_RESUMENES, DESTINO_LOG, "Árbitro", "Comienza el campeonato de levantamiento de pesas, cuidado con los pinreles."},
+	{NIVEL_EVENTOS, DESTINO_CONSOLA, "", "Un atleta ha solicitado inscribirse..."},
+	{NIVEL_EVENTOS, DESTINO_CONSOLA, "", "Vas a ser inscrito, chavalote."},
+	{NIVEL_EVENTOS, DESTINO_CONSOLA, "", "El atleta %d se prepara para ir a la tarima %d."},
+	{NIVEL_ERRORES, DESTINO_CONSOLA, "", "Ya están inscritos y participando %d atletas, de momento no puedes participar."},
+	{NIVEL_RESUMENES, DESTINO_CONSOLA, "", "Has pulsado finalizar competición."},
+	{NIVEL_RESUMENES, DESTINO_CONSOLA, "", "Te mostraré los resultados."},
+	{NIVEL_EVENTOS, DESTINO_TODOS, "Juez %d", "Me toca descansar pero hay %d atletas esperando, descansaré más tarde."},
+	{NIVEL_RESUMENES, DESTINO_TODOS, "Descansos tarima %d", "%d descansos, %d aplazados."},
+	{NIVEL_RESUMENES, DESTINO_TODOS, "Descansos tarima %d", "%d por ciento del tiempo descansando, unos %d levantamientos perdidos."},
+	{NIVEL_RESUMENES, DESTINO_TODOS, "Descansos", "Se han perdido unos %d levantamientos de %d posibles."},
+	{NIVEL_RESUMENES, DESTINO_TODOS, "Árbitro", "Se abre la tarima %d: el 90 por ciento de los atletas espera hasta %d segundos."},
+	{NIVEL_RESUMENES, DESTINO_TODOS, "Árbitro", "Se cierra la tarima %d, ya no hace falta."},
+	{NIVEL_EVENTOS, DESTINO_TODOS, "Juez %d", "Tarima recogida, me voy a casa."},
+	{NIVEL_EVENTOS, DESTINO_TODOS, "Atleta %d", "Me cambian de la tarima %d a la %d."},
+	{NIVEL_RESUMENES, DESTINO_TODOS, "Tarimas", "Se han abierto %d tarimas más y se han cerrado %d."},
+	{NIVEL_RESUMENES, DESTINO_CONSOLA, "Clasificación %d", "Atleta %d con %d puntos."},
+	{NIVEL_RESUMENES, DESTINO_TODOS, "Árbitro", "Se reparten las tarimas y los atletas entre %d procesos."},
+	{NIVEL_RESUMENES, DESTINO_TODOS, "Total fragmento %d", "%d levantamientos de %d atletas inscritos."},
+	{NIVEL_RESUMENES, DESTINO_TODOS, "Hilo %d", ""},
+	{NIVEL_RESUMENES, DESTINO_TODOS, "Sucesos", "%d repartidos en %d tandas."},
+	{NIVEL_RESUMENES, DESTINO_TODOS, "Atletas", "%d inscritos, %d deshidratados esperando."},
+	{NIVEL_RESUMENES, DESTINO_TODOS, "Levantamientos", "%d válidos y %d nulos."},
+	{NIVEL_RESUMENES, DESTINO_TODOS, "Esperas", "%d ms de media en la cola y %d ms por levantamiento."},
+	{NIVEL_RESUMENES, DESTINO_TODOS, "Fuente", "%d han tenido que ir a beber y %d han bebido."},
+	{NIVEL_RESUMENES, DESTINO_TODOS, "Etapas", "%d tandas en el log y %d en el almacén de resultados."},
+	{NIVEL_RESUMENES, DESTINO_TODOS, "Carga", "%d llegadas y %d sin sitio en la competición."},
+	{NIVEL_RESUMENES, DESTINO_TODOS, "Ritmo de la carga", "%d llegadas por minuto pedidas y %d conseguidas."},
+	{NIVEL_RESUMENES, DESTINO_TODOS, "Retraso de la carga", "%d us de media y %d us como máximo."},
+	{NIVEL_RESUMENES, DESTINO_TODOS, "Durabilidad", "%d registros confirmados con %d fdatasync."},
+	{NIVEL_RESUMENES, DESTINO_TODOS, "Latencia de confirmación", "%d us de media y %d us como máximo desde cada suceso hasta el disco."},
+	{NIVEL_RESUMENES, DESTINO_TODOS, "Columnas", "%d levantamientos exportados en %d bytes."},
+	{NIVEL_RESUMENES, DESTINO_TODOS, "Árbitro", "Con --tiempo-virtual=0 las esperas no duran nada: se compite con %d tarimas y no se abren más."},
+	{NIVEL_RESUMENES, DESTINO_TODOS, "Ritmo de la carga", "no hay ritmo pedido: las %d llegadas eran en el segundo 0 y se inscribieron en %d ms del campeonato."}
+};
 
-		// Se modifican los comportamientos de las señales para inscribir a los atletas y para finalizar la competición, además de comprobar si hay error.
-		if (signal(SIGUSR1, nuevoCompetidor)==SIG_ERR) 
-		{
-			perror("Error en la llamada a la señal SIGUSR1.\n");
-			exit(-1);
-		}
-		
-		if (signal(SIGUSR2, nuevoCompetidor)==SIG_ERR) 
-		{
-			perror("Error en la llamada a la señal SIGUSR2.\n");
-			exit(-1);
-		}
-		
-		if (signal(SIGINT, finalizaCompeticion)==SIG_ERR) 
-		{
-			perror("Error en la llamada a la señal SIGINT.\n");
-			exit(-1);
-		}
+__thread char quienEvento[TAMQUIEN]; // Huecos de cada hilo donde se compone el mensaje que se va a escribir.
+__thread char mensajeEvento[TAMMENSAJE];
+__thread struct campeonato *tandaEscribiendo; // Campeonato cuyo semáforo para escribir tiene este hilo durante una tanda del log.
+__thread int64_t horaSuceso; // Cuándo se publicó el suceso que se está escribiendo en el log (0: lo que se escribe es de ahora).
 
 
-		// Se reserva espacio en memoria para los punteros de las tarimas y los atletas.
-		punteroTarimas = (struct tarimasCompeticion*)malloc(sizeof(struct tarimasCompeticion)*numTarimas);
-		atletas = (struct atletasCompeticion*)malloc(sizeof(struct atletasCompeticion)*maxAtletas);
-		
-		
-		// Se inicializan los semáforos y la condición, además de comprobar si hay errores.
-		if (pthread_mutex_init(&semaforo_atletas, NULL)!=0)
-		{
-			perror("Error en la creación del semáforo de los atletas.\n");
-			exit(-1);
-	 	}
-	 	
-	 	if (pthread_mutex_init(&semaforo_tarimas, NULL)!=0)
-		{
-			perror("Error en la creación del semáforo de las tarimas.\n");
-			exit(-1);
-	 	}
-	 	
-	 	if (pthread_mutex_init(&semaforo_fuente, NULL)!=0)
-		{
-			perror("Error en la creación del semáforo de la fuente.\n");
-			exit(-1);
-	 	}
-	 	
-	 	if (pthread_mutex_init(&semaforo_escribir, NULL)!=0)
-		{
-			perror("Error en la creación del semáforo para escribir en el fichero.\n");
-			exit(-1);
-	 	}
-	 	
-	 	if (pthread_cond_init(&condicion, NULL)!=0)
-		{
-			perror("Error en la creación de la condición.\n");
-			exit(-1);
-	 	}
-	 	
-	 	
-		// Con la función se inicializan el contador de atletas, la fuente, finalizar, el podio, los datos de los atletas y las tarimas y se crean los hilos para la tarimas.
-		inicializaCampeonato(maxAtletas, numTarimas);
+// Reloj del log.
+int formatoHora; // Uno de los formatos HORA_*.
+struct timespec relojBaseReal; // Hora real y monotónica al arrancar: las horas del log se calculan con el reloj monotónico a partir de ellas.
+struct timespec relojBaseMonotonico;
+__thread time_t segundoCacheado = -1; // Cada hilo sólo vuelve a formatear la fecha cuando cambia el segundo.
+__thread char fechaCacheada[TAMHORA];
+__thread int longitudFechaCacheada;
+__thread char zonaCacheada[8]; // Zona horaria para el formato ISO.
 
-		srand (time(NULL)); // Semilla para generar números aleatorios.
 
 
-		while (finalizar==0) // Bucle para recibir señales (permanece a la espera).
-		{
-			pause();
-		}
-	}
-	
-	return 0;	
-}
+/* Declaración de las funciones. */
 
 
+int calculaAleatorios(int min, int max);
+
+struct campeonato *creaCampeonato(int numero, int maxAtletas, int numTarimas, int maxTarimas); // Reserva el campeonato y abre sus mensajes.
+void inicializaCampeonato(struct campeonato *c); // Pone en marcha los jueces y el resto de tareas.
+void destruyeCampeonato(struct campeonato *c);
+int haySitioEnCampeonato(struct campeonato *c); // Para saber si hay sitio para que entre un atleta a competir (si lo hay lo reserva y devuelve el hueco).
+void liberaHueco(struct campeonato *c, int pos);
+void nuevoCompetidor(int sig);
+int inscribeAtleta(struct campeonato *c, int tarima); // Inscribe a un atleta en la tarima indicada (lo usan las señales, las órdenes y las pruebas de rendimiento).
+int eligeAtleta(struct campeonato *c, int numero, int *ayuda);
+void actualizaPodio(struct campeonato *c, int dorsal, int puntuacion, int64_t fin);
+int64_t tiempoCampeonato(int segundos); // Nanosegundos reales que duran esos segundos del campeonato.
+int64_t tiempoReintento(int segundos); // Lo mismo, pero nunca menos de ESPERA_MINIMA_NS.
+void terminaTarea(struct campeonato *c);
+void eliminaAtleta(struct campeonato *c, int pos);
+void meteEnCola(struct campeonato *c, int pos, int numero);
+void sacaDeCola(struct campeonato *c, int pos);
+void despiertaJueces(struct campeonato *c, int numero); // Sólo el juez de esa tarima si está ocioso, si no todos (0: todos).
+int esperaAviso(int *aviso); // Devuelve 1 si hay que dormir hasta que llegue el aviso.
+void daAviso(int *aviso, struct tarea *tarea);
+int colaTarima(struct campeonato *c, int numero);
+int pideDescanso(struct campeonato *c, int numero); // Devuelve 1 si el juez puede descansar ya, 0 si lo aplaza y 2 si tiene que esperar a que acabe otro.
+void terminaDescanso(struct campeonato *c, int numero, int64_t inicio);
+void resumeDescansos(struct campeonato *c);
+int tarimaMasCorta(struct campeonato *c); // Tarima abierta con menos atletas esperando.
+void mueveAtleta(struct campeonato *c, int pos, int destino);
+void reparteCola(struct campeonato *c, int destino);
+void vaciaTarima(struct campeonato *c, int origen);
+int64_t esperaTarima(struct campeonato *c, int numero, int64_t *esperas); // Percentil 90 de la espera en la tarima, en nanosegundos.
+int abreTarima(struct campeonato *c);
+void cierraTarima(struct campeonato *c, int numero);
+void sucesoLog(void *datos, struct suceso *suceso); // Suscriptores del bus de sucesos (los datos son el campeonato).
+void sucesoPodio(void *datos, struct suceso *suceso);
+void sucesoMetricas(void *datos, struct suceso *suceso);
+void sucesoFuente(void *datos, struct suceso *suceso);
+void sucesoAlmacen(void *datos, struct suceso *suceso);
+void abreTandaLog(void *datos); // Principio y fin de las tandas de las etapas.
+void cierraTandaLog(void *datos);
+void cierraTandaAlmacen(void *datos);
+void anunciaSuceso(struct campeonato *c, int tipo, int dorsal, int tarima, int valor); // Publica un suceso sin horas.
+void vaciaEtapas(struct campeonato *c); // Reparte lo publicado hasta ahora en el bus y en las etapas que lo siguen.
+void resumeSucesos(struct campeonato *c);
+void inscribeCarga(int tarima); // Para el generador de carga: como una señal, un atleta en cada campeonato.
+int sigueCarga();
+void acabaCarga();
+void resumeCarga(struct campeonato *c);
+void resumeDurabilidad(struct campeonato *c);
+void exportaCampeonato(struct campeonato *c);
+void finalizaCompeticion(int sig);
+void pideFinal(struct campeonato *c);
+void campeonatoTerminado();
+void ejecutaOrden(char *linea);
+void lanzaFragmentos(); // En el coordinador no vuelve: reparte las inscripciones y al final junta las clasificaciones.
+void repartoNucleosJueces(int numero); // Cada fragmento se queda con su parte de los hilos y los núcleos de los jueces.
+void asignaInscripcion(int sig);
+void terminaFragmentos(int sig);
+
+void pasoAtleta(struct tarea *tarea); // Los datos de la tarea son el atleta.
+void pasoTarima(struct tarea *tarea); // Los datos de la tarea son la tarima.
+void pasoControlador(struct tarea *tarea); // Los datos de estas tres son el campeonato.
+void pasoVaciado(struct tarea *tarea);
+void pasoFinal(struct tarea *tarea);
+
+void  writeLogMessage(struct campeonato *c, int nivel, char *id, char *msg);
+int leeNivel(char *texto);
+int abreSumideros(struct campeonato *c);
+void escribeEnSumidero(struct sumidero *destino, char *texto, int longitud);
+void vaciaSumidero(struct sumidero *destino);
+void vaciaSumideros(struct campeonato *c);
+void vaciaCampeonatos(void *datos); // Los sumideros de todos los campeonatos (antes de cada ronda de la durabilidad).
+void cierraSumideros(struct campeonato *c);
+void preparaPlantillas();
+void registraEvento(struct campeonato *c, int evento, int quien, int valor1, int valor2);
+void registraTexto(struct campeonato *c, int evento, int quien, char *texto); // Como registraEvento pero con el mensaje ya escrito.
+void registraPuntuacion(struct campeonato *c, int evento, int quien, int valor1, int valor2, int64_t fin); // Añade la hora a la que acabó el levantamiento.
+void escribeEvento(struct campeonato *c, struct plantillaEvento *plantilla); // Manda quienEvento y mensajeEvento a los sumideros.
+void iniciaReloj(int formato);
+int formateaHora(char *hora);
 
-/* Implementación de las funciones. */
 
 
-void inicializaCampeonato (int maxAtletas, int numTarimas) 
+/* Función principal. */
+
+
+#ifndef PL_SIN_MAIN // Las pruebas de rendimiento incluyen este fichero con su propio main.
+int main (int argc, char *argv[])
 {
+	int opcion;
+	int formato = HORA_LOCAL;
+	int consolaPedida = 0;
+	char linea[TAMLINEA];
+	char aviso;
+	char nombreDatos[TAMNOMBRE];
+	char nombreIndice[TAMNOMBRE];
+	char nombreDorsales[TAMNOMBRE];
+	char nombreTarimas[TAMNOMBRE];
+	struct pollfd esperas[3];
+	int numEsperas;
+	int tarima;
+	sigset_t senales;
+	sigset_t anteriores;
 	int i;
 	int j;
+	struct option opciones[] =
+	{
+		{"hora", required_argument, NULL, 'h'},
+		{"consola", required_argument, NULL, 'c'},
+		{"log", required_argument, NULL, 'l'},
+		{"sumidero", required_argument, NULL, 's'},
+		{"silencioso", no_argument, NULL, 'q'},
+		{"vaciado", required_argument, NULL, 'v'},
+		{"tiempo-virtual", required_argument, NULL, 't'},
+		{"descanso", required_argument, NULL, 'd'},
+		{"max-descansando", required_argument, NULL, 'm'},
+		{"cola-larga", required_argument, NULL, 'g'},
+		{"max-tarimas", required_argument, NULL, 'x'},
+		{"espera-p90", required_argument, NULL, 'w'},
+		{"control", required_argument, NULL, 'k'},
+		{"campeonatos", required_argument, NULL, 'n'},
+		{"hilos", required_argument, NULL, 'j'},
+		{"fragmentos", required_argument, NULL, 'f'},
+		{"nucleos", required_argument, NULL, 'u'},
+		{"hilos-jueces", required_argument, NULL, 'J'},
+		{"nucleos-jueces", required_argument, NULL, 'y'},
+		{"pila", required_argument, NULL, 'p'},
+		{"clase", required_argument, NULL, 'z'},
+		{"clase-jueces", required_argument, NULL, 'Z'},
+		{"carga", required_argument, NULL, 'a'},
+		{"durabilidad", required_argument, NULL, 'b'},
+		{"columnas", no_argument, NULL, 'o'},
+		{NULL, 0, NULL, 0}
+	};
+
+	inicioEjecucion = marcaTiempo();
 
-	contadorAtletas=0;
-	estadoFuente=0;
-	finalizar=0;
+	// Parte opcional --> Asignación estática de recursos (faltarían implementar las señales correspondientes a las tarimas añadidas).
+	atletasPedidos = MAXIMOATLETAS; // Se inicializa con el máximo de atletas por defecto.
+	tarimasPedidas = NUMEROTARIMAS; // Se inicializa con el número de tarimas por defecto.
+
+
+	nivelConsola = NIVEL_EVENTOS;
+	nivelLog = NIVEL_EVENTOS;
+	numSumiderosPedidos = 0;
+	intervaloVaciado = VACIADO_MS;
+	tiempoVirtual = -1;
+	descansoCada = DESCANSO_CADA;
+	descansoDuracion = DESCANSO_SEGUNDOS;
+	maxDescansando = 0;
+	colaLarga = 0;
+	tarimasMaximas = 0;
+	esperaP90 = ESPERA_P90;
+	periodoControl = PERIODO_CONTROL;
+	numCampeonatos = 1;
+	modoAnfitrion = 0;
+	numFragmentos = 1;
+	fragmento = 0;
+	conCarga = 0;
+	modoDurabilidad = DURABILIDAD_NADA;
+	msDurabilidad = 0;
+	exportaColumnas = 0;
+	numHilos = numeroNucleos(); // Un hilo por núcleo para todos los campeonatos.
+	iniciaColocacion(&colocacionGeneral, 0);
+	iniciaColocacion(&colocacionJueces, 0); // Sin hilos propios los jueces van con todo lo demás.
+
+
+	// Opciones: --hora=local|iso|ns elige el formato de la hora del log; --consola, --log y --sumidero eligen adónde van los mensajes y con qué nivel.
+	while ((opcion = getopt_long(argc, argv, "", opciones, NULL))!=-1)
+	{
+		if (opcion=='h' && strcmp(optarg, "local")==0) formato = HORA_LOCAL;
+		else if (opcion=='h' && strcmp(optarg, "iso")==0) formato = HORA_ISO;
+		else if (opcion=='h' && strcmp(optarg, "ns")==0) formato = HORA_NS;
+		else if (opcion=='c' && leeNivel(optarg)>=0) { nivelConsola = leeNivel(optarg); consolaPedida = 1; }
+		else if (opcion=='l' && leeNivel(optarg)>=0) nivelLog = leeNivel(optarg);
+		else if (opcion=='s' && numSumiderosPedidos<MAXSUMIDEROS-2) sumiderosPedidos[numSumiderosPedidos++] = optarg;
+		else if (opcion=='q') { nivelConsola = NIVEL_NADA; consolaPedida = 1; }
+		else if (opcion=='v' && atoi(optarg)>0) intervaloVaciado = atoi(optarg);
+		else if (opcion=='t' && atoi(optarg)>=0) tiempoVirtual = atoi(optarg);
+		else if (opcion=='d' && sscanf(optarg, "%d,%d", &descansoCada, &descansoDuracion)==2 && descansoCada>0 && descansoDuracion>=0);
+		else if (opcion=='m' && atoi(optarg)>=0) maxDescansando = atoi(optarg);
+		else if (opcion=='g' && atoi(optarg)>=0) colaLarga = atoi(optarg);
+		else if (opcion=='x' && atoi(optarg)>0) tarimasMaximas = atoi(optarg);
+		else if (opcion=='w' && atoi(optarg)>0) esperaP90 = atoi(optarg);
+		else if (opcion=='k' && atoi(optarg)>0) periodoControl = atoi(optarg);
+		else if (opcion=='n' && atoi(optarg)>0 && atoi(optarg)<=MAXCAMPEONATOS) { numCampeonatos = atoi(optarg); modoAnfitrion = 1; }
+		else if (opcion=='j' && atoi(optarg)>0) numHilos = atoi(optarg);
+		else if (opcion=='f' && atoi(optarg)>0 && atoi(optarg)<=MAXFRAGMENTOS) numFragmentos = atoi(optarg);
+		else if (opcion=='u' && leeNucleos(optarg, &colocacionGeneral.nucleos)==0);
+		else if (opcion=='J' && atoi(optarg)>=0 && atoi(optarg)<=MAXHILOSJUECES) colocacionJueces.hilos = atoi(optarg);
+		else if (opcion=='y' && leeNucleos(optarg, &colocacionJueces.nucleos)==0);
+		else if (opcion=='p' && atoi(optarg)>=64) { colocacionGeneral.pila = (size_t)atoi(optarg)*1024; colocacionJueces.pila = colocacionGeneral.pila; }
+		else if (opcion=='z' && leeClase(optarg, &colocacionGeneral.politica, &colocacionGeneral.prioridad)==0);
+		else if (opcion=='Z' && leeClase(optarg, &colocacionJueces.politica, &colocacionJueces.prioridad)==0);
+		else if (opcion=='a' && leeCarga(optarg, &carga)==0) conCarga = 1;
+		else if (opcion=='b' && leeDurabilidad(optarg, &modoDurabilidad, &msDurabilidad)==0);
+		else if (opcion=='o') exportaColumnas = 1;
+		else
+		{
+			fprintf(stderr, "Uso: %s [--hora=local|iso|ns] [--consola=NIVEL] [--log=NIVEL] [--sumidero=NIVEL,tuberia:ORDEN|syslog[:SOCKET]|fichero:NOMBRE] [--silencioso] [--vaciado=MS] [--tiempo-virtual=US] [--descanso=CADA,SEGUNDOS] [--max-descansando=M] [--cola-larga=N] [--max-tarimas=N] [--espera-p90=S] [--control=S] [--campeonatos=N] [--hilos=N] [--fragmentos=N] [--nucleos=LISTA] [--hilos-jueces=N] [--nucleos-jueces=LISTA] [--pila=KB] [--clase=CLASE] [--clase-jueces=CLASE] [--carga=CARGA] [--durabilidad=nada|periodica[:MS]|grupo[:MS]] [--columnas] [maxAtletas [numTarimas]]\n", argv[0]);
+			fprintf(stderr, "NIVEL: nada, errores, resumenes o eventos.\n");
+			fprintf(stderr, "LISTA: núcleos como 0-3,6. CLASE: normal, batch, idle, fifo:PRIORIDAD o rr:PRIORIDAD.\n");
+			fprintf(stderr, "CARGA: FICHERO con líneas SEGUNDOS [TARIMA], poisson:TASA[,SEGUNDOS] o rafagas:TASA,RAFAGA[,SEGUNDOS].\n");
+			exit(-1);
+		}
+	}
 
-	// Se inicializan los datos de los atletas.
-	for (i=0; i<maxAtletas; i++) 
+	// Si se introducen argumentos por la terminal el primero será para el máximo de atletas y el segundo para el número de tarimas.
+	if (argc-optind>=1) atletasPedidos=atoi(argv[optind]);
+	if (argc-optind>=2) tarimasPedidas=atoi(argv[optind+1]);
+	if (tarimasMaximas<tarimasPedidas) tarimasMaximas = tarimasPedidas; // Sin --max-tarimas no se abren tarimas nuevas.
+	if (colocacionJueces.hilos==0 && CPU_COUNT(&colocacionJueces.nucleos)>0) colocacionJueces.hilos = CPU_COUNT(&colocacionJueces.nucleos); // Un hilo de jueces por núcleo.
+	if ((modoAnfitrion==1 || numFragmentos>1) && consolaPedida==0) nivelConsola = NIVEL_RESUMENES; // Con muchos campeonatos a la vez la pantalla sólo lleva los resúmenes.
+	if (modoAnfitrion==1 && numFragmentos>1)
 	{
-		atletas[i].id=0;
-		atletas[i].ha_competido=0;
-		atletas[i].tarima_asignada=0;
-		atletas[i].puntuacion=0;
-		atletas[i].necesita_beber=0;
-		atletas[i].calentamiento=0;
+		fprintf(stderr, "No se pueden usar a la vez --campeonatos y --fragmentos.\n");
+		exit(-1);
+	}
+	if (conCarga==1 && numFragmentos>1)
+	{
+		fprintf(stderr, "No se pueden usar a la vez --carga y --fragmentos.\n");
+		exit(-1);
+	}
+	if (conCarga==1 && tiempoVirtual==0)
+	{
+		fprintf(stderr, "Con --tiempo-virtual=0 la carga no tiene ritmo que seguir.\n");
+		exit(-1);
 	}
 
+	iniciaReloj(formato);
+	preparaPlantillas();
+	iniciaDurabilidad(&durabilidad, modoDurabilidad, msDurabilidad, numCampeonatos*MAXSUMIDEROS+1); // Antes de dividirse, así el coordinador sincroniza su log al cerrarlo.
+	vaciaAntesDeSincronizar(&durabilidad, vaciaCampeonatos, NULL);
 
-	// Se inicializan los datos de las tarimas y se crean los hilos.
-	for (i=0; i<numTarimas; i++)
+	// Con --fragmentos el proceso se divide: aquí sólo sigue cada fragmento, con su parte de las tarimas y de los atletas.
+	if (numFragmentos>1)
 	{
-		punteroTarimas[i].id=i+1; // Se asigna el número correspondiente a cada tarima.
-		punteroTarimas[i].descansa=0;
-		punteroTarimas[i].contador=0;
-		pthread_create(&punteroTarimas[i].tatami, NULL, accionesTarima, (void*)&punteroTarimas[i].id);
+		lanzaFragmentos();
 	}
-	
-	
-	// Se inicializa el podio.
-	for (i=0; i<2; i++)
-	{	
-		for (j=0; j<3; j++)
-		{
-			podio[i][j]=0;
-		}
+
+	if (pipe(tuberiaFin)!=0)
+	{
+		perror("Error en la creación de la tubería de fin.\n");
+		exit(-1);
 	}
 
-}
 
+	// Se crean los campeonatos con su fichero log y los demás sumideros de mensajes y se comprueba si hay errores.
+	for (i=0; i<numCampeonatos; i++)
+	{
+		campeonatos[i] = creaCampeonato(i+1, atletasPedidos, tarimasPedidas, tarimasMaximas);
+		if (campeonatos[i]==NULL)
+		{
+			perror("Error en la creación del fichero.\n");
+			exit(-1);
+		}
+		registraEvento(campeonatos[i], EVENTO_PID, 0, getpid(), 0);
+		registraEvento(campeonatos[i], EVENTO_COMIENZO, 0, 0, 0);
+	}
 
-int haySitioEnCampeonato() 
-{
-	int i;
+	// Se abre el almacén donde se guardan todos los levantamientos (se añaden a los de campeonatos anteriores); cada fragmento tiene el suyo.
+	snprintf(nombreDatos, TAMNOMBRE, "%s", FICHERO_RESULTADOS);
+	snprintf(nombreIndice, TAMNOMBRE, "%s", FICHERO_INDICE);
+	snprintf(nombreDorsales, TAMNOMBRE, "%s", FICHERO_DORSALES);
+	snprintf(nombreTarimas, TAMNOMBRE, "%s", FICHERO_TARIMAS);
+	if (fragmento>0)
+	{
+		snprintf(nombreDatos, TAMNOMBRE, FORMATO_DATOS_FRAGMENTO, fragmento);
+		snprintf(nombreIndice, TAMNOMBRE, FORMATO_INDICE_FRAGMENTO, fragmento);
+		snprintf(nombreDorsales, TAMNOMBRE, FORMATO_DORSALES_FRAGMENTO, fragmento);
+		snprintf(nombreTarimas, TAMNOMBRE, FORMATO_TARIMAS_FRAGMENTO, fragmento);
+	}
+	abreResultados(nombreDatos, nombreIndice, nombreDorsales, nombreTarimas);
 
-	for (i=0; i<maxAtletas; i++) 
+	// Ficheros que se sincronizan según la durabilidad pedida: los log (y los demás sumideros a fichero) y los datos del almacén.
+	// Los índices no hacen falta: si se pierde su final, se rehacen a partir de los datos.
+	for (i=0; i<numCampeonatos; i++)
 	{
-		if (atletas[i].id==0) 
+		for (j=0; j<campeonatos[i]->numSumideros; j++)
 		{
-			return i;
+			if (campeonatos[i]->sumideros[j].tipo==SUMIDERO_FICHERO) anadeFichero(&durabilidad, campeonatos[i]->sumideros[j].fd);
 		}
 	}
-	return -1;
-} // Devuelve -1 en caso de no haber sitio y si no da el primer hueco que encuentre.
+	anadeFichero(&durabilidad, ficheroResultados());
 
 
-void nuevoCompetidor (int sig)
-{ 
-	int posicion;
-	
-	
-	if (signal(SIGUSR1, nuevoCompetidor)==SIG_ERR) 
+	// Se modifican los comportamientos de las señales para inscribir a los atletas y para finalizar la competición, además de comprobar si hay error.
+	if (signal(SIGUSR1, nuevoCompetidor)==SIG_ERR)
 	{
 		perror("Error en la llamada a la señal SIGUSR1.\n");
 		exit(-1);
 	}
-	if (signal(SIGUSR2, nuevoCompetidor)==SIG_ERR) 
+
+	if (signal(SIGUSR2, nuevoCompetidor)==SIG_ERR)
 	{
 		perror("Error en la llamada a la señal SIGUSR2.\n");
 		exit(-1);
 	}
 
-	printf("Un atleta ha solicitado inscribirse...\n");
-	
-
-	// Se bloquea el semáforo para que los atletas entren de uno en uno.
-	if (pthread_mutex_lock(&semaforo_atletas)!=0)
+	if (signal(SIGINT, finalizaCompeticion)==SIG_ERR)
 	{
-		perror("Error en el bloqueo del semáforo de los atletas.\n");
+		perror("Error en la llamada a la señal SIGINT.\n");
 		exit(-1);
 	}
 
-		// Se comprueba si hay sitio en la competición y cuál es.
-		posicion = haySitioEnCampeonato();
 
-		if(posicion!=-1) 
+	srand (time(NULL)); // Semilla para generar números aleatorios.
+	siembraAleatorios(((uint64_t)time(NULL)<<20) ^ (uint64_t)getpid()); // Los lotes de cada hilo salen de ésta; con el pid, cada fragmento sortea distinto.
+
+	// Hilos que ejecutan los pasos de todos los atletas, jueces y demás tareas; se escribe dónde ha quedado cada uno.
+	colocacionGeneral.hilos = numHilos;
+	iniciaPlanificadorColocado(&colocacionGeneral, &colocacionJueces);
+	arrancaDurabilidad(&durabilidad);
+	for (i=0; describeHilo(i, linea, TAMMENSAJE)==1; i++)
+	{
+		registraTexto(campeonatos[0], EVENTO_HILO, i+1, linea);
+	}
+
+	// Con la función se inicializan el contador de atletas, la fuente, finalizar, el podio, los datos de los atletas y las tarimas y se ponen en marcha los jueces.
+	campeonatosActivos = numCampeonatos;
+	for (i=0; i<numCampeonatos; i++)
+	{
+		inicializaCampeonato(campeonatos[i]);
+	}
+
+	// La carga empieza a la vez que los campeonatos; cuando se acaba pide el final, como si se pulsara CTRL+C.
+	if (conCarga==1)
+	{
+		arrancaCarga(&carga, tiempoCampeonato(1), tarimasPedidas, ((uint64_t)getpid()<<32) ^ (uint64_t)time(NULL), inscribeCarga, sigueCarga, acabaCarga);
+	}
+
+
+	// Se espera a que terminen todos los campeonatos (permanece a la espera de señales y, en el modo anfitrión, de órdenes por la entrada estándar;
+	// en un fragmento, de las inscripciones que manda el coordinador).
+	sigemptyset(&senales);
+	sigaddset(&senales, SIGUSR1);
+	sigaddset(&senales, SIGUSR2);
+	sigaddset(&senales, SIGINT);
+
+	esperas[0].fd = tuberiaFin[0];
+	esperas[0].events = POLLIN;
+	esperas[1].fd = (modoAnfitrion==1) ? STDIN_FILENO : -1; // Con fd negativo poll no lo mira.
+	if (modoAnfitrion==1) setvbuf(stdin, NULL, _IONBF, 0); // Sin buffer poll ve todas las órdenes, aunque lleguen varias juntas.
+	esperas[1].events = POLLIN;
+	esperas[2].fd = tuberiaPedidos;
+	esperas[2].events = POLLIN;
+	numEsperas = 3;
+
+	while (1)
+	{
+		if (poll(esperas, numEsperas, -1)<0) continue; // Interrumpido por una señal.
+
+		if ((esperas[0].revents & POLLIN)!=0 && read(tuberiaFin[0], &aviso, 1)==1) break;
+
+		if (esperas[2].fd>=0 && esperas[2].revents!=0)
 		{
-			printf("Vas a ser inscrito, chavalote.\n");
-			contadorAtletas++;
-			atletas[posicion].id=contadorAtletas;
-			atletas[posicion].puntuacion=0;
-			
-			// Según qué señal se recibe se asigna la tarima correspondiente.
-			if (sig == 10)
+			if (read(tuberiaPedidos, &tarima, sizeof(int))!=sizeof(int))
 			{
-				atletas[posicion].tarima_asignada=1;
+				esperas[2].fd = -1; // El coordinador ya no está.
+				continue;
 			}
-			else if (sig == 12)
+			inscribeAtleta(campeonatos[0], tarima);
+			__sync_fetch_and_add(&miFragmento->recibidos, 1);
+		}
+
+		if (esperas[1].fd>=0 && esperas[1].revents!=0)
+		{
+			if (fgets(linea, TAMLINEA, stdin)==NULL)
 			{
-				atletas[posicion].tarima_asignada=2;
+				esperas[1].fd = -1; // Sin más órdenes se espera a que acaben con señales.
+				continue;
 			}
 
-			atletas[posicion].ha_competido=0;
-			atletas[posicion].necesita_beber=0;
-			atletas[posicion].calentamiento=0;
-			printf("El atleta %d se prepara para ir a la tarima %d.\n", atletas[posicion].id, atletas[posicion].tarima_asignada);
-		
-			// Se crea el hilo para el atleta.
-			pthread_create(&atletas[posicion].atleta, NULL, accionesAtleta, (void *)&atletas[posicion].id);
-		} 
-		else 
-		{ 
-			printf("Ya están inscritos y participando %d atletas, de momento no puedes participar.\n", maxAtletas);
+			// Las señales esperan a que acabe la orden para no entrar dos veces en el mismo campeonato desde este hilo.
+			pthread_sigmask(SIG_BLOCK, &senales, &anteriores);
+			ejecutaOrden(linea);
+			pthread_sigmask(SIG_SETMASK, &anteriores, NULL);
 		}
+	}
 
-	// Se desbloquea el semáforo, además se comprueba si falla.
-	if (pthread_mutex_unlock(&semaforo_atletas)!=0)
+
+	// Ya no se atienden más señales.
+	signal(SIGUSR1, SIG_IGN);
+	signal(SIGUSR2, SIG_IGN);
+	signal(SIGINT, SIG_IGN);
+
+	if (conCarga==1) paraCarga(&carga);
+	paraDurabilidad(&durabilidad);
+	paraPlanificador();
+	sincronizaAlCerrar(&durabilidad, ficheroResultados());
+	cierraResultados(); // Se completan los índices del almacén de resultados.
+	liberaCarga(&carga);
+	liberaDurabilidad(&durabilidad);
+
+	for (i=0; i<numCampeonatos; i++)
 	{
-		perror("Error en el desbloqueo del semáforo de los atletas.\n");
-		exit(-1);
+		destruyeCampeonato(campeonatos[i]);
 	}
-	
+
+	return 0;
 }
+#endif
 
 
-void *accionesAtleta (void *arg)
-{ 
-	int dorsal = *(int*)arg; // Se convierte el argumento a tipo entero.
-	int pos;
-	int i;
-	int estado_salud;
-	char *elemento;
-	char *msg;
-	
-	// Se reserva espacio en memoria.
-	elemento = (char*)malloc(sizeof(char)*30);
-	msg = (char*)malloc(sizeof(char)*256);
-	
-	
-	// Se calcula la posición del atleta.
-	for(i=0; i<maxAtletas; i++)
-	{
-		if(atletas[i].id==dorsal)
-		{
-			pos = i;
-			break;
-		}
+
+/* Implementación de las funciones. */
+
+
+struct campeonato *creaCampeonato (int numero, int maxAtletas, int numTarimas, int maxTarimas)
+{
+	struct campeonato *c = (struct campeonato*)calloc(1, sizeof(struct campeonato));
+
+	c->numero = numero;
+	c->maxAtletas = maxAtletas;
+	c->numTarimas = numTarimas;
+	c->maxTarimas = (maxTarimas>numTarimas) ? maxTarimas : numTarimas;
+
+	// Con un solo campeonato todo queda como siempre; con varios cada uno tiene su log y se distinguen en pantalla.
+	if (modoAnfitrion==1)
+	{
+		snprintf(c->prefijo, sizeof(c->prefijo), "Campeonato %d: ", numero);
+		snprintf(c->nombreArchivo, TAMNOMBRE, FORMATO_LOG_CAMPEONATO, numero);
+	}
+	else if (fragmento>0)
+	{
+		snprintf(c->prefijo, sizeof(c->prefijo), "Fragmento %d: ", fragmento);
+		snprintf(c->nombreArchivo, TAMNOMBRE, FORMATO_LOG_FRAGMENTO, fragmento);
+	}
+	else
+	{
+		snprintf(c->nombreArchivo, TAMNOMBRE, "%s", nombreArchivo);
 	}
 
 
-	// Se guarda a qué tarima va a competir en el log.	
-	sprintf(elemento, "Atleta %d", dorsal); 
-	sprintf(msg, "He entrado a la tarima %d, ¡os vais a enterar!", atletas[pos].tarima_asignada);
-	printf("%s: %s\n", elemento, msg); // Se imprime el mensaje por pantalla.
+	// Se inicializan los semáforos, además de comprobar si hay errores.
+	if (pthread_mutex_init(&c->semaforo_atletas, NULL)!=0)
+	{
+		perror("Error en la creación del semáforo de los atletas.\n");
+		exit(-1);
+ 	}
 
-	if (pthread_mutex_lock(&semaforo_escribir)!=0)	// Se bloquea el semáforo para que los mensajes entren de uno en uno.
+ 	if (pthread_mutex_init(&c->semaforo_tarimas, NULL)!=0)
 	{
-		perror("Error en el bloqueo del semáforo para escribir en el fichero.\n");
+		perror("Error en la creación del semáforo de las tarimas.\n");
 		exit(-1);
-	}
+ 	}
 
-			writeLogMessage(elemento, msg); // La hora de entrada a la tarima la escribe la función del log.
+ 	if (pthread_mutex_init(&c->semaforo_escribir, NULL)!=0)
+	{
+		perror("Error en la creación del semáforo para escribir en el fichero.\n");
+		exit(-1);
+ 	}
 
-	if (pthread_mutex_unlock(&semaforo_escribir)!=0) // Se desbloquea el semáforo para que los mensajes entren de uno en uno.
+ 	if (pthread_mutex_init(&c->semaforo_descansos, NULL)!=0)
 	{
-		perror("Error en el desbloqueo del semáforo para escribir en el fichero.\n");
+		perror("Error en la creación del semáforo de los descansos.\n");
 		exit(-1);
-	}
-	
+ 	}
 
-	// Se calcula el comportamiento del atleta mientras está en la cola esperando para subir a la tarima correspondiente.
-	do 
+ 	if (pthread_mutex_init(&c->semaforo_huecos, NULL)!=0)
 	{
-		estado_salud=calculaAleatorios(1,100); // Número aleatorio para calcular el estado de salud.
+		perror("Error en la creación del semáforo de los huecos.\n");
+		exit(-1);
+ 	}
 
-		if (estado_salud<=15)
-		{
-			eliminaAtleta(pos); // Se libera la posición del atleta en la cola (se inicializan los datos de nuevo).
-			
-			// Se escribe en el log.
-			sprintf(elemento, "Atleta %d", dorsal); 
-			sprintf(msg, "Estoy deshidratado de tanto estrés y no puedo realizar el levantamiento.");
-			printf("%s: %s\n", elemento, msg);
-			
-			if (pthread_mutex_lock(&semaforo_escribir)!=0)	
-			{
-				perror("Error en el bloqueo del semáforo para escribir en el fichero.\n");
-				exit(-1);
-			}
 
-				writeLogMessage(elemento, msg);
+	// Se reserva espacio en memoria para los punteros de las tarimas y los atletas.
+	c->punteroTarimas = (struct tarimasCompeticion*)malloc(sizeof(struct tarimasCompeticion)*c->maxTarimas); // Con hueco para las que se abran después.
+	c->atletas = (struct atletasCompeticion*)malloc(sizeof(struct atletasCompeticion)*c->maxAtletas);
+	c->huecos = (int*)malloc(sizeof(int)*c->maxAtletas);
+	c->esperasControl = (int64_t*)malloc(sizeof(int64_t)*(c->maxAtletas+VENTANA_ESPERAS));
 
-			if (pthread_mutex_unlock(&semaforo_escribir)!=0) 
-			{
-				perror("Error en el desbloqueo del semáforo para escribir en el fichero.\n");
-				exit(-1);
-			}
-			
-			pthread_exit(NULL); // Se finaliza el hilo.
-		}	
-		else
-		{
-			sleep (3);
-		}
-	}while (atletas[pos].ha_competido==0); // Fin del atleta en la cola.
 
+	// Bus de sucesos. Lo que va al log se reenvía el primero: lo que un suceso provoca en otro suscriptor se escribe después de él.
+	iniciaBus(&c->bus);
+	iniciaBus(&c->etapaLog);
+	iniciaBus(&c->etapaAlmacen);
+	c->bus.marcaHora = (durabilidad.modo!=DURABILIDAD_NADA); // La latencia hasta el disco se cuenta desde el suceso.
+	suscribe(&c->bus, TODOS_SUCESOS, reenviaSuceso, &c->etapaLog);
+	suscribe(&c->bus, 1<<SUCESO_PUNTUADO, sucesoPodio, c);
+	suscribe(&c->bus, TODOS_SUCESOS, sucesoMetricas, c);
+	suscribe(&c->bus, 1<<SUCESO_FINALIZADO, sucesoFuente, c);
+	suscribe(&c->bus, 1<<SUCESO_PUNTUADO, reenviaSuceso, &c->etapaAlmacen);
 
-	// Se escribe en el log que el atleta llega a la tarima y espera 4 segundos para realizar su levantamiento.
-	sprintf(elemento, "Atleta %d", dorsal); 
-	sprintf(msg, "Voy a calentar un poco los pies antes de realizar el levantamiento.");
-	printf("%s: %s\n", elemento, msg);
-			
-	if (pthread_mutex_lock(&semaforo_escribir)!=0)	
-	{
-		perror("Error en el bloqueo del semáforo para escribir en el fichero.\n");
-		exit(-1);
-	}
+	// Cada tanda del log se escribe con el semáforo cogido una sola vez, y cada tanda del almacén con una sola escritura.
+	suscribe(&c->etapaLog, TODOS_SUCESOS, sucesoLog, c);
+	defineTandas(&c->etapaLog, abreTandaLog, cierraTandaLog, c);
+	suscribe(&c->etapaAlmacen, 1<<SUCESO_PUNTUADO, sucesoAlmacen, c);
+	defineTandas(&c->etapaAlmacen, NULL, cierraTandaAlmacen, c);
+	iniciaExportacion(&c->exportacion);
 
-		writeLogMessage(elemento, msg);
 
-	if (pthread_mutex_unlock(&semaforo_escribir)!=0) 
-	{
-		perror("Error en el desbloqueo del semáforo para escribir en el fichero.\n");
-		exit(-1);
-	}
-	
-	sleep(4);
-	atletas[pos].calentamiento=1; // Se indica que ya ha realizado el calentamiento.
-	
-	
-	// Se espera a que termine de competir.
-	do 
-	{
-		sleep(1);
-		
-	}while (atletas[pos].puntuacion==0 && atletas[pos].ha_competido!=2);
-	
-
-	// Se escribe en el log la hora a la que ha finalizado su levantamiento.
-	sprintf(elemento, "Atleta %d", dorsal); 
-	sprintf(msg, "He finalizado el levantamiento y me duelen los pies.");
-	printf("%s: %s\n", elemento, msg);
-			
-	if (pthread_mutex_lock(&semaforo_escribir)!=0)	
+	// Se crean el fichero log y los demás sumideros de mensajes.
+	if (abreSumideros(c)!=0)
 	{
-		perror("Error en el bloqueo del semáforo para escribir en el fichero.\n");
-		exit(-1);
+		return NULL;
 	}
+	return c;
+}
+
+
+void inicializaCampeonato (struct campeonato *c)
+{
+	int i;
+	int j;
 
-		writeLogMessage(elemento, msg);
+	c->contadorAtletas=0;
+	c->primerDorsal=(fragmento>0) ? fragmento : 1;
+	c->saltoDorsal=(fragmento>0) ? numFragmentos : 1;
+	c->estadoFuente=0;
+	memset(&c->metricas, 0, sizeof(c->metricas));
+	c->finalizar=0;
+	c->finPedido=0;
+	c->pasoFin=0;
+	c->juecesDescansando=0;
+	c->inicioCampeonato=marcaTiempo();
+	c->tareasVivas=0;
 
-	if (pthread_mutex_unlock(&semaforo_escribir)!=0) 
+	// Se inicializan los datos de los atletas.
+	for (i=0; i<c->maxAtletas; i++)
 	{
-		perror("Error en el desbloqueo del semáforo para escribir en el fichero.\n");
-		exit(-1);
+		c->atletas[i].id=0;
+		c->atletas[i].ha_competido=0;
+		c->atletas[i].tarima_asignada=0;
+		c->atletas[i].puntuacion=0;
+		c->atletas[i].necesita_beber=0;
+		c->atletas[i].calentamiento=0;
+		c->atletas[i].levantado=0;
+		c->atletas[i].siguienteCola=-1;
+		c->atletas[i].anteriorCola=-1;
+		c->atletas[i].campeonato=c;
+		c->atletas[i].juez=NULL;
+		iniciaTarea(&c->atletas[i].tarea, pasoAtleta, &c->atletas[i]);
+		c->huecos[i]=c->maxAtletas-1-i;
 	}
+	c->numHuecos=c->maxAtletas;
 
 
-	// Fuente.
-	if (atletas[pos].necesita_beber==1)
+	// Se inicializa el podio.
+	for (i=0; i<2; i++)
 	{
-		estadoFuente++;
-		
-		if (estadoFuente==1) // Un atleta en la fuente (sólo para el primero que entra).
+		for (j=0; j<3; j++)
 		{
-			meteEnFuente(pos); // Se registra qué atleta entra en la fuente.
+			c->podio[i][j]=0;
 		}
-		else // Dos atletas en la fuente.
-		{
-			estadoFuente=1; // Se indica que sigue ocupada porque se quedaría un atleta dentro esperando a beber.
-
-			// Se escribe en el log.
-			sprintf(elemento, "Atleta %d", dorsal); 
-			sprintf(msg, "Voy a beber a la fuente, pero ... ¡vaya por Dios! No me toca beber sino apretar el botón.");
-			printf("%s: %s\n", elemento, msg);
-			
-			if (pthread_mutex_lock(&semaforo_escribir)!=0)	
-			{
-				perror("Error en el bloqueo del semáforo para escribir en el fichero.\n");
-				exit(-1);
-			}
+	}
+	for (j=0; j<3; j++)
+	{
+		c->finPodio[j]=0;
+	}
 
-				writeLogMessage(elemento, msg);
 
-			if (pthread_mutex_unlock(&semaforo_escribir)!=0) 
-			{
-				perror("Error en el desbloqueo del semáforo para escribir en el fichero.\n");
-				exit(-1);
-			}
-			
-			// Se envía la señal para indicar que un atleta ya ha bebido.	
-			if (pthread_cond_signal(&condicion)!=0)	
-			{
-				perror("Error en el envío de la señal de la fuente.\n");
-				exit(-1);
-			}
-				
-			meteEnFuente(pos); // Se registra al último atleta que entra en la fuente y que ahora espera para beber.
-		}
+	// Se inicializan los datos de las tarimas (también los huecos de las que se puedan abrir más tarde) y se ponen en marcha los jueces.
+	c->minTarimas=c->numTarimas;
+	c->tarimasAbiertas=c->numTarimas;
+	c->tarimasAbiertasTotal=0;
+	c->tarimasCerradasTotal=0;
+	c->periodosQuietos=0;
+	for (i=0; i<c->maxTarimas; i++)
+	{
+		c->punteroTarimas[i].id=i+1; // Se asigna el número correspondiente a cada tarima.
+		c->punteroTarimas[i].descansa=(i*descansoCada)/c->numTarimas; // Cada juez empieza a contar desde un punto distinto para que no descansen todos a la vez.
+		c->punteroTarimas[i].contador=0;
+		c->punteroTarimas[i].descansos=0;
+		c->punteroTarimas[i].aplazados=0;
+		c->punteroTarimas[i].t_descanso=0;
+		c->punteroTarimas[i].estado=TARIMA_CERRADA;
+		c->punteroTarimas[i].t_apertura=c->inicioCampeonato;
+		c->punteroTarimas[i].t_abierta=0;
+		c->punteroTarimas[i].numEsperas=0;
+		c->punteroTarimas[i].primeroCola=-1;
+		c->punteroTarimas[i].ultimoCola=-1;
+		c->punteroTarimas[i].enCola=0;
+		c->punteroTarimas[i].paso=JUEZ_ELIGE;
+		c->punteroTarimas[i].ocioso=0;
+		c->punteroTarimas[i].campeonato=c;
+		iniciaTarea(&c->punteroTarimas[i].tatami, pasoTarima, &c->punteroTarimas[i]);
+		asignaGrupo(&c->punteroTarimas[i].tatami, grupoJuez(i+1)); // Cada tarima siempre en el mismo hilo de jueces (si los hay).
 	}
-	else
+	for (i=0; i<c->numTarimas; i++)
 	{
-		pthread_exit(NULL); // Si no necesita beber se finaliza el hilo del atleta.
+		c->punteroTarimas[i].estado=TARIMA_ABIERTA;
+		__sync_fetch_and_add(&c->tareasVivas, 1);
+		programaTarea(&c->punteroTarimas[i].tatami, 0);
 	}
 
 
-	// Se libera el espacio de memoria reservado.
-	free(elemento);
-	free(msg);	
+	// Los mensajes acumulados se escriben cada cierto tiempo.
+	iniciaTarea(&c->vaciado, pasoVaciado, c);
+	__sync_fetch_and_add(&c->tareasVivas, 1);
+	programaTarea(&c->vaciado, (int64_t)intervaloVaciado*1000000);
+
+	// Si se pueden abrir más tarimas se revisan las colas cada cierto tiempo. Sin tiempo virtual ninguna espera llega al umbral, así que no se pone en marcha.
+	iniciaTarea(&c->controlador, pasoControlador, c);
+	if (c->maxTarimas>c->numTarimas && tiempoCampeonato(esperaP90)==0)
+	{
+		registraEvento(c, EVENTO_SIN_CONTROL, 0, c->numTarimas, 0);
+		c->maxTarimas = c->numTarimas;
+	}
+	if (c->maxTarimas>c->numTarimas)
+	{
+		__sync_fetch_and_add(&c->tareasVivas, 1);
+		programaTarea(&c->controlador, tiempoReintento(periodoControl));
+	}
+
+	iniciaTarea(&c->fin, pasoFinal, c);
 }
 
 
-void meteEnFuente (int pos)
+void destruyeCampeonato (struct campeonato *c)
 {
-	int dorsal = atletas[pos].id;
-	char *elemento;
-	char *msg;
-	
-	// Se reserva espacio en memoria.
-	elemento = (char*)malloc(sizeof(char)*30);
-	msg = (char*)malloc(sizeof(char)*256);
-	
-	
-	// Se escribe en el log.
-	sprintf(elemento, "Atleta %d", dorsal); 
-	sprintf(msg, "Voy a beber a la fuente, pero ... ¡qué lástima! No soy capaz de apretar el botón, no tengo fuerza.");
-	printf("%s: %s\n", elemento, msg);
-	
-	if (pthread_mutex_lock(&semaforo_escribir)!=0)	
+	// Destrucción de los semáforos.
+	if (pthread_mutex_destroy(&c->semaforo_atletas)!=0)
 	{
-		perror("Error en el bloqueo del semáforo para escribir en el fichero.\n");
+		perror("Error en la destrucción del semáforo para los atletas.\n");
 		exit(-1);
 	}
 
-		writeLogMessage(elemento, msg);
-
-	if (pthread_mutex_unlock(&semaforo_escribir)!=0) 
+	if (pthread_mutex_destroy(&c->semaforo_tarimas)!=0)
 	{
-		perror("Error en el desbloqueo del semáforo para escribir en el fichero.\n");
+		perror("Error en la destrucción del semáforo para las tarimas.\n");
 		exit(-1);
 	}
-	
-	
-	// Se guardan los datos del atleta en la fuente.
-	colaFuente[0].id = atletas[pos].id;
-	colaFuente[0].tarima_asignada = atletas[pos].tarima_asignada;
-	colaFuente[0].ha_competido = atletas[pos].ha_competido;
-	colaFuente[0].puntuacion = atletas[pos].puntuacion;
-	colaFuente[0].necesita_beber = atletas[pos].necesita_beber;
-	
-	eliminaAtleta(pos); // Se libera la posición del atleta en la cola.
-	
-
-	// Semáforo de la fuente.
-	if (pthread_mutex_lock(&semaforo_fuente)!=0)	
-	{
-		perror("Error en el bloqueo del semáforo para la fuente.\n");
+
+	if (pthread_mutex_destroy(&c->semaforo_escribir)!=0)
+	{
+		perror("Error en la destrucción del semáforo para escribir en el fichero.\n");
 		exit(-1);
 	}
-		
-		// Se espera la condición para que finalice un atleta y desbloquear el semáforo de la fuente.
-		if (pthread_cond_wait(&condicion, &semaforo_fuente)!=0) 
-		{
-			perror("Error en la espera de la condición del semáforo para la fuente.\n");
-			exit(-1);
-		}
-
-		// Se escribe en el log que el atleta ya ha bebido.
-		sprintf(elemento, "Atleta %d", dorsal); 
-		sprintf(msg, "Ya he bebido, pero el agua está caliente como en mi gimnasio.");
-		printf("%s: %s\n", elemento, msg);
-		
-		if (pthread_mutex_lock(&semaforo_escribir)!=0)	
-		{
-			perror("Error en el bloqueo del semáforo para escribir en el fichero.\n");
-			exit(-1);
-		}
 
-			writeLogMessage(elemento, msg);
+	if (pthread_mutex_destroy(&c->semaforo_descansos)!=0)
+	{
+		perror("Error en la destrucción del semáforo de los descansos.\n");
+		exit(-1);
+	}
 
-		if (pthread_mutex_unlock(&semaforo_escribir)!=0) 
-		{
-			perror("Error en el desbloqueo del semáforo para escribir en el fichero.\n");
-			exit(-1);
-		}
-	
-		pthread_exit(NULL); // Finaliza el hilo del atleta que ha bebido.
-	
-	if (pthread_mutex_unlock(&semaforo_fuente)!=0)	
+	if (pthread_mutex_destroy(&c->semaforo_huecos)!=0)
 	{
-		perror("Error en el desbloqueo del semáforo para la fuente.\n");
+		perror("Error en la destrucción del semáforo de los huecos.\n");
 		exit(-1);
 	}
 
 
-	// Se libera el espacio de memoria reservado.
-	free(elemento);
-	free(msg);	
+	// Se libera toda la memoria reservada.
+	liberaBus(&c->bus);
+	liberaBus(&c->etapaLog);
+	liberaBus(&c->etapaAlmacen);
+	liberaExportacion(&c->exportacion);
+	free(c->atletas);
+	free(c->huecos);
+	free(c->punteroTarimas);
+	free(c->esperasControl);
+	free(c);
 }
 
 
-void eliminaAtleta (int pos)
+int haySitioEnCampeonato (struct campeonato *c)
 {
-	atletas[pos].id=0;
-	atletas[pos].ha_competido=0;
-	atletas[pos].tarima_asignada=0;
-	atletas[pos].puntuacion=0;
-	atletas[pos].necesita_beber=0;
-	atletas[pos].calentamiento=0;
-}
+	int posicion = -1;
+
+	// Los huecos libres se guardan en una pila para no recorrer todos los atletas en cada inscripción.
+	if (pthread_mutex_lock(&c->semaforo_huecos)!=0)
+	{
+		perror("Error en el bloqueo del semáforo de los huecos.\n");
+		exit(-1);
+	}
+
+		if (c->numHuecos>0)
+		{
+			c->numHuecos--;
+			posicion = c->huecos[c->numHuecos];
+		}
+
+	if (pthread_mutex_unlock(&c->semaforo_huecos)!=0)
+	{
+		perror("Error en el desbloqueo del semáforo de los huecos.\n");
+		exit(-1);
+	}
+	return posicion;
+} // Devuelve -1 en caso de no haber sitio y si no reserva un hueco libre y lo devuelve.
 
 
-void *accionesTarima (void *arg)
+void liberaHueco (struct campeonato *c, int pos)
 {
-	int numero = *(int*)arg; // Se convierte el argumento a tipo entero.
-	int comportamiento;
+	if (pthread_mutex_lock(&c->semaforo_huecos)!=0)
+	{
+		perror("Error en el bloqueo del semáforo de los huecos.\n");
+		exit(-1);
+	}
+
+		c->huecos[c->numHuecos] = pos;
+		c->numHuecos++;
+
+	if (pthread_mutex_unlock(&c->semaforo_huecos)!=0)
+	{
+		perror("Error en el desbloqueo del semáforo de los huecos.\n");
+		exit(-1);
+	}
+} // El semáforo de los huecos no toma ningún otro, así que se puede llamar con cualquiera bloqueado.
+
+
+void nuevoCompetidor (int sig)
+{
+	int i;
+
+	if (signal(SIGUSR1, nuevoCompetidor)==SIG_ERR)
+	{
+		perror("Error en la llamada a la señal SIGUSR1.\n");
+		exit(-1);
+	}
+	if (signal(SIGUSR2, nuevoCompetidor)==SIG_ERR)
+	{
+		perror("Error en la llamada a la señal SIGUSR2.\n");
+		exit(-1);
+	}
+
+	// Según qué señal se recibe se asigna la tarima correspondiente (en el modo anfitrión entra un atleta en cada campeonato).
+	for (i=0; i<numCampeonatos; i++)
+	{
+		if (sig == 10)
+		{
+			inscribeAtleta(campeonatos[i], 1);
+		}
+		else if (sig == 12)
+		{
+			inscribeAtleta(campeonatos[i], 2);
+		}
+	}
+}
+
+
+int inscribeAtleta (struct campeonato *c, int tarima)
+{
+	struct atletasCompeticion *atleta;
+	int posicion;
+
+	if (c->finalizar==1) return -1; // El campeonato ya ha terminado.
+
+	registraEvento(c, EVENTO_SOLICITUD, 0, 0, 0);
+
+	// Si la tarima pedida no está abierta se manda a la que tenga la cola más corta.
+	if (tarima<1 || tarima>c->numTarimas || c->punteroTarimas[tarima-1].estado!=TARIMA_ABIERTA)
+	{
+		tarima = tarimaMasCorta(c);
+	}
+
+
+	// Se bloquea el semáforo para que los atletas entren de uno en uno.
+	if (pthread_mutex_lock(&c->semaforo_atletas)!=0)
+	{
+		perror("Error en el bloqueo del semáforo de los atletas.\n");
+		exit(-1);
+	}
+
+		// Se comprueba si hay sitio en la competición y cuál es.
+		posicion = haySitioEnCampeonato(c);
+
+		if(posicion!=-1)
+		{
+			registraEvento(c, EVENTO_INSCRITO, 0, 0, 0);
+			atleta = &c->atletas[posicion];
+			atleta->id=c->primerDorsal+c->contadorAtletas*c->saltoDorsal;
+			c->contadorAtletas++;
+			atleta->puntuacion=0;
+			atleta->tarima_asignada=tarima;
+			atleta->ha_competido=0;
+			atleta->necesita_beber=0;
+			atleta->calentamiento=AVISO_PENDIENTE;
+			atleta->levantado=AVISO_PENDIENTE;
+			atleta->juez=NULL;
+			atleta->t_inscripcion=marcaTiempo();
+			atleta->paso=ATLETA_ENTRA;
+			anunciaSuceso(c, SUCESO_INSCRITO, atleta->id, tarima, 0);
+
+			if (miFragmento!=NULL)
+			{
+				__sync_fetch_and_add(&miFragmento->ocupados, 1);
+				__sync_fetch_and_add(&miFragmento->inscritos, 1);
+			}
+
+			// Se pone a la cola de su tarima (desde aquí ya lo puede llamar un juez) y se pone en marcha su tarea.
+			__sync_fetch_and_add(&c->tareasVivas, 1);
+			if (pthread_mutex_lock(&c->semaforo_tarimas)!=0)
+			{
+				perror("Error en el bloqueo del semáforo de las tarimas.\n");
+				exit(-1);
+			}
+
+				meteEnCola(c, posicion, tarima);
+
+			if (pthread_mutex_unlock(&c->semaforo_tarimas)!=0)
+			{
+				perror("Error en el desbloqueo del semáforo de las tarimas.\n");
+				exit(-1);
+			}
+			programaTarea(&atleta->tarea, 0);
+		}
+		else
+		{
+			registraEvento(c, EVENTO_SIN_SITIO, 0, c->maxAtletas, 0);
+		}
+
+	// Se desbloquea el semáforo, además se comprueba si falla.
+	if (pthread_mutex_unlock(&c->semaforo_atletas)!=0)
+	{
+		perror("Error en el desbloqueo del semáforo de los atletas.\n");
+		exit(-1);
+	}
+
+	return posicion;
+} // Devuelve la posición del nuevo atleta o -1 si no había sitio.
+
+
+int64_t tiempoCampeonato (int segundos)
+{
+	// En tiempo virtual cada segundo del campeonato dura tiempoVirtual microsegundos (con 0 no se espera nada).
+	if (tiempoVirtual<0) return (int64_t)segundos*1000000000;
+	return (int64_t)segundos*tiempoVirtual*1000;
+}
+
+
+int64_t tiempoReintento (int segundos)
+{
+	int64_t tiempo = tiempoCampeonato(segundos);
+
+	return (tiempo<ESPERA_MINIMA_NS) ? ESPERA_MINIMA_NS : tiempo;
+}
+
+
+void terminaTarea (struct campeonato *c)
+{
+	__sync_fetch_and_sub(&c->tareasVivas, 1);
+} // Cada tarea la llama una sola vez, en el último paso que da.
+
+
+void pasoAtleta (struct tarea *tarea)
+{
+	struct atletasCompeticion *atleta = (struct atletasCompeticion*)tarea->datos;
+	struct campeonato *c = atleta->campeonato;
+	int pos = atleta-c->atletas;
+	int dorsal = atleta->id;
+	int estado_salud;
+	int comprobaciones;
+	int llamado;
+	int deshidratado;
+
+
+	if (c->finalizar==1) // El campeonato ha terminado: el atleta se va sin más.
+	{
+		terminaTarea(c);
+		return;
+	}
+
+	switch (atleta->paso)
+	{
+		case ATLETA_ENTRA:
+			// Mientras espera en la cola se comprueba su salud al entrar y después cada 3 segundos. Se sortea ya en qué
+			// comprobación se deshidrata, así el atleta duerme hasta entonces en vez de despertarse cada 3 segundos.
+			comprobaciones=0;
+			do
+			{
+				estado_salud=aleatorio(ALEATORIO_SALUD); // Número aleatorio para calcular el estado de salud.
+				comprobaciones++;
+			}while (estado_salud>15);
+
+			// Se programa con el semáforo de las tarimas: si un juez lo llama después, su aviso sustituye a esta espera.
+			if (pthread_mutex_lock(&c->semaforo_tarimas)!=0)
+			{
+				perror("Error en el bloqueo del semáforo de las tarimas.\n");
+				exit(-1);
+			}
+
+				llamado=(atleta->ha_competido!=0);
+				if (llamado==0)
+				{
+					atleta->paso = ATLETA_EN_COLA;
+					programaTarea(tarea, tiempoCampeonato(3*(comprobaciones-1)));
+				}
+
+			if (pthread_mutex_unlock(&c->semaforo_tarimas)!=0)
+			{
+				perror("Error en el desbloqueo del semáforo de las tarimas.\n");
+				exit(-1);
+			}
+
+			if (llamado==0) return;
+			// Ya lo han llamado: va directo a calentar.
+
+		case ATLETA_EN_COLA:
+			// Lo despierta el juez que lo llama o llega la comprobación de salud en la que se deshidrata.
+			if (pthread_mutex_lock(&c->semaforo_tarimas)!=0)
+			{
+				perror("Error en el bloqueo del semáforo de las tarimas.\n");
+				exit(-1);
+			}
+
+				deshidratado=0;
+				if (atleta->ha_competido==0)
+				{
+					sacaDeCola(c, pos);
+					eliminaAtleta(c, pos); // Se libera la posición del atleta en la cola (se inicializan los datos de nuevo).
+					deshidratado=1;
+				}
+
+			if (pthread_mutex_unlock(&c->semaforo_tarimas)!=0)
+			{
+				perror("Error en el desbloqueo del semáforo de las tarimas.\n");
+				exit(-1);
+			}
+
+			if (deshidratado==1)
+			{
+				// El hueco ya puede ser de otro atleta, así que no se vuelve a tocar.
+				anunciaSuceso(c, SUCESO_DESHIDRATADO, dorsal, 0, 0);
+				terminaTarea(c); // Fin del atleta.
+				return;
+			}
+
+			// Fin del atleta en la cola: llega a la tarima (el juez ya ha publicado que lo llama) y espera 4 segundos para realizar su levantamiento.
+			atleta->paso = ATLETA_CALENTANDO;
+			programaTarea(tarea, tiempoCampeonato(4));
+			return;
+
+		case ATLETA_CALENTANDO:
+			anunciaSuceso(c, SUCESO_CALENTADO, dorsal, 0, 0);
+			atleta->paso = ATLETA_ESPERA_FIN;
+			daAviso(&atleta->calentamiento, atleta->juez); // Se indica que ya ha realizado el calentamiento.
+			// Sigue esperando a que lo puntúen.
+
+		case ATLETA_ESPERA_FIN:
+			// Se espera a que termine de competir: lo despierta el juez al puntuarlo.
+			if (esperaAviso(&atleta->levantado)==1) return;
+
+			// Se publica que ha finalizado y si va a la fuente (de la fuente se encarga su suscriptor) y deja el hueco para otro atleta.
+			anunciaSuceso(c, SUCESO_FINALIZADO, dorsal, 0, atleta->necesita_beber);
+			eliminaAtleta(c, pos);
+
+			terminaTarea(c); // El que espera en la fuente ya no necesita tarea: lo despierta el siguiente que llegue.
+			return;
+	}
+}
+
+
+void eliminaAtleta (struct campeonato *c, int pos)
+{
+	if (miFragmento!=NULL) __sync_fetch_and_sub(&miFragmento->ocupados, 1);
+
+	c->atletas[pos].id=0;
+	c->atletas[pos].ha_competido=0;
+	c->atletas[pos].tarima_asignada=0;
+	c->atletas[pos].puntuacion=0;
+	c->atletas[pos].necesita_beber=0;
+	c->atletas[pos].calentamiento=0;
+	c->atletas[pos].levantado=0;
+	liberaHueco(c, pos);
+}
+
+
+void meteEnCola (struct campeonato *c, int pos, int numero)
+{
+	struct tarimasCompeticion *tarima = &c->punteroTarimas[numero-1];
+	struct atletasCompeticion *atleta = &c->atletas[pos];
+	int anterior = tarima->ultimoCola;
+
+	// Casi siempre es el último en llegar; los que vienen de otra tarima se colocan por su dorsal.
+	while (anterior!=-1 && c->atletas[anterior].id>atleta->id) anterior = c->atletas[anterior].anteriorCola;
+
+	atleta->anteriorCola = anterior;
+	atleta->siguienteCola = (anterior==-1) ? tarima->primeroCola : c->atletas[anterior].siguienteCola;
+	if (anterior==-1) tarima->primeroCola = pos;
+	else c->atletas[anterior].siguienteCola = pos;
+	if (atleta->siguienteCola==-1) tarima->ultimoCola = pos;
+	else c->atletas[atleta->siguienteCola].anteriorCola = pos;
+
+	atleta->tarima_asignada = numero;
+	tarima->enCola++;
+	despiertaJueces(c, numero); // Su juez o, si está ocupado, uno que ayude desde otra tarima.
+} // Se llama con semaforo_tarimas bloqueado.
+
+
+void sacaDeCola (struct campeonato *c, int pos)
+{
+	struct atletasCompeticion *atleta = &c->atletas[pos];
+	struct tarimasCompeticion *tarima = &c->punteroTarimas[atleta->tarima_asignada-1];
+
+	if (atleta->anteriorCola==-1) tarima->primeroCola = atleta->siguienteCola;
+	else c->atletas[atleta->anteriorCola].siguienteCola = atleta->siguienteCola;
+	if (atleta->siguienteCola==-1) tarima->ultimoCola = atleta->anteriorCola;
+	else c->atletas[atleta->siguienteCola].anteriorCola = atleta->anteriorCola;
+
+	atleta->anteriorCola = -1;
+	atleta->siguienteCola = -1;
+	tarima->enCola--;
+} // Se llama con semaforo_tarimas bloqueado.
+
+
+void despiertaJueces (struct campeonato *c, int numero)
+{
+	int i;
+
+	if (c->juecesOciosos==0) return;
+
+	// Si el juez de la tarima está ocioso se despierta sólo a él, que es quien primero llama a los de su cola.
+	if (numero>0 && c->punteroTarimas[numero-1].ocioso==1)
+	{
+		c->punteroTarimas[numero-1].ocioso=0;
+		c->juecesOciosos--;
+		programaTarea(&c->punteroTarimas[numero-1].tatami, 0);
+		return;
+	}
+
+	// Si no, se despiertan todos: el primero que llegue coge al atleta y los demás vuelven a dormirse.
+	for (i=0; i<c->numTarimas; i++)
+	{
+		if (c->punteroTarimas[i].ocioso==1)
+		{
+			c->punteroTarimas[i].ocioso=0;
+			programaTarea(&c->punteroTarimas[i].tatami, 0);
+		}
+	}
+	c->juecesOciosos=0;
+} // Se llama con semaforo_tarimas bloqueado.
+
+
+int esperaAviso (int *aviso)
+{
+	return __sync_bool_compare_and_swap(aviso, AVISO_PENDIENTE, AVISO_ESPERANDO);
+} // Si devuelve 1 la tarea no se programa: la despierta daAviso.
+
+
+void daAviso (int *aviso, struct tarea *tarea)
+{
+	if (__sync_lock_test_and_set(aviso, AVISO_HECHO)==AVISO_ESPERANDO)
+	{
+		programaTarea(tarea, 0);
+	}
+} // Después de dar el aviso el que lo da no vuelve a tocar los datos del otro.
+
+
+int eligeAtleta (struct campeonato *c, int numero, int *ayuda)
+{
+	int i;
+
+	*ayuda=0;
+
+	// Se asigna el atleta de la propia tarima que más tiempo lleva esperando (el primero de su cola) y si no de otra.
+	if (c->punteroTarimas[numero-1].primeroCola!=-1)
+	{
+		return c->punteroTarimas[numero-1].primeroCola;
+	}
+
+	*ayuda=1;
+	for (i=0; i<c->numTarimas; i++)
+	{
+		if (c->punteroTarimas[i].primeroCola!=-1)
+		{
+			return c->punteroTarimas[i].primeroCola;
+		}
+	}
+	return 10000;
+} // Devuelve 10000 si no hay nadie esperando en ninguna cola (se llama con semaforo_tarimas bloqueado).
+
+
+void actualizaPodio (struct campeonato *c, int dorsal, int puntuacion, int64_t fin)
+{
+	int i;
+	int j;
+
+	// Un puesto vacío (dorsal 0) lo ocupa cualquiera; si no, se desempata como en la clasificación de los fragmentos (gana el último en acabar).
+	for (i=0; i<3; i++)
+	{
+		if (c->podio[0][i]==0 || vaDelante(puntuacion, fin, dorsal, c->podio[1][i], c->finPodio[i], c->podio[0][i]))
+		{
+			if (i!=2) // Si no es la última posición se cambian los valores.
+			{
+				for (j=2; j>=i+1; j--)
+				{
+					c->podio[0][j] = c->podio[0][j-1];
+					c->podio[1][j] = c->podio[1][j-1];
+					c->finPodio[j] = c->finPodio[j-1];
+				}
+			}
+
+			c->podio[0][i]=dorsal;
+			c->podio[1][i]=puntuacion;
+			c->finPodio[i]=fin;
+			i=3;
+		}
+	}
+}
+
+
+void sucesoLog (void *datos, struct suceso *suceso)
+{
+	struct campeonato *c = (struct campeonato*)datos;
+
+	horaSuceso = suceso->publicado;
+	switch (suceso->tipo)
+	{
+		case SUCESO_INSCRITO:
+			registraEvento(c, EVENTO_PREPARADO, 0, suceso->dorsal, suceso->tarima);
+			registraEvento(c, EVENTO_ENTRA_TARIMA, suceso->dorsal, suceso->tarima, 0);
+			break;
+
+		case SUCESO_LLAMADO:
+			registraEvento(c, EVENTO_CALIENTA, suceso->dorsal, 0, 0);
+			break;
+
+		case SUCESO_PUNTUADO:
+			if (suceso->resultado==RESULTADO_VALIDO) registraPuntuacion(c, EVENTO_VALIDO, suceso->tarima, suceso->dorsal, suceso->valor, suceso->hora);
+			else if (suceso->resultado==RESULTADO_NULO_INDUMENTARIA) registraPuntuacion(c, EVENTO_NULO_INDUMENTARIA, suceso->tarima, suceso->dorsal, 0, suceso->hora);
+			else registraPuntuacion(c, EVENTO_NULO_FUERZA, suceso->tarima, suceso->dorsal, 0, suceso->hora);
+			break;
+
+		case SUCESO_NECESITA_AGUA:
+			registraEvento(c, EVENTO_NECESITA_BEBER, suceso->tarima, suceso->dorsal, 0);
+			break;
+
+		case SUCESO_FINALIZADO:
+			registraEvento(c, EVENTO_FINALIZA, suceso->dorsal, 0, 0);
+			if (suceso->valor==1) registraEvento(c, EVENTO_SIN_FUERZA_FUENTE, suceso->dorsal, 0, 0);
+			break;
+
+		case SUCESO_BEBIDO:
+			registraEvento(c, EVENTO_APRIETA_BOTON, suceso->valor, 0, 0);
+			registraEvento(c, EVENTO_HA_BEBIDO, suceso->dorsal, 0, 0);
+			break;
+
+		case SUCESO_DESHIDRATADO:
+			registraEvento(c, EVENTO_DESHIDRATADO, suceso->dorsal, 0, 0);
+			break;
+	}
+	horaSuceso = 0;
+} // Los sucesos sin mensaje (como el fin del calentamiento) no escriben nada.
+
+
+void sucesoPodio (void *datos, struct suceso *suceso)
+{
+	struct campeonato *c = (struct campeonato*)datos;
+
+	// Se guarda la puntuación en el podio (y en la clasificación que ve el coordinador) en el mismo orden que el log.
+	actualizaPodio(c, suceso->dorsal, suceso->valor, suceso->hora);
+	if (miFragmento!=NULL) apuntaLevantamiento(miFragmento, suceso->dorsal, suceso->valor, suceso->hora);
+}
+
+
+void sucesoMetricas (void *datos, struct suceso *suceso)
+{
+	struct metricasCampeonato *m = &((struct campeonato*)datos)->metricas;
+
+	switch (suceso->tipo)
+	{
+		case SUCESO_INSCRITO:
+			m->inscritos++;
+			break;
+
+		case SUCESO_LLAMADO:
+			m->llamados++;
+			m->esperaTotal += suceso->hora-suceso->inscripcion;
+			break;
+
+		case SUCESO_CALENTADO:
+			m->calentados++;
+			break;
+
+		case SUCESO_PUNTUADO:
+			if (suceso->resultado==RESULTADO_VALIDO) m->validos++;
+			else m->nulos++;
+			m->duracionTotal += suceso->hora-suceso->llamada;
+			break;
+
+		case SUCESO_NECESITA_AGUA:
+			m->necesitanAgua++;
+			break;
+
+		case SUCESO_BEBIDO:
+			m->bebidos++;
+			break;
+
+		case SUCESO_DESHIDRATADO:
+			m->deshidratados++;
+			break;
+	}
+}
+
+
+void sucesoFuente (void *datos, struct suceso *suceso)
+{
+	struct campeonato *c = (struct campeonato*)datos;
+
+	if (suceso->valor!=1) return; // Se va sin beber.
+
+	// Los atletas llegan a la fuente de uno en uno (en el orden del bus): el segundo aprieta el botón para el primero
+	// y se queda esperando a que llegue otro.
+	if (c->estadoFuente==1)
+	{
+		anunciaSuceso(c, SUCESO_BEBIDO, c->colaFuente, 0, suceso->dorsal);
+	}
+	c->estadoFuente = 1;
+	c->colaFuente = suceso->dorsal;
+}
+
+
+void sucesoAlmacen (void *datos, struct suceso *suceso)
+{
+	struct campeonato *c = (struct campeonato*)datos;
+	struct registroLevantamiento *levantamiento;
+
+	if (c->enTandaAlmacen==TAMTANDA) cierraTandaAlmacen(c); // No pasa con tandas de TAMTANDA, pero por si acaso.
+
+	levantamiento = &c->tandaAlmacen[c->enTandaAlmacen++];
+	levantamiento->dorsal = suceso->dorsal;
+	levantamiento->tarima = suceso->tarima;
+	levantamiento->resultado = suceso->resultado;
+	levantamiento->puntuacion = suceso->valor;
+	levantamiento->t_inscripcion = suceso->inscripcion;
+	levantamiento->t_llamada = suceso->llamada;
+	levantamiento->t_fin = suceso->hora;
+	levantamiento->necesita_beber = suceso->agua;
+	levantamiento->campeonato = c->numero;
+	levantamiento->ejecucion = inicioEjecucion;
+	apuntaRegistro(&durabilidad, &c->durablesAlmacen, suceso->publicado);
+}
+
+
+void cierraTandaAlmacen (void *datos)
+{
+	struct campeonato *c = (struct campeonato*)datos;
+
+	if (c->enTandaAlmacen>0)
+	{
+		guardaLevantamientos(c->tandaAlmacen, c->enTandaAlmacen);
+		apuntaEscritura(&durabilidad, ficheroResultados(), &c->durablesAlmacen);
+		if (exportaColumnas==1) anadeAExportacion(&c->exportacion, c->tandaAlmacen, c->enTandaAlmacen);
+	}
+	c->enTandaAlmacen = 0;
+}
+
+
+void abreTandaLog (void *datos)
+{
+	struct campeonato *c = (struct campeonato*)datos;
+
+	if (pthread_mutex_lock(&c->semaforo_escribir)!=0)
+	{
+		perror("Error en el bloqueo del semáforo para escribir en el fichero.\n");
+		exit(-1);
+	}
+	tandaEscribiendo = c; // escribeEvento ya no lo vuelve a bloquear hasta que se cierre la tanda.
+}
+
+
+void cierraTandaLog (void *datos)
+{
+	struct campeonato *c = (struct campeonato*)datos;
+
+	tandaEscribiendo = NULL;
+	if (pthread_mutex_unlock(&c->semaforo_escribir)!=0)
+	{
+		perror("Error en el desbloqueo del semáforo para escribir en el fichero.\n");
+		exit(-1);
+	}
+}
+
+
+void anunciaSuceso (struct campeonato *c, int tipo, int dorsal, int tarima, int valor)
+{
+	struct suceso suceso = {0};
+
+	suceso.tipo = tipo;
+	suceso.dorsal = dorsal;
+	suceso.tarima = tarima;
+	suceso.valor = valor;
+	publicaSuceso(&c->bus, &suceso);
+}
+
+
+void vaciaEtapas (struct campeonato *c)
+{
+	int repartidos;
+
+	// Se repite por si mientras tanto alguien vacía el bus (un productor que se lo encuentra lleno) y deja algo en las etapas.
+	do
+	{
+		repartidos = vaciaBus(&c->bus);
+		repartidos += vaciaBus(&c->etapaLog);
+		repartidos += vaciaBus(&c->etapaAlmacen);
+	} while (repartidos>0);
+}
+
+
+void resumeSucesos (struct campeonato *c)
+{
+	struct metricasCampeonato *m = &c->metricas;
+	int puntuados = m->validos+m->nulos;
+
+	registraEvento(c, EVENTO_SUCESOS, 0, (int)c->bus.publicados, (int)c->bus.tandas);
+	registraEvento(c, EVENTO_METRICAS_ATLETAS, 0, m->inscritos, m->deshidratados);
+	registraEvento(c, EVENTO_METRICAS_LEVANTAMIENTOS, 0, m->validos, m->nulos);
+	registraEvento(c, EVENTO_METRICAS_ESPERAS, 0, m->llamados>0 ? (int)(m->esperaTotal/m->llamados/1000000) : 0, puntuados>0 ? (int)(m->duracionTotal/puntuados/1000000) : 0);
+	registraEvento(c, EVENTO_METRICAS_FUENTE, 0, m->necesitanAgua, m->bebidos);
+	registraEvento(c, EVENTO_ETAPAS, 0, (int)c->etapaLog.tandas, (int)c->etapaAlmacen.tandas);
+}
+
+
+void pasoTarima (struct tarea *tarea)
+{
+	struct tarimasCompeticion *tarima = (struct tarimasCompeticion*)tarea->datos;
+	struct campeonato *c = tarima->campeonato;
+	struct atletasCompeticion *atleta;
+	struct suceso suceso = {0};
+	int numero = tarima->id;
 	int tiempo;
 	int puntuacion;
+	int recogida;
+	int ocioso;
+	int descanso;
+
+
+	if (c->finalizar==1) // Se ha acabado el campeonato.
+	{
+		terminaTarea(c);
+		return;
+	}
+
+	// Se calcula qué atleta ha de entrar en la tarima y también lo que le sucede al atleta. Además se guarda en el fichero log la hora a la que realizó el levantamiento.
+	switch (tarima->paso)
+	{
+		case JUEZ_ELIGE:
+			if (pthread_mutex_lock(&c->semaforo_tarimas)!=0)
+			{
+				perror("Error en el bloqueo del semáforo de las tarimas.\n");
+				exit(-1);
+			}
+
+				// Si la tarima se está cerrando y ya no le queda nadie en la cola el juez se va.
+				recogida=0;
+				if (tarima->estado==TARIMA_CERRANDO && colaTarima(c, numero)==0)
+				{
+					tarima->estado=TARIMA_CERRADA;
+					tarima->t_abierta += marcaTiempo()-tarima->t_apertura;
+					c->tarimasCerradasTotal++;
+					recogida=1;
+				}
+
+				tarima->atleta_cogido=10000;
+				tarima->ayuda=0;
+				if (recogida==0)
+				{
+					tarima->atleta_cogido = eligeAtleta(c, numero, &tarima->ayuda);
+				}
+
+				// Si no hay nadie en ninguna cola el juez duerme hasta que meteEnCola lo despierte (o se cierre su tarima).
+				ocioso=0;
+				if (recogida==0 && tarima->atleta_cogido==10000)
+				{
+					tarima->ocioso=1;
+					c->juecesOciosos++;
+					ocioso=1;
+				}
+				if (tarima->atleta_cogido!=10000)
+				{
+					atleta = &c->atletas[tarima->atleta_cogido];
+					sacaDeCola(c, tarima->atleta_cogido);
+					atleta->ha_competido=1; // Se marca antes de soltar el semáforo para que no lo coja también otra tarima.
+					atleta->juez=tarea;
+					suceso.tipo = SUCESO_LLAMADO;
+					suceso.dorsal = atleta->id;
+					suceso.tarima = numero;
+					suceso.inscripcion = atleta->t_inscripcion;
+					suceso.hora = marcaTiempo();
+					tarima->esperas[tarima->numEsperas%VENTANA_ESPERAS] = suceso.hora-suceso.inscripcion;
+					publicaSuceso(&c->bus, &suceso);
+					tarima->numEsperas++;
+					programaTarea(&atleta->tarea, 0); // Se despierta al atleta para que vaya a calentar (después de publicarlo, así sus sucesos van detrás).
+				}
+
+			if (pthread_mutex_unlock(&c->semaforo_tarimas)!=0)
+			{
+				perror("Error en el desbloqueo del semáforo de las tarimas.\n");
+				exit(-1);
+			}
+
+			if (recogida==1)
+			{
+				registraEvento(c, EVENTO_TARIMA_RECOGIDA, numero, 0, 0);
+				terminaTarea(c);
+				return;
+			}
+			if (ocioso==1) return; // Sigue en JUEZ_ELIGE; después de soltar el semáforo ya no se toca la tarea.
+
+			// Si ayuda a la otra tarima espera un segundo más para que puntúe primero el de la otra tarima.
+			tarima->paso = JUEZ_LLAMA;
+			programaTarea(tarea, tiempoCampeonato(2 + tarima->ayuda));
+			return;
+
+		case JUEZ_LLAMA:
+			// Si el atleta ha sido escogido, entonces se calcula su comportamiento.
+			tarima->t_llamada = marcaTiempo();
+			tarima->comportamiento = aleatorio(ALEATORIO_COMPORTAMIENTO); // Número aleatorio para calcular el comportamiento.
+			tarima->paso = JUEZ_ESPERA_CALENTAMIENTO;
+			// Sigue sin esperar.
+
+		case JUEZ_ESPERA_CALENTAMIENTO:
+			if (esperaAviso(&c->atletas[tarima->atleta_cogido].calentamiento)==1) return; // Se espera a que realice el calentamiento (lo despierta el atleta).
+
+			// El levantamiento dura según cómo le vaya.
+			if (tarima->comportamiento <=8) tiempo = aleatorio(ALEATORIO_VALIDO); // Movimiento válido.
+			else if (tarima->comportamiento == 9) tiempo = aleatorio(ALEATORIO_INDUMENTARIA); // Movimiento nulo por indumentaria.
+			else tiempo = aleatorio(ALEATORIO_FUERZA); // Movimiento nulo por falta de fuerza.
+
+			tarima->paso = JUEZ_PUNTUA;
+			programaTarea(tarea, tiempoCampeonato(tiempo));
+			return;
+
+		case JUEZ_PUNTUA:
+			atleta = &c->atletas[tarima->atleta_cogido];
+
+			if (tarima->comportamiento <=8) // Movimiento válido.
+			{
+				puntuacion = aleatorio(ALEATORIO_PUNTUACION);
+				atleta->puntuacion = puntuacion;
+				suceso.resultado = RESULTADO_VALIDO;
+			}
+			else if(tarima->comportamiento == 9) // Movimiento nulo por indumentaria.
+			{
+				atleta->puntuacion = 0;
+				suceso.resultado = RESULTADO_NULO_INDUMENTARIA;
+			}
+			else // Movimiento nulo por falta de fuerza.
+			{
+				atleta->puntuacion = 0;
+				suceso.resultado = RESULTADO_NULO_FUERZA;
+			}
+			suceso.hora = marcaTiempo();
+
+			// Se calcula si el atleta necesita beber o no.
+			if (aleatorio(ALEATORIO_BEBER) == 1)
+			{
+				atleta->necesita_beber=1;
+			}
+
+
+			// Se publica la puntuación con todo el levantamiento: el log, el podio (y la clasificación que ve el coordinador),
+			// las métricas y el almacén de resultados se enteran por el bus, ya fuera de la tarima.
+			suceso.tipo = SUCESO_PUNTUADO;
+			suceso.dorsal = atleta->id;
+			suceso.tarima = numero;
+			suceso.valor = atleta->puntuacion;
+			suceso.agua = atleta->necesita_beber;
+			suceso.inscripcion = atleta->t_inscripcion;
+			suceso.llamada = tarima->t_llamada;
+			publicaSuceso(&c->bus, &suceso);
+
+			if (atleta->necesita_beber==1)
+			{
+				anunciaSuceso(c, SUCESO_NECESITA_AGUA, atleta->id, numero, 0);
+			}
+
+
+			// Finaliza el atleta que está participando (a partir de aquí el juez ya no lo toca).
+			atleta->ha_competido=2;
+			daAviso(&atleta->levantado, &atleta->tarea);
+
+
+			// Se comprueba si al juez le toca descansar (por defecto cada 4 atletas 10 segundos) y si puede hacerlo ya.
+			tarima->descansa++;
+			tarima->contador++;
+
+			if (tarima->descansa < descansoCada)
+			{
+				tarima->paso = JUEZ_ELIGE;
+				programaTarea(tarea, 0);
+				return;
+			}
+			// Sigue pidiendo el descanso.
+
+		case JUEZ_ESPERA_DESCANSO:
+			descanso = pideDescanso(c, numero);
+			if (descanso==0) // Aplazado: sigue juzgando.
+			{
+				tarima->paso = JUEZ_ELIGE;
+				programaTarea(tarea, 0);
+			}
+			else if (descanso==2) // No hay hueco: lo vuelve a pedir dentro de un segundo.
+			{
+				tarima->paso = JUEZ_ESPERA_DESCANSO;
+				programaTarea(tarea, tiempoReintento(1));
+			}
+			else
+			{
+				// Inicio descanso.
+				registraEvento(c, EVENTO_DESCANSA, numero, 0, 0);
+
+				tarima->inicioDescanso = marcaTiempo();
+				tarima->paso = JUEZ_FIN_DESCANSO;
+				programaTarea(tarea, tiempoCampeonato(descansoDuracion));
+			}
+			return;
+
+		case JUEZ_FIN_DESCANSO:
+			terminaDescanso(c, numero, tarima->inicioDescanso);
+
+			// Fin descanso.
+			registraEvento(c, EVENTO_FIN_DESCANSO, numero, 0, 0);
+
+			tarima->descansa = 0;
+			tarima->paso = JUEZ_ELIGE;
+			programaTarea(tarea, 0);
+			return;
+	}
+}
+
+
+void inscribeCarga (int tarima)
+{
+	int i;
+
+	for (i=0; i<numCampeonatos; i++)
+	{
+		if (inscribeAtleta(campeonatos[i], tarima)==-1 && campeonatos[i]->finalizar==0) campeonatos[i]->sinSitioCarga++;
+	}
+}
+
+
+int sigueCarga ()
+{
+	int i;
+
+	for (i=0; i<numCampeonatos; i++)
+	{
+		if (campeonatos[i]->finalizar==0) return 1;
+	}
+	return 0;
+}
+
+
+void acabaCarga ()
+{
+	int i;
+
+	for (i=0; i<numCampeonatos; i++)
+	{
+		pideFinal(campeonatos[i]);
+	}
+}
+
+
+void resumeCarga (struct campeonato *c)
+{
+	int pedido;
+	int conseguido;
+
+	registraEvento(c, EVENTO_CARGA, 0, (int)carga.llegadas, c->sinSitioCarga);
+	if (ritmosCarga(&carga, &pedido, &conseguido)==1) registraEvento(c, EVENTO_CARGA_RITMO, 0, pedido, conseguido);
+	else registraEvento(c, EVENTO_CARGA_SIN_RITMO, 0, (int)carga.llegadas, conseguido);
+	registraEvento(c, EVENTO_CARGA_RETRASO, 0, carga.llegadas>0 ? (int)(carga.retrasoTotal/carga.llegadas/1000) : 0, (int)(carga.retrasoMaximo/1000));
+}
+
+
+void resumeDurabilidad (struct campeonato *c)
+{
+	// Son los de todo el proceso (todos los log y el almacén) hasta ahora; el cierre de cada fichero aún hace un fdatasync más.
+	registraEvento(c, EVENTO_DURABILIDAD, 0, (int)durabilidad.registros, (int)durabilidad.llamadas);
+	registraEvento(c, EVENTO_DURABILIDAD_LATENCIA, 0, durabilidad.registros>0 ? (int)(durabilidad.latenciaTotal/durabilidad.registros/1000) : 0, (int)(durabilidad.latenciaMaxima/1000));
+}
+
+
+void exportaCampeonato (struct campeonato *c)
+{
+	char nombre[TAMNOMBRE];
+	int64_t bytes;
+
+	// Cada campeonato y cada fragmento tiene su fichero, como su log.
+	snprintf(nombre, TAMNOMBRE, "%s", FICHERO_COLUMNAS);
+	if (modoAnfitrion==1) snprintf(nombre, TAMNOMBRE, FORMATO_COLUMNAS_CAMPEONATO, c->numero);
+	else if (fragmento>0) snprintf(nombre, TAMNOMBRE, FORMATO_COLUMNAS_FRAGMENTO, fragmento);
+
+	bytes = escribeColumnas(&c->exportacion, nombre, c->numero, tiempoCampeonato(1), durabilidad.modo!=DURABILIDAD_NADA);
+	if (bytes>=0) registraEvento(c, EVENTO_COLUMNAS, 0, c->exportacion.numLevantamientos, (int)bytes);
+}
+
+
+void finalizaCompeticion (int sig)
+{
+	int i;
+
+
+	if (signal(SIGINT, finalizaCompeticion)==SIG_ERR)
+	{
+		perror("Error en la llamada a la señal SIGINT.\n");
+		exit(-1);
+	}
+
+	for (i=0; i<numCampeonatos; i++)
+	{
+		pideFinal(campeonatos[i]);
+	}
+}
+
+
+void pideFinal (struct campeonato *c)
+{
+	// Sólo la primera vez que se pide.
+	if (__sync_bool_compare_and_swap(&c->finPedido, 0, 1))
+	{
+		programaTarea(&c->fin, 0);
+	}
+}
+
+
+void pasoFinal (struct tarea *tarea)
+{
+	struct campeonato *c = (struct campeonato*)tarea->datos;
+	int i;
+
+
+	if (c->pasoFin==0)
+	{
+		registraEvento(c, EVENTO_PULSADO_FIN, 0, 0, 0);
+		c->finalizar=1; // Las tareas del campeonato acaban en cuanto vuelven a ejecutarse.
+
+
+		// Se escribe en el log que ha finalizado el programa (después de lo que ya se había publicado).
+		vaciaEtapas(c);
+		registraEvento(c, EVENTO_FIN_PROGRAMA, 0, 0, 0);
+
+		c->pasoFin=1;
+		programaTarea(tarea, tiempoCampeonato(3));
+		return;
+	}
+
+
+	// Los que esperan un aviso no están en el planificador: se les despierta para que vean que se ha acabado.
+	for (i=0; i<c->maxAtletas; i++)
+	{
+		if (c->atletas[i].calentamiento==AVISO_ESPERANDO) daAviso(&c->atletas[i].calentamiento, c->atletas[i].juez);
+		if (c->atletas[i].levantado==AVISO_ESPERANDO) daAviso(&c->atletas[i].levantado, &c->atletas[i].tarea);
+	}
+	if (pthread_mutex_lock(&c->semaforo_tarimas)!=0)
+	{
+		perror("Error en el bloqueo del semáforo de las tarimas.\n");
+		exit(-1);
+	}
+		despiertaJueces(c, 0); // Los jueces ociosos tampoco están en el planificador.
+	if (pthread_mutex_unlock(&c->semaforo_tarimas)!=0)
+	{
+		perror("Error en el desbloqueo del semáforo de las tarimas.\n");
+		exit(-1);
+	}
+
+	// Se quitan del planificador las tareas que estaban esperando; las que están dando un paso en este momento acaban solas.
+	for (i=0; i<c->maxAtletas; i++)
+	{
+		if (cancelaTarea(&c->atletas[i].tarea)==1) terminaTarea(c);
+	}
+	for (i=0; i<c->numTarimas; i++)
+	{
+		if (cancelaTarea(&c->punteroTarimas[i].tatami)==1) terminaTarea(c);
+	}
+	if (cancelaTarea(&c->controlador)==1) terminaTarea(c);
+	if (cancelaTarea(&c->vaciado)==1) terminaTarea(c);
+	cancelaTarea(&c->bus.tarea); // No cuentan entre las vivas: lo que quede se reparte aquí.
+	cancelaTarea(&c->etapaLog.tarea);
+	cancelaTarea(&c->etapaAlmacen.tarea);
+
+	if (c->tareasVivas>0)
+	{
+		programaTarea(tarea, 1000000); // Se vuelve a mirar en un milisegundo.
+		return;
+	}
+
+
+	// Ya no publica nadie: se reparten los últimos sucesos y la fuente queda como la dejó el último en llegar.
+	vaciaEtapas(c);
+
+	// Se escribe en el log qué atleta se ha ido sin beber.
+	if (c->estadoFuente!=0)
+	{
+		registraEvento(c, EVENTO_SIN_BEBER, c->colaFuente, 0, 0);
+	}
+
+	registraEvento(c, EVENTO_RESULTADOS, 0, 0, 0);
+
+
+	// Se escribe en el log los atletas que han pasado por cada tarima.
+	for(i=1; i<=c->numTarimas; i++)
+	{
+		registraEvento(c, EVENTO_TOTAL_TARIMA, i, c->punteroTarimas[i-1].contador, 0);
+	}
+	resumeDescansos(c);
+	if (c->maxTarimas>c->minTarimas)
+	{
+		registraEvento(c, EVENTO_TARIMAS_TOTAL, 0, c->tarimasAbiertasTotal, c->tarimasCerradasTotal);
+	}
+	resumeSucesos(c);
+	if (conCarga==1) resumeCarga(c);
+	if (durabilidad.modo!=DURABILIDAD_NADA) resumeDurabilidad(c);
+	if (exportaColumnas==1) exportaCampeonato(c);
+
+
+	// Podio.
+	registraEvento(c, EVENTO_PRIMERO, 0, c->podio[0][0], c->podio[1][0]);
+	registraEvento(c, EVENTO_SEGUNDO, 0, c->podio[0][1], c->podio[1][1]);
+	registraEvento(c, EVENTO_TERCERO, 0, c->podio[0][2], c->podio[1][2]);
+
+
+	cierraSumideros(c); // Se escribe lo que quede pendiente y se cierra el log.
+
+	campeonatoTerminado(); // La memoria del campeonato la libera el hilo principal cuando acaban todos.
+}
+
+
+void campeonatoTerminado()
+{
+	char aviso = 1;
+
+	if (__sync_sub_and_fetch(&campeonatosActivos, 1)==0)
+	{
+		if (write(tuberiaFin[1], &aviso, 1)!=1)
+		{
+			perror("Error al avisar del fin de los campeonatos.\n");
+			exit(-1);
+		}
+	}
+}
+
+
+void ejecutaOrden (char *linea)
+{
+	char orden[32];
+	int numero;
+	int tarima;
+	int leidos;
+	struct campeonato *c;
+	int i;
+
+	// Órdenes del modo anfitrión: "N inscribe [T]", "N clasificacion", "N fin" o "fin" para acabar todos.
+	if (sscanf(linea, "%31s", orden)==1 && strcmp(orden, "fin")==0)
+	{
+		for (i=0; i<numCampeonatos; i++)
+		{
+			pideFinal(campeonatos[i]);
+		}
+		return;
+	}
+
+	tarima = 0;
+	leidos = sscanf(linea, "%d %31s %d", &numero, orden, &tarima);
+	if (leidos<2 || numero<1 || numero>numCampeonatos)
+	{
+		fprintf(stderr, "Orden desconocida: %s", linea);
+		return;
+	}
+	c = campeonatos[numero-1];
+
+	if (strcmp(orden, "inscribe")==0)
+	{
+		inscribeAtleta(c, tarima); // Sin tarima (o con una que no está abierta) va a la cola más corta.
+	}
+	else if (strcmp(orden, "clasificacion")==0 && c->finalizar==0)
+	{
+		vaciaEtapas(c); // Con todas las puntuaciones publicadas hasta ahora (y escritas en el log antes que la clasificación).
+		for (i=0; i<3; i++)
+		{
+			registraEvento(c, EVENTO_CLASIFICACION, i+1, c->podio[0][i], c->podio[1][i]);
+		}
+	}
+	else if (strcmp(orden, "fin")==0)
+	{
+		pideFinal(c);
+	}
+	else
+	{
+		fprintf(stderr, "Orden desconocida: %s", linea);
+	}
+}
+
+
+int parteFragmento (int total, int numero)
+{
+	int parte = total/numFragmentos + (numero<=total%numFragmentos ? 1 : 0);
+
+	return (parte>0) ? parte : 1;
+} // Lo que le toca al fragmento numero (de 1 en adelante) al repartir total entre todos; al menos 1.
+
+
+void repartoNucleosJueces (int numero)
+{
+	int contados = 0;
+	int i;
+
+	// Los núcleos de los jueces se reparten por turnos para que dos fragmentos no se fijen al mismo.
+	if (CPU_COUNT(&colocacionJueces.nucleos)>=numFragmentos)
+	{
+		for (i=0; i<CPU_SETSIZE; i++)
+		{
+			if (!CPU_ISSET(i, &colocacionJueces.nucleos)) continue;
+			if (contados%numFragmentos!=numero-1) CPU_CLR(i, &colocacionJueces.nucleos);
+			contados++;
+		}
+	}
+	if (colocacionJueces.hilos>1) colocacionJueces.hilos = parteFragmento(colocacionJueces.hilos, numero);
+}
+
+
+void lanzaFragmentos()
+{
+	struct campeonato *c;
+	struct fragmentoCompartido copia;
+	int dorsales[TOPFRAGMENTO];
+	int puntuaciones[TOPFRAGMENTO];
+	int tuberia[2];
+	int vivos;
+	int estado;
+	int n;
+	int i;
+	int j;
+
+	snprintf(nombreZona, sizeof(nombreZona), FORMATO_ZONA_FRAGMENTOS, getpid());
+	zonaFragmentos = creaZonaFragmentos(nombreZona, numFragmentos);
+	if (zonaFragmentos==NULL)
+	{
+		perror("Error en la creación de la memoria compartida de los fragmentos.\n");
+		exit(-1);
+	}
+
+
+	// Se crean los fragmentos antes de que haya ningún hilo, cada uno con su tubería de inscripciones.
+	for (i=0; i<numFragmentos; i++)
+	{
+		if (pipe(tuberia)!=0)
+		{
+			perror("Error en la creación de la tubería de un fragmento.\n");
+			exit(-1);
+		}
+
+		pidsFragmentos[i] = fork();
+		if (pidsFragmentos[i]<0)
+		{
+			perror("Error en la creación de un fragmento.\n");
+			exit(-1);
+		}
+
+		if (pidsFragmentos[i]==0)
+		{
+			// Fragmento: se queda sólo con su tubería de lectura y con su parte del campeonato.
+			for (j=0; j<i; j++)
+			{
+				close(tuberiasFragmentos[j]);
+			}
+			close(tuberia[1]);
+			tuberiaPedidos = tuberia[0];
+
+			fragmento = i+1;
+			miFragmento = &zonaFragmentos->fragmentos[i];
+			atletasPedidos = parteFragmento(atletasPedidos, fragmento);
+			tarimasPedidas = parteFragmento(tarimasPedidas, fragmento);
+			tarimasMaximas = parteFragmento(tarimasMaximas, fragmento);
+			if (tarimasMaximas<tarimasPedidas) tarimasMaximas = tarimasPedidas;
+			if (numHilos>1) numHilos = parteFragmento(numHilos, fragmento); // Entre todos los fragmentos, un hilo por núcleo.
+			repartoNucleosJueces(fragmento);
+
+			miFragmento->pid = getpid();
+			miFragmento->capacidad = atletasPedidos;
+			return;
+		}
+
+		close(tuberia[0]);
+		tuberiasFragmentos[i] = tuberia[1];
+		enviados[i] = 0;
+	}
+
+
+	// Coordinador: sólo escribe sus mensajes (con el log de siempre) y reparte las inscripciones.
+	c = creaCampeonato(0, 1, 1, 1);
+	if (c==NULL)
+	{
+		perror("Error en la creación del fichero.\n");
+		exit(-1);
+	}
+	registraEvento(c, EVENTO_PID, 0, getpid(), 0);
+	registraEvento(c, EVENTO_COMIENZO, 0, 0, 0);
+	registraEvento(c, EVENTO_FRAGMENTOS, 0, numFragmentos, 0);
+
+	if (signal(SIGUSR1, asignaInscripcion)==SIG_ERR)
+	{
+		perror("Error en la llamada a la señal SIGUSR1.\n");
+		exit(-1);
+	}
+
+	if (signal(SIGUSR2, asignaInscripcion)==SIG_ERR)
+	{
+		perror("Error en la llamada a la señal SIGUSR2.\n");
+		exit(-1);
+	}
+
+	if (signal(SIGINT, terminaFragmentos)==SIG_ERR)
+	{
+		perror("Error en la llamada a la señal SIGINT.\n");
+		exit(-1);
+	}
+	signal(SIGPIPE, SIG_IGN); // Si un fragmento ya ha terminado se pierde la inscripción en lugar de acabar el coordinador.
+
+
+	// Se espera a que acaben todos los fragmentos.
+	vivos = numFragmentos;
+	while (vivos>0)
+	{
+		if (waitpid(-1, &estado, 0)>0) vivos--;
+		else if (errno!=EINTR) break;
+	}
+
+	signal(SIGUSR1, SIG_IGN);
+	signal(SIGUSR2, SIG_IGN);
+	signal(SIGINT, SIG_IGN);
+
+
+	// Se juntan los resultados de todos los fragmentos.
+	registraEvento(c, EVENTO_RESULTADOS, 0, 0, 0);
+	for (i=0; i<numFragmentos; i++)
+	{
+		leeFragmento(&zonaFragmentos->fragmentos[i], &copia);
+		registraEvento(c, EVENTO_TOTAL_FRAGMENTO, i+1, copia.levantamientos, copia.inscritos);
+	}
+
+	n = mezclaClasificacion(zonaFragmentos, dorsales, puntuaciones, TOPFRAGMENTO);
+	for (i=n; i<3; i++)
+	{
+		dorsales[i] = 0;
+		puntuaciones[i] = 0;
+	}
+
+	// Podio.
+	registraEvento(c, EVENTO_PRIMERO, 0, dorsales[0], puntuaciones[0]);
+	registraEvento(c, EVENTO_SEGUNDO, 0, dorsales[1], puntuaciones[1]);
+	registraEvento(c, EVENTO_TERCERO, 0, dorsales[2], puntuaciones[2]);
+
+	for (i=0; i<n; i++)
+	{
+		registraEvento(c, EVENTO_CLASIFICACION, i+1, dorsales[i], puntuaciones[i]);
+	}
+
+	cierraSumideros(c);
+	destruyeCampeonato(c);
+	borraZonaFragmentos(nombreZona, zonaFragmentos);
+	exit(0);
+}
+
+
+void asignaInscripcion (int sig)
+{
+	int tarima = 0; // Dentro del fragmento va a la tarima con la cola más corta.
+	int elegido;
+
+	if (signal(sig, asignaInscripcion)==SIG_ERR)
+	{
+		perror("Error en la llamada a la señal de inscripción.\n");
+		exit(-1);
+	}
+
+	// Cada inscripción va al fragmento con menos huecos ocupados (contando las que aún no ha leído).
+	elegido = fragmentoMenosCargado(zonaFragmentos, enviados);
+	if (write(tuberiasFragmentos[elegido], &tarima, sizeof(int))==sizeof(int))
+	{
+		enviados[elegido]++;
+	}
+}
+
+
+void terminaFragmentos (int sig)
+{
+	int i;
+
+	if (signal(SIGINT, terminaFragmentos)==SIG_ERR)
+	{
+		perror("Error en la llamada a la señal SIGINT.\n");
+		exit(-1);
+	}
+
+	for (i=0; i<numFragmentos; i++)
+	{
+		kill(pidsFragmentos[i], SIGINT);
+	}
+}
+
+
+int colaTarima (struct campeonato *c, int numero)
+{
+	return c->punteroTarimas[numero-1].enCola;
+} // Atletas esperando en la cola de la tarima (sólo orientativo, se cuenta sin semáforo).
+
+
+int pideDescanso (struct campeonato *c, int numero)
+{
+	struct tarimasCompeticion *tarima = &c->punteroTarimas[numero-1];
+	int obligado = (tarima->descansa >= 2*descansoCada); // Un descanso no se aplaza más de otros tantos atletas.
+	int enCola = colaTarima(c, numero);
+	int concedido = 1;
+
+	if (pthread_mutex_lock(&c->semaforo_descansos)!=0)
+	{
+		perror("Error en el bloqueo del semáforo de los descansos.\n");
+		exit(-1);
+	}
+
+		// Con la cola larga o con demasiados jueces descansando se sigue juzgando y se vuelve a pedir tras el siguiente atleta.
+		if (!obligado && ((colaLarga>0 && enCola>=colaLarga) || (maxDescansando>0 && c->juecesDescansando>=maxDescansando)))
+		{
+			concedido = 0;
+			if (tarima->descansa==descansoCada) tarima->aplazados++;
+		}
+		else if (maxDescansando>0 && c->juecesDescansando>=maxDescansando)
+		{
+			concedido = 2; // Ya no se puede aplazar más: espera a que acabe otro.
+		}
+		else
+		{
+			c->juecesDescansando++;
+		}
+
+	if (pthread_mutex_unlock(&c->semaforo_descansos)!=0)
+	{
+		perror("Error en el desbloqueo del semáforo de los descansos.\n");
+		exit(-1);
+	}
+
+	if (concedido==0 && tarima->descansa==descansoCada)
+	{
+		registraEvento(c, EVENTO_APLAZA_DESCANSO, numero, enCola, 0);
+	}
+	return concedido;
+}
+
+
+void terminaDescanso (struct campeonato *c, int numero, int64_t inicio)
+{
+	if (pthread_mutex_lock(&c->semaforo_descansos)!=0)
+	{
+		perror("Error en el bloqueo del semáforo de los descansos.\n");
+		exit(-1);
+	}
+
+		c->juecesDescansando--;
+		c->punteroTarimas[numero-1].descansos++;
+		c->punteroTarimas[numero-1].t_descanso += marcaTiempo()-inicio;
+
+	if (pthread_mutex_unlock(&c->semaforo_descansos)!=0)
+	{
+		perror("Error en el desbloqueo del semáforo de los descansos.\n");
+		exit(-1);
+	}
+}
+
+
+void resumeDescansos (struct campeonato *c)
+{
+	int64_t ahora = marcaTiempo();
+	int64_t abierta;
+	int64_t trabajando;
+	int perdidos;
+	int totalPerdidos = 0;
+	int totalHechos = 0;
+	int i;
+
+	// Lo que se pierde en cada tarima se estima con el ritmo al que ha juzgado mientras no descansaba (y sólo mientras estaba abierta).
+	for (i=0; i<c->numTarimas; i++)
+	{
+		abierta = c->punteroTarimas[i].t_abierta;
+		if (c->punteroTarimas[i].estado!=TARIMA_CERRADA) abierta += ahora-c->punteroTarimas[i].t_apertura;
+
+		trabajando = abierta-c->punteroTarimas[i].t_descanso;
+		perdidos = 0;
+		if (trabajando>0) perdidos = (int)((double)c->punteroTarimas[i].contador*c->punteroTarimas[i].t_descanso/trabajando + 0.5);
+
+		registraEvento(c, EVENTO_DESCANSOS, i+1, c->punteroTarimas[i].descansos, c->punteroTarimas[i].aplazados);
+		registraEvento(c, EVENTO_DESCANSOS_PERDIDOS, i+1, abierta>0 ? (int)(100*c->punteroTarimas[i].t_descanso/abierta) : 0, perdidos);
+		totalPerdidos += perdidos;
+		totalHechos += c->punteroTarimas[i].contador;
+	}
+	registraEvento(c, EVENTO_PERDIDOS_TOTAL, 0, totalPerdidos, totalPerdidos+totalHechos);
+}
+
+
+int tarimaMasCorta (struct campeonato *c)
+{
+	int mejor = 1;
+	int menor = -1;
+	int enCola;
+	int i;
+
+	for (i=0; i<c->numTarimas; i++)
+	{
+		if (c->punteroTarimas[i].estado!=TARIMA_ABIERTA) continue;
+
+		enCola = colaTarima(c, i+1);
+		if (menor==-1 || enCola<menor)
+		{
+			menor = enCola;
+			mejor = i+1;
+		}
+	}
+	return mejor;
+}
+
+
+void mueveAtleta (struct campeonato *c, int pos, int destino)
+{
+	registraEvento(c, EVENTO_CAMBIA_TARIMA, c->atletas[pos].id, c->atletas[pos].tarima_asignada, destino);
+	sacaDeCola(c, pos);
+	meteEnCola(c, pos, destino);
+} // Se llama con semaforo_tarimas bloqueado para que ningún juez lo esté eligiendo a la vez.
+
+
+void reparteCola (struct campeonato *c, int destino)
+{
+	int origen;
+	int mayor;
+	int enCola;
+	int ultimo;
+	int i;
+
+	// Se pasan a la tarima nueva los últimos en llegar a las colas más largas hasta que queden igualadas.
+	do
+	{
+		origen = 0;
+		mayor = colaTarima(c, destino)+1;
+		for (i=0; i<c->numTarimas; i++)
+		{
+			if (i+1==destino || c->punteroTarimas[i].estado!=TARIMA_ABIERTA) continue;
+
+			enCola = colaTarima(c, i+1);
+			if (enCola>mayor)
+			{
+				mayor = enCola;
+				origen = i+1;
+			}
+		}
+
+		if (origen!=0)
+		{
+			ultimo = c->punteroTarimas[origen-1].ultimoCola;
+			mueveAtleta(c, ultimo, destino);
+		}
+	}while (origen!=0);
+}
+
+
+void vaciaTarima (struct campeonato *c, int origen)
+{
+	int destino;
+
+	// Los que esperaban en una tarima que ya no está abierta pasan a la cola más corta.
+	while (c->punteroTarimas[origen-1].primeroCola!=-1)
+	{
+		destino = tarimaMasCorta(c);
+		if (destino==origen) return; // No queda ninguna abierta.
+
+		mueveAtleta(c, c->punteroTarimas[origen-1].primeroCola, destino);
+	}
+}
+
+
+int comparaEsperas (const void *a, const void *b)
+{
+	int64_t x = *(int64_t*)a;
+	int64_t y = *(int64_t*)b;
+
+	return (x>y) - (x<y);
+}
+
+
+int64_t esperaTarima (struct campeonato *c, int numero, int64_t *esperas)
+{
+	struct tarimasCompeticion *tarima = &c->punteroTarimas[numero-1];
+	int64_t ahora = marcaTiempo();
+	int n = 0;
+	int i;
+
+	// Cuentan las últimas esperas ya terminadas y lo que llevan esperando los que siguen en la cola.
+	for (i=0; i<tarima->numEsperas && i<VENTANA_ESPERAS; i++)
+	{
+		esperas[n++] = tarima->esperas[i];
+	}
+	for (i=tarima->primeroCola; i!=-1; i=c->atletas[i].siguienteCola)
+	{
+		esperas[n++] = ahora-c->atletas[i].t_inscripcion;
+	}
+
+	if (n==0) return 0;
+	qsort(esperas, n, sizeof(int64_t), comparaEsperas);
+	return esperas[(9*n+9)/10-1];
+}
+
+
+int abreTarima (struct campeonato *c)
+{
+	struct tarimasCompeticion *tarima;
+	int i;
+
+	// Se usa el primer hueco cerrado (los de las tarimas iniciales nunca se cierran).
+	for (i=c->minTarimas; i<c->maxTarimas && c->punteroTarimas[i].estado!=TARIMA_CERRADA; i++);
+	if (i==c->maxTarimas) return -1;
+
+	tarima = &c->punteroTarimas[i];
+	tarima->estado=TARIMA_ABIERTA;
+	tarima->t_apertura=marcaTiempo();
+	tarima->numEsperas=0;
+	tarima->descansa=0;
+	tarima->paso=JUEZ_ELIGE;
+	if (i>=c->numTarimas) c->numTarimas=i+1;
+	c->tarimasAbiertas++;
+	c->tarimasAbiertasTotal++;
+	__sync_fetch_and_add(&c->tareasVivas, 1);
+	programaTarea(&tarima->tatami, 0);
+
+	reparteCola(c, i+1);
+	return i+1;
+} // Se llama con semaforo_tarimas bloqueado.
+
+
+void cierraTarima (struct campeonato *c, int numero)
+{
+	c->punteroTarimas[numero-1].estado=TARIMA_CERRANDO;
+	c->tarimasAbiertas--;
+	registraEvento(c, EVENTO_CIERRA_TARIMA, 0, numero, 0);
+	vaciaTarima(c, numero);
+	despiertaJueces(c, 0); // Si su juez dormía sin nadie a quien llamar, se despierta para irse.
+} // Se llama con semaforo_tarimas bloqueado; el juez termina con su atleta y se va.
+
+
+void pasoControlador (struct tarea *tarea)
+{
+	struct campeonato *c = (struct campeonato*)tarea->datos;
+	int64_t umbral;
+	int64_t espera;
+	int64_t mayorEspera;
+	int totalCola;
+	int candidata;
+	int numero;
 	int i;
-	int j;
-	int atl_tar[numTarimas]; // Representa el atleta que está esperando en la cola de cada tarima.
-	int atleta_cogido; // Se guarda la posición del atleta en la cola que va a entrar en la tarima.
-	char *id;
-	char *msg;
-	
-	id = (char*)malloc(sizeof(char)*30);
-	msg = (char*)malloc(sizeof(char)*256);
 
+	if (c->finalizar==1)
+	{
+		terminaTarea(c);
+		return;
+	}
 
-	// Se calcula qué atleta ha de entrar en la tarima y también lo que le sucede al atleta. Además se guarda en el fichero log la hora a la que realizó el levantamiento.
-	do 
+	// El umbral está en segundos del campeonato, con la misma escala que el resto de esperas (nunca es 0: sin tiempo virtual no se arranca el control).
+	umbral = tiempoCampeonato(esperaP90);
+
+	if (pthread_mutex_lock(&c->semaforo_tarimas)!=0)
 	{
-		if (pthread_mutex_lock(&semaforo_tarimas)!=0)
+		perror("Error en el bloqueo del semáforo de las tarimas.\n");
+		exit(-1);
+	}
+
+		// Los que se inscribieron en una tarima justo cuando se cerraba se reparten.
+		for (i=0; i<c->numTarimas; i++)
 		{
-			perror("Error en el bloqueo del semáforo de las tarimas.\n");
-			exit(-1);
+			if (c->punteroTarimas[i].estado!=TARIMA_ABIERTA) vaciaTarima(c, i+1);
 		}
-			// Se inicializan los valores a un número suficientemente grande.
-			for (i=0; i<numTarimas; i++) 
-			{
-				atl_tar[i]=10000;
-			}
-			
-			atleta_cogido=10000;
 
-			// Se busca la posición del atleta que más tiempo lleva esperando (menor id) dentro de la cola de cada tarima.
-			for (j=1; j<=numTarimas; j++)
-			{
-				for (i=0; i<maxAtletas; i++)
-				{
-					if (atletas[i].id!=0 && atletas[i].ha_competido == 0)
-					{
-						if (atletas[i].tarima_asignada==j && atl_tar[j-1]>atletas[i].id)
-						{
-							atl_tar[j-1]=i;
-						}
-					}
-				}
-			}
-		
-			// Se asigna el atleta de la propia tarima que más tiempo lleva esperando y si no de la otra.
-			if (atl_tar[numero-1]!=10000)
-			{
-				atleta_cogido=atl_tar[numero-1];
-			}
-			else
-			{
-				for (i=0; i<numTarimas; i++)
-				{
-					if (atl_tar[i]!=10000)
-					{
-						atleta_cogido = atl_tar[i];
-						i=numTarimas; // Se sale del bucle.
-					}
-				}
-				sleep(1); // Si ayuda a la otra tarima duerme un segundo para que puntúe primero el de la otra tarima.
-			} 
-			sleep(2);
-		
-		if (pthread_mutex_unlock(&semaforo_tarimas)!=0)
+		mayorEspera = 0;
+		totalCola = 0;
+		for (i=0; i<c->numTarimas; i++)
 		{
-			perror("Error en el desbloqueo del semáforo de las tarimas.\n");
-			exit(-1);
+			if (c->punteroTarimas[i].estado!=TARIMA_ABIERTA) continue;
+
+			espera = esperaTarima(c, i+1, c->esperasControl);
+			c->punteroTarimas[i].numEsperas = 0; // Cada revisión sólo mira las esperas terminadas desde la anterior.
+			if (espera>mayorEspera) mayorEspera = espera;
+			totalCola += colaTarima(c, i+1);
 		}
-		
-		
-		// Si el atleta ha sido escogido, entonces se calcula su comportamiento.
-		if (atleta_cogido!=10000)
+
+		// Se abre otra tarima si alguna cola espera demasiado y se cierra una de las añadidas si sobran jueces.
+		c->periodosQuietos++;
+		if (mayorEspera>=umbral && c->tarimasAbiertas<c->maxTarimas)
 		{
-			atletas[atleta_cogido].ha_competido=1;
-			comportamiento = calculaAleatorios(1,10); // Número aleatorio para calcular el comportamiento.
-		
-			while (atletas[atleta_cogido].calentamiento == 0) // Se espera ha que realice el calentamiento.
+			numero = abreTarima(c);
+			if (numero!=-1)
 			{
-				sleep(1);
+				registraEvento(c, EVENTO_ABRE_TARIMA, 0, numero, (int)(mayorEspera/tiempoCampeonato(1)));
+				c->periodosQuietos = 0;
 			}
-
-			if (comportamiento <=8) // Movimiento válido.
+		}
+		else if (c->periodosQuietos>=3 && mayorEspera<umbral/2 && totalCola<c->tarimasAbiertas)
+		{
+			candidata = 0;
+			for (i=c->numTarimas-1; i>=c->minTarimas && candidata==0; i--)
 			{
-				tiempo = calculaAleatorios(2,6);
-				sleep(tiempo);
-			
-				puntuacion = calculaAleatorios(60,300);
-				atletas[atleta_cogido].puntuacion = puntuacion;
-
-				// Se escribe en el log.
-				sprintf(id, "Juez %d", numero);  
-				sprintf(msg, "El dorsal %d hizo un levantamiento asombroso: %d puntos.", atletas[atleta_cogido].id, puntuacion);
-				printf("%s: %s\n", id, msg);
-		
-				if (pthread_mutex_lock(&semaforo_escribir)!=0)	
-				{
-					perror("Error en el bloqueo del semáforo para escribir en el fichero.\n");
-					exit(-1);
-				}
-				
-					writeLogMessage(id, msg); 
-
-				if (pthread_mutex_unlock(&semaforo_escribir)!=0) 
-				{
-					perror("Error en el desbloqueo del semáforo para escribir en el fichero.\n");
-					exit(-1);
-				}
-		
-			} 
-			else if(comportamiento == 9) // Movimiento nulo por indumentaria.
-				{
-					tiempo = calculaAleatorios(1,4);
-					sleep(tiempo);
-					
-					puntuacion = 0;
-					atletas[atleta_cogido].puntuacion = puntuacion;
-					
-					// Se escribe en el log.
-					sprintf(id, "Juez %d", numero);  
-					sprintf(msg, "El dorsal %d no lleva pantalones: ¡un CERO!.", atletas[atleta_cogido].id);
-					printf("%s: %s\n", id, msg);
-				
-					if (pthread_mutex_lock(&semaforo_escribir)!=0)
-					{
-						perror("Error en el bloqueo del semáforo para escribir en el fichero.\n");
-						exit(-1);
-					}
-				
-						writeLogMessage(id, msg); 
-
-					if (pthread_mutex_unlock(&semaforo_escribir)!=0)
-					{
-						perror("Error en el desbloqueo del semáforo para escribir en el fichero.\n");
-						exit(-1);
-					}
-				} 
-				else // Movimiento nulo por falta de fuerza.
-				{
-					tiempo = calculaAleatorios(6,10);
-					sleep(tiempo);
-					
-					puntuacion = 0;
-					atletas[atleta_cogido].puntuacion = puntuacion;
-
-					// Se escribe en el log.
-					sprintf(id, "Juez %d", numero);  
-					sprintf(msg, "El dorsal %d es un enclenque: ¡un CERO!.", atletas[atleta_cogido].id);
-					printf("%s: %s\n", id, msg);
-				
-					if (pthread_mutex_lock(&semaforo_escribir)!=0)
-					{
-						perror("Error en el bloqueo del semáforo para escribir en el fichero.\n");
-						exit(-1);
-					}
-				
-						writeLogMessage(id, msg); 
-
-					if (pthread_mutex_unlock(&semaforo_escribir)!=0)
-					{
-						perror("Error en el desbloqueo del semáforo para escribir en el fichero.\n");
-						exit(-1);
-					}
-				}
-	
-	
-			// Se guarda la puntuación en el podio.
-			for (i=0; i<3; i++)
+				if (c->punteroTarimas[i].estado==TARIMA_ABIERTA) candidata = i+1;
+			}
+			if (candidata!=0)
 			{
-				if (atletas[atleta_cogido].puntuacion>=podio[1][i])
-				{
-					if (i!=2) // Si no es la última posición se cambian los valores.
-					{
-						for (j=2; j>=i+1; j--)
-						{
-							podio[0][j] = podio[0][j-1];
-							podio[1][j] = podio[1][j-1];
-						}
-					}
-					
-					podio[0][i]=atletas[atleta_cogido].id;
-					podio[1][i]=atletas[atleta_cogido].puntuacion;
-					i=3;	
-				}	
+				cierraTarima(c, candidata);
+				c->periodosQuietos = 0;
 			}
-	
+		}
 
-			// Se calcula si el atleta necesita beber o no.
-			if (calculaAleatorios(1,10) == 1) 
-			{		
-				atletas[atleta_cogido].necesita_beber=1;
-				
-				sprintf(id, "Juez %d", numero);
-				sprintf(msg, "Dorsal %d necesitas ir a beber a la fuente.", atletas[atleta_cogido].id);   
-				printf("%s: %s\n", id, msg);
-			
-				if (pthread_mutex_lock(&semaforo_escribir)!=0)
-				{
-					perror("Error en el bloqueo del semáforo para escribir en el fichero.\n");
-					exit(-1);
-				}
-		
-					writeLogMessage(id, msg); 
+	if (pthread_mutex_unlock(&c->semaforo_tarimas)!=0)
+	{
+		perror("Error en el desbloqueo del semáforo de las tarimas.\n");
+		exit(-1);
+	}
 
-				if (pthread_mutex_unlock(&semaforo_escribir)!=0)
-				{
-					perror("Error en el desbloqueo del semáforo para escribir en el fichero.\n");
-					exit(-1);
-				}
-			}
-	
-	
-			// Finaliza el atleta que está participando.
-			atletas[atleta_cogido].ha_competido=2;
+	programaTarea(tarea, tiempoReintento(periodoControl));
+}
 
 
-			// Se comprueba si al juez le toca descansar (cada 4 atletas 10 segundos).
-			punteroTarimas[numero-1].descansa++;
-			punteroTarimas[numero-1].contador++;
+void  writeLogMessage (struct campeonato *c, int nivel, char *id, char *msg)
+{
+	// Se calcula la hora actual.
+	char  stnow [TAMHORA];
+	char linea[TAMLINEA];
+	int longitud;
+	int i;
 
-			if (punteroTarimas[numero-1].descansa == 4) 
-			{	
-				// Inicio descanso.
-				sprintf(id, "Juez %d", numero);  
-				sprintf(msg, "Esto es muy aburrido, me voy a descansar.");
-				printf("%s: %s\n", id, msg);
-					
-				if (pthread_mutex_lock(&semaforo_escribir)!=0)
-				{
-					perror("Error en el bloqueo del semáforo para escribir en el fichero.\n");
-					exit(-1);
-				}
-		
-					writeLogMessage(id, msg); 
+	formateaHora(stnow);
 
-				if (pthread_mutex_unlock(&semaforo_escribir)!=0)
-				{
-					perror("Error en el desbloqueo del semáforo para escribir en el fichero.\n");
-					exit(-1);
-				}
+	// Se escribe en el fichero log llamado registroTiempos.log y en el resto de sumideros que no son la pantalla.
+	for (i=0; i<c->numSumideros; i++)
+	{
+		if (c->sumideros[i].tipo==SUMIDERO_CONSOLA || c->sumideros[i].nivel<nivel) continue;
 
-				sleep(10);
-			
-				// Fin descanso.
-				sprintf(id, "Juez %d", numero);  
-				sprintf(msg, "Ya he acabado de descansar.");
-				printf("%s: %s\n", id, msg);
-					
-				if (pthread_mutex_lock(&semaforo_escribir)!=0)
-				{
-					perror("Error en el bloqueo del semáforo para escribir en el fichero.\n");
-					exit(-1);
-				}
-		
-					writeLogMessage(id, msg); 
+		if (c->sumideros[i].tipo==SUMIDERO_SYSLOG)
+		{
+			// Prioridad de syslog: usuario (1) y error (3), aviso (5) o información (6) según el nivel.
+			longitud = snprintf(linea, TAMLINEA, "<%d>powerlifting[%d]: %s%s: %s", 8 + (nivel==NIVEL_ERRORES ? 3 : nivel==NIVEL_RESUMENES ? 5 : 6), getpid(), c->prefijo, id, msg);
+			send(c->sumideros[i].fd, linea, longitud<TAMLINEA ? longitud : TAMLINEA-1, MSG_DONTWAIT);
+		}
+		else
+		{
+			longitud = snprintf(linea, TAMLINEA, "[ %s]  %s:  %s\n", stnow , id, msg);
+			escribeEnSumidero(&c->sumideros[i], linea, longitud<TAMLINEA ? longitud : TAMLINEA-1);
+		}
+	}
+}
 
-				if (pthread_mutex_unlock(&semaforo_escribir)!=0)
-				{
-					perror("Error en el desbloqueo del semáforo para escribir en el fichero.\n");
-					exit(-1);
-				}
 
-				punteroTarimas[numero-1].descansa = 0;
-			}
+int leeNivel (char *texto)
+{
+	if (strcmp(texto, "nada")==0) return NIVEL_NADA;
+	if (strcmp(texto, "errores")==0) return NIVEL_ERRORES;
+	if (strcmp(texto, "resumenes")==0) return NIVEL_RESUMENES;
+	if (strcmp(texto, "eventos")==0) return NIVEL_EVENTOS;
+	return -1;
+}
+
+
+int anadeSumidero (struct campeonato *c, int tipo, int nivel, char *destino)
+{
+	struct sumidero *nuevo = &c->sumideros[c->numSumideros];
+	struct sockaddr_un direccion;
+	char nombre[TAMNOMBRE];
+
+	if (nivel==NIVEL_NADA) return 0; // No se escribiría nada.
+
+	nuevo->tipo = tipo;
+	nuevo->nivel = nivel;
+	nuevo->tuberia = NULL;
+	nuevo->ocupado = 0;
+	memset(&nuevo->durables, 0, sizeof(struct registrosPendientes));
+
+	if (tipo==SUMIDERO_CONSOLA)
+	{
+		nuevo->fd = STDOUT_FILENO;
+	}
+	else if (tipo==SUMIDERO_FICHERO)
+	{
+		// En el modo anfitrión cada campeonato escribe en su propio fichero (salvo el log, que ya viene con su nombre).
+		if (modoAnfitrion==1 && destino!=c->nombreArchivo) snprintf(nombre, TAMNOMBRE, "%s-%d", destino, c->numero);
+		else snprintf(nombre, TAMNOMBRE, "%s", destino);
+		nuevo->fd = open(nombre, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+	}
+	else if (tipo==SUMIDERO_TUBERIA)
+	{
+		signal(SIGPIPE, SIG_IGN); // Si la orden termina antes se descartan sus mensajes en lugar de acabar el campeonato.
+		nuevo->tuberia = popen(destino, "w");
+		nuevo->fd = (nuevo->tuberia==NULL) ? -1 : fileno(nuevo->tuberia);
+	}
+	else
+	{
+		// Syslog por el socket local (un datagrama por mensaje).
+		memset(&direccion, 0, sizeof(direccion));
+		direccion.sun_family = AF_UNIX;
+		strncpy(direccion.sun_path, (destino!=NULL && destino[0]!='\0') ? destino : "/dev/log", sizeof(direccion.sun_path)-1);
+		nuevo->fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+		if (nuevo->fd>=0 && connect(nuevo->fd, (struct sockaddr*)&direccion, sizeof(direccion))!=0)
+		{
+			close(nuevo->fd);
+			nuevo->fd = -1;
 		}
-	}while (finalizar == 0);
+	}
 
+	if (nuevo->fd<0) return -1;
 
-	free(id);
-	free(msg);
+	nuevo->buffer = (char*)malloc(sizeof(char)*TAMSUMIDERO);
+	c->numSumideros++;
+	return 0;
 }
 
 
-void finalizaCompeticion (int sig)
+int abreSumideros (struct campeonato *c)
 {
+	char pedido[TAMNOMBRE];
+	char *tipo;
+	char *destino;
+	int nivel;
 	int i;
-	char *id;
-	char *msg;
 
-	id = (char*)malloc(sizeof(char)*30);
-	msg = (char*)malloc(sizeof(char)*256);
+	c->numSumideros = 0;
+	if (anadeSumidero(c, SUMIDERO_CONSOLA, nivelConsola, NULL)!=0) return -1;
+	if (anadeSumidero(c, SUMIDERO_FICHERO, nivelLog, c->nombreArchivo)!=0) return -1;
+
+	// Sumideros pedidos por opciones: NIVEL,tuberia:ORDEN, NIVEL,syslog[:SOCKET] o NIVEL,fichero:NOMBRE (se trocea una copia porque cada campeonato la lee).
+	for (i=0; i<numSumiderosPedidos; i++)
+	{
+		snprintf(pedido, TAMNOMBRE, "%s", sumiderosPedidos[i]);
+		tipo = strchr(pedido, ',');
+		if (tipo==NULL) return -1;
+		*tipo = '\0';
+		tipo++;
+		nivel = leeNivel(pedido);
+
+		destino = strchr(tipo, ':');
+		if (destino!=NULL)
+		{
+			*destino = '\0';
+			destino++;
+		}
+
+		if (nivel<0) return -1;
+		else if (strcmp(tipo, "tuberia")==0 && destino!=NULL && anadeSumidero(c, SUMIDERO_TUBERIA, nivel, destino)!=0) return -1;
+		else if (strcmp(tipo, "fichero")==0 && destino!=NULL && anadeSumidero(c, SUMIDERO_FICHERO, nivel, destino)!=0) return -1;
+		else if (strcmp(tipo, "syslog")==0 && anadeSumidero(c, SUMIDERO_SYSLOG, nivel, destino)!=0) return -1;
+		else if (strcmp(tipo, "tuberia")!=0 && strcmp(tipo, "fichero")!=0 && strcmp(tipo, "syslog")!=0 && strcmp(tipo, "ninguno")!=0) return -1;
+	}
+
+	return 0;
+}
+
 
+void vaciaSumidero (struct sumidero *destino)
+{
+	char *p = destino->buffer;
+	ssize_t escritos;
 
-	if (signal(SIGINT, finalizaCompeticion)==SIG_ERR) 
+	// Se escribe todo lo acumulado de una vez (se llama con semaforo_escribir bloqueado).
+	while (destino->ocupado>0)
 	{
-		perror("Error en la llamada a la señal SIGINT.\n");
-		exit(-1);
+		escritos = write(destino->fd, p, destino->ocupado);
+		if (escritos<0) break; // Si la pantalla o la tubería se han cerrado se descarta.
+		p += escritos;
+		destino->ocupado -= escritos;
 	}
-	
-	printf("Has pulsado finalizar competición.\n");
-	finalizar=1; // Se para de recibir señales.
+	destino->ocupado = 0;
+
+	if (destino->tipo==SUMIDERO_FICHERO) apuntaEscritura(&durabilidad, destino->fd, &destino->durables);
+}
+
+
+void escribeEnSumidero (struct sumidero *destino, char *texto, int longitud)
+{
+	if (destino->ocupado+longitud>TAMSUMIDERO) vaciaSumidero(destino);
+
+	memcpy(destino->buffer+destino->ocupado, texto, longitud);
+	destino->ocupado += longitud;
+	if (destino->tipo==SUMIDERO_FICHERO) apuntaRegistro(&durabilidad, &destino->durables, horaSuceso);
+}
 
 
-	// Se escribe en el log que ha finalizado el programa.
-	sprintf(id, "FIN DEL PROGRAMA");  
-	sprintf(msg, "Se acabó este suplicio.\n");
-	printf("%s: %s\n", id, msg);
-					
-	if (pthread_mutex_lock(&semaforo_escribir)!=0)
+void vaciaSumideros (struct campeonato *c)
+{
+	int i;
+
+	if (pthread_mutex_lock(&c->semaforo_escribir)!=0)
 	{
 		perror("Error en el bloqueo del semáforo para escribir en el fichero.\n");
 		exit(-1);
 	}
-		
-		writeLogMessage(id, msg); 
 
-	if (pthread_mutex_unlock(&semaforo_escribir)!=0)
+		for (i=0; i<c->numSumideros; i++)
+		{
+			if (c->sumideros[i].tipo!=SUMIDERO_SYSLOG) vaciaSumidero(&c->sumideros[i]);
+		}
+
+	if (pthread_mutex_unlock(&c->semaforo_escribir)!=0)
 	{
 		perror("Error en el desbloqueo del semáforo para escribir en el fichero.\n");
 		exit(-1);
 	}
+}
 
 
-	// Se cancelan y finalizan los hilos de los atletas.
-	for (i=0; i<maxAtletas; i++)
-	{
-		pthread_cancel(atletas[i].atleta);
-	}
-	
-	// Se escribe en el log qué atleta se ha ido sin beber.
-	if (estadoFuente!=0)
-	{
-		sprintf(id, "Atleta %d", colaFuente[0].id);  
-		sprintf(msg, "Me voy sin beber así que dadme agua, pero que esté bien fresquita.");
-		printf("%s: %s\n", id, msg);
-					
-		if (pthread_mutex_lock(&semaforo_escribir)!=0)
-		{
-			perror("Error en el bloqueo del semáforo para escribir en el fichero.\n");
-			exit(-1);
-		}
-		
-			writeLogMessage(id, msg); 
+void vaciaCampeonatos (void *datos)
+{
+	int i;
 
-		if (pthread_mutex_unlock(&semaforo_escribir)!=0)
-		{
-			perror("Error en el desbloqueo del semáforo para escribir en el fichero.\n");
-			exit(-1);
-		}						
-		pthread_cancel(colaFuente[0].atleta); // Se finaliza el hilo del atleta que espera en la fuente.
+	for (i=0; i<numCampeonatos; i++)
+	{
+		if (campeonatos[i]!=NULL) vaciaSumideros(campeonatos[i]);
 	}
+}
 
 
-	sleep(3);
-	printf("Te mostraré los resultados.\n");
-
+void pasoVaciado (struct tarea *tarea)
+{
+	struct campeonato *c = (struct campeonato*)tarea->datos;
 
-	// Se escribe en el log los atletas que han pasado por cada tarima.
-	for(i=1; i<=numTarimas; i++)
+	if (c->finalizar==1) // Lo que quede lo escribe cierraSumideros.
 	{
-		sprintf(id, "Total atletas tarima %d", i);  
-		sprintf(msg, "%d", punteroTarimas[i-1].contador);
-		printf("%s: %s\n", id, msg);
-		if (pthread_mutex_lock(&semaforo_escribir)!=0)
-		{
-			perror("Error en el bloqueo del semáforo para escribir en el fichero.\n");
-			exit(-1);
-		}
-		
-			writeLogMessage(id, msg); 
-
-		if (pthread_mutex_unlock(&semaforo_escribir)!=0)
-		{
-			perror("Error en el desbloqueo del semáforo para escribir en el fichero.\n");
-			exit(-1);
-		}
+		terminaTarea(c);
+		return;
 	}
 
+	vaciaSumideros(c);
+	programaTarea(tarea, (int64_t)intervaloVaciado*1000000);
+}
 
-	// Se cancelan y finalizan los hilos de las tarimas.
-	for (i=0; i<numTarimas; i++)
-	{
-		pthread_cancel(punteroTarimas[i].tatami);
-	}
 
-	
-	// Podio.
-	if (pthread_mutex_lock(&semaforo_escribir)!=0)
+void cierraSumideros (struct campeonato *c)
+{
+	int i;
+
+	if (pthread_mutex_lock(&c->semaforo_escribir)!=0)
 	{
 		perror("Error en el bloqueo del semáforo para escribir en el fichero.\n");
 		exit(-1);
 	}
-		sprintf(id, "PRIMERA POSICIÓN");  
-		sprintf(msg, "Atleta %d con %d puntos.", podio[0][0], podio[1][0]);	
-		printf("%s: %s\n", id, msg);
-	
-		writeLogMessage(id, msg); 
 
-		sprintf(id, "SEGUNDA POSICIÓN");  
-		sprintf(msg, "Atleta %d con %d puntos.", podio[0][1], podio[1][1]);	
-		printf("%s: %s\n", id, msg);
-		
-		writeLogMessage(id, msg); 
+		for (i=0; i<c->numSumideros; i++)
+		{
+			if (c->sumideros[i].tipo!=SUMIDERO_SYSLOG) vaciaSumidero(&c->sumideros[i]);
+			if (c->sumideros[i].tipo==SUMIDERO_FICHERO) sincronizaAlCerrar(&durabilidad, c->sumideros[i].fd); // Con la clasificación ya escrita.
 
-		sprintf(id, "TERCERA POSICIÓN");  
-		sprintf(msg, "Atleta %d con %d puntos.", podio[0][2], podio[1][2]);
-		printf("%s: %s\n", id, msg);	
-	
-		writeLogMessage(id, msg); 
+			if (c->sumideros[i].tuberia!=NULL) pclose(c->sumideros[i].tuberia);
+			else if (c->sumideros[i].tipo!=SUMIDERO_CONSOLA) close(c->sumideros[i].fd);
+			free(c->sumideros[i].buffer);
+		}
+		c->numSumideros = 0; // Ya no se escribe nada más.
 
-	if (pthread_mutex_unlock(&semaforo_escribir)!=0)
+	if (pthread_mutex_unlock(&c->semaforo_escribir)!=0)
 	{
 		perror("Error en el desbloqueo del semáforo para escribir en el fichero.\n");
 		exit(-1);
 	}
+}
 
 
-	// Destrucción de los semáforos y la condición.
-	if (pthread_mutex_destroy(&semaforo_atletas)!=0)
+void preparaTexto (struct textoPlantilla *texto, char *formato)
+{
+	char *marca;
+
+	// Se guardan los trozos literales que hay entre cada %d para no tener que interpretar el formato en cada mensaje.
+	texto->numTrozos = 0;
+	while ((marca = strstr(formato, "%d"))!=NULL && texto->numTrozos<MAXVALORES)
 	{
-		perror("Error en la destrucción del semáforo para los atletas.\n");
-		exit(-1);
+		texto->trozo[texto->numTrozos] = formato;
+		texto->longitud[texto->numTrozos] = marca-formato;
+		texto->numTrozos++;
+		formato = marca+2;
 	}
-	
-	if (pthread_mutex_destroy(&semaforo_tarimas)!=0)
+	texto->trozo[texto->numTrozos] = formato;
+	texto->longitud[texto->numTrozos] = strlen(formato);
+}
+
+
+void preparaPlantillas()
+{
+	int i;
+
+	for (i=0; i<NUMEVENTOS; i++)
 	{
-		perror("Error en la destrucción del semáforo para las tarimas.\n");
-		exit(-1);
+		preparaTexto(&plantillas[i].quien, plantillas[i].formatoQuien);
+		preparaTexto(&plantillas[i].mensaje, plantillas[i].formatoMensaje);
 	}
-	
-	if (pthread_mutex_destroy(&semaforo_fuente)!=0)
+}
+
+
+int escribeEntero (char *destino, int valor)
+{
+	char cifras[12];
+	int n = 0;
+	int longitud = 0;
+	unsigned int resto = (valor<0) ? -(unsigned int)valor : (unsigned int)valor;
+
+	if (valor<0) destino[longitud++] = '-';
+	do
 	{
-		perror("Error en la destrucción del semáforo para la fuente (porque alguien fue a beber y no cerró el grifo).\n");
-		exit(-1);
+		cifras[n++] = '0' + resto%10;
+		resto /= 10;
+	}while (resto>0);
+
+	while (n>0) destino[longitud++] = cifras[--n];
+	return longitud;
+}
+
+
+int componeTexto (char *destino, int tam, struct textoPlantilla *texto, int *valores)
+{
+	int longitud = 0;
+	int i;
+
+	for (i=0; i<=texto->numTrozos; i++)
+	{
+		if (longitud+texto->longitud[i]+12>=tam) break; // No cabe (no pasa con las plantillas actuales).
+
+		memcpy(destino+longitud, texto->trozo[i], texto->longitud[i]);
+		longitud += texto->longitud[i];
+		if (i<texto->numTrozos) longitud += escribeEntero(destino+longitud, valores[i]);
 	}
-	
-	if (pthread_cond_destroy(&condicion)!=0)
+	destino[longitud] = '\0';
+	return longitud;
+}
+
+
+void registraEvento (struct campeonato *c, int evento, int quien, int valor1, int valor2)
+{
+	struct plantillaEvento *plantilla = &plantillas[evento];
+	int valores[MAXVALORES];
+
+	// Se compone el mensaje en los huecos del propio hilo, sin reservar memoria.
+	valores[0] = quien;
+	componeTexto(quienEvento, TAMQUIEN, &plantilla->quien, valores);
+	valores[0] = valor1;
+	valores[1] = valor2;
+	componeTexto(mensajeEvento, TAMMENSAJE, &plantilla->mensaje, valores);
+
+	escribeEvento(c, plantilla);
+}
+
+
+void registraPuntuacion (struct campeonato *c, int evento, int quien, int valor1, int valor2, int64_t fin)
+{
+	struct plantillaEvento *plantilla = &plantillas[evento];
+	int valores[MAXVALORES];
+	int longitud;
+
+	// Como registraEvento, con la hora exacta del final detrás: reproduceLog desempata el podio con ella.
+	valores[0] = quien;
+	componeTexto(quienEvento, TAMQUIEN, &plantilla->quien, valores);
+	valores[0] = valor1;
+	valores[1] = valor2;
+	longitud = componeTexto(mensajeEvento, TAMMENSAJE, &plantilla->mensaje, valores);
+	snprintf(mensajeEvento+longitud, TAMMENSAJE-longitud, " (fin %lld)", (long long)fin);
+
+	escribeEvento(c, plantilla);
+}
+
+
+void registraTexto (struct campeonato *c, int evento, int quien, char *texto)
+{
+	struct plantillaEvento *plantilla = &plantillas[evento];
+	int valores[MAXVALORES];
+	int longitud = strlen(texto);
+
+	valores[0] = quien;
+	componeTexto(quienEvento, TAMQUIEN, &plantilla->quien, valores);
+	if (longitud>=TAMMENSAJE) longitud = TAMMENSAJE-1; // Lo que no cabe se corta.
+	memcpy(mensajeEvento, texto, longitud);
+	mensajeEvento[longitud] = '\0';
+
+	escribeEvento(c, plantilla);
+}
+
+
+void escribeEvento (struct campeonato *c, struct plantillaEvento *plantilla)
+{
+	char linea[TAMLINEA];
+	int longitud;
+	int i;
+
+	if (tandaEscribiendo!=c && pthread_mutex_lock(&c->semaforo_escribir)!=0) // Se bloquea el semáforo para que los mensajes entren de uno en uno.
 	{
-		perror("Error en la destrucción de la condición.\n");
+		perror("Error en el bloqueo del semáforo para escribir en el fichero.\n");
 		exit(-1);
 	}
-	
-	if (pthread_mutex_destroy(&semaforo_escribir)!=0)
+
+		// La pantalla pasa por el mismo buffer que el fichero en lugar de imprimirse con printf.
+		if ((plantilla->destino & DESTINO_CONSOLA)!=0)
+		{
+			for (i=0; i<c->numSumideros; i++)
+			{
+				if (c->sumideros[i].tipo!=SUMIDERO_CONSOLA || c->sumideros[i].nivel<plantilla->nivel) continue;
+
+				if (quienEvento[0]!='\0') longitud = snprintf(linea, TAMLINEA, "%s%s: %s\n", c->prefijo, quienEvento, mensajeEvento);
+				else longitud = snprintf(linea, TAMLINEA, "%s%s\n", c->prefijo, mensajeEvento);
+				escribeEnSumidero(&c->sumideros[i], linea, longitud<TAMLINEA ? longitud : TAMLINEA-1);
+			}
+		}
+
+		if ((plantilla->destino & DESTINO_LOG)!=0)
+		{
+			writeLogMessage(c, plantilla->nivel, quienEvento, mensajeEvento);
+		}
+
+		// Los resúmenes y los errores se escriben enseguida.
+		if (plantilla->nivel<NIVEL_EVENTOS)
+		{
+			for (i=0; i<c->numSumideros; i++)
+			{
+				if (c->sumideros[i].tipo!=SUMIDERO_SYSLOG) vaciaSumidero(&c->sumideros[i]);
+			}
+		}
+
+	if (tandaEscribiendo!=c && pthread_mutex_unlock(&c->semaforo_escribir)!=0)
 	{
-		perror("Error en la destrucción del semáforo para escribir en el fichero.\n");
+		perror("Error en el desbloqueo del semáforo para escribir en el fichero.\n");
 		exit(-1);
 	}
-	
-
-	// Se libera toda la memoria reservada.
-	free(atletas);
-	free(punteroTarimas);
-	free(id);
-	free(msg);	
 }
 
 
-void  writeLogMessage (char *id, char *msg) 
+int calculaAleatorios (int min, int max)
 {
-	// Se calcula la hora actual.
-	time_t  now = time (0);
-	struct  tm *tlocal = localtime (&now);
-	char  stnow [19];
-	strftime(stnow , 19, " %d/ %m/ %y  %H: %M: %S", tlocal);
+	return rand() % (max-min+1) + min;
+}
 
-	// Se escribe en el fichero log llamado registroTiempos.log.
-	registro = fopen(nombreArchivo, "a");
-	fprintf(registro , "[ %s]  %s:  %s\n", stnow , id, msg);
-	fclose(registro);
+
+void iniciaReloj (int formato)
+{
+	formatoHora = formato;
+	clock_gettime(CLOCK_REALTIME, &relojBaseReal);
+	clock_gettime(CLOCK_MONOTONIC, &relojBaseMonotonico);
 }
 
 
-int calculaAleatorios (int min, int max) 
+int escribeDigitos (char *destino, long valor, int cifras)
 {
-	return rand() % (max-min+1) + min;
+	int i;
+
+	for (i=cifras-1; i>=0; i--)
+	{
+		destino[i] = '0' + valor%10;
+		valor /= 10;
+	}
+	return cifras;
 }
 
 
+int formateaHora (char *hora)
+{
+	struct timespec monotonico;
+	struct tm fecha;
+	long long ns;
+	time_t segundo;
+	int longitud;
+
+	// La hora real se deduce del reloj monotónico, así los mensajes de una misma ráfaga quedan ordenados aunque se ajuste el reloj del sistema.
+	clock_gettime(CLOCK_MONOTONIC, &monotonico);
+	ns = (long long)relojBaseReal.tv_sec*1000000000 + relojBaseReal.tv_nsec + ((long long)(monotonico.tv_sec-relojBaseMonotonico.tv_sec)*1000000000 + (monotonico.tv_nsec-relojBaseMonotonico.tv_nsec));
+
+	if (formatoHora==HORA_NS)
+	{
+		return sprintf(hora, "%lld", ns);
+	}
+
+	// Sólo se llama a localtime_r y strftime cuando cambia el segundo; el resto de mensajes copian la fecha guardada.
+	segundo = ns/1000000000;
+	if (segundo!=segundoCacheado)
+	{
+		localtime_r(&segundo, &fecha);
+		if (formatoHora==HORA_ISO)
+		{
+			longitudFechaCacheada = strftime(fechaCacheada, TAMHORA, "%Y-%m-%dT%H:%M:%S", &fecha);
+			strftime(zonaCacheada, sizeof(zonaCacheada), "%z", &fecha);
+		}
+		else
+		{
+			longitudFechaCacheada = strftime(fechaCacheada, TAMHORA, " %d/ %m/ %y  %H: %M: %S", &fecha);
+		}
+		segundoCacheado = segundo;
+	}
+
+	memcpy(hora, fechaCacheada, longitudFechaCacheada);
+	longitud = longitudFechaCacheada;
+	hora[longitud++] = '.';
+
+	if (formatoHora==HORA_ISO)
+	{
+		longitud += escribeDigitos(hora+longitud, ns%1000000000, 9);
+		strcpy(hora+longitud, zonaCacheada);
+		longitud += strlen(zonaCacheada);
+	}
+	else
+	{
+		longitud += escribeDigitos(hora+longitud, ns%1000000000/1000, 6);
+	}
+	hora[longitud] = '\0';
 
+	return longitud;
+}
@@ -0,0 +1,630 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+/*
+ * Reconstruye los resultados de un campeonato a partir de su registroTiempos.log.
+ *
+ *   reproduceLog [-j hilos] [-a] [-r N] [fichero]
+ *
+ * El fichero se proyecta en memoria y se parte en trozos por finales de línea; cada hilo analiza su trozo sin copiar
+ * nada y al final se juntan los estados parciales. Se obtienen los estados de cada atleta (-a), los totales de cada
+ * tarima, el podio y la clasificación (-r N), y se comparan con los totales y el podio que escribió el campeonato.
+ */
+
+
+
+// Definición de constantes.
+#define DORSALES_INICIALES 1024
+#define TARIMAS_INICIALES 8
+
+// Estados por los que pasa un atleta (se acumulan como bits).
+#define INSCRITO 0x001
+#define DESHIDRATADO 0x002
+#define CALENTANDO 0x004
+#define PUNTUADO 0x008
+#define FINALIZADO 0x010
+#define NECESITA_BEBER 0x020
+#define EN_FUENTE 0x040
+#define APRETO_BOTON 0x080
+#define BEBIO 0x100
+#define SIN_BEBER 0x200
+
+// Resultado de un levantamiento.
+#define RESULTADO_VALIDO 0
+#define RESULTADO_NULO_INDUMENTARIA 1
+#define RESULTADO_NULO_FUERZA 2
+
+
+
+/* Estructuras. */
+
+
+// Estado de un atleta reconstruido a partir de sus mensajes.
+struct estadoAtleta
+{
+	int estados;
+	int tarima_asignada;
+	int juez; // Tarima que lo juzgó (puede no ser la asignada si ayudó la otra).
+	int resultado;
+	int puntuacion;
+};
+
+
+// Totales de cada tarima.
+struct estadoTarima
+{
+	int levantamientos;
+	int validos;
+	int nulos;
+	int descansos;
+	int total_registrado; // Lo que escribió finalizaCompeticion (-1 si no aparece).
+};
+
+
+// Puesto del podio; en un empate gana, como en el campeonato, el último en acabar (la hora que lleva cada puntuación en el
+// log). Los log que no la llevan desempatan por el orden en el fichero, que era el orden en que se rellenaba el podio.
+struct puesto
+{
+	int dorsal;
+	int puntuacion;
+	int64_t fin; // 0 si el log no la trae.
+	long orden;
+};
+
+
+// Lo que obtiene cada hilo de su trozo del fichero.
+struct trozo
+{
+	const char *inicio;
+	const char *fin;
+	long base; // Posición del trozo dentro del fichero.
+
+	struct estadoAtleta *atletas;
+	int numDorsales;
+	struct estadoTarima *tarimas;
+	int numTarimas;
+	struct puesto podio[3];
+	struct puesto podioRegistrado[3];
+	long lineas;
+	long desconocidas;
+
+	pthread_t hilo;
+};
+
+
+
+/* Declaración de las funciones. */
+
+
+void *analizaTrozo(void *arg);
+void analizaLinea(struct trozo *t, const char *linea, const char *fin);
+struct estadoAtleta *atletaDe(struct trozo *t, int dorsal);
+struct estadoTarima *tarimaDe(struct trozo *t, int tarima);
+void meteEnPodio(struct puesto *podio, int dorsal, int puntuacion, int64_t fin, long orden);
+int ganaEmpate(struct puesto *puesto, int dorsal, int64_t fin, long orden);
+int empiezaPor(const char *p, const char *fin, const char *prefijo);
+int leeEntero(const char **p, const char *fin);
+int64_t leeHoraFin(const char *p, const char *fin); // La de "(fin NS)" al final de una puntuación (0 si no está).
+void juntaTrozos(struct trozo *total, struct trozo *trozos, int numTrozos);
+void imprimeResultados(struct trozo *total, int mostrarAtletas, int clasificados);
+int comparaClasificacion(const void *a, const void *b);
+
+
+
+/* Función principal. */
+
+
+int main (int argc, char *argv[])
+{
+	char *nombreArchivo = "registroTiempos.log";
+	int numHilos = sysconf(_SC_NPROCESSORS_ONLN);
+	int mostrarAtletas = 0;
+	int clasificados = 10;
+	int opcion;
+	int fichero;
+	struct stat info;
+	char *datos;
+	struct trozo *trozos;
+	struct trozo total;
+	const char *corte;
+	int i;
+
+	while ((opcion = getopt(argc, argv, "j:ar:"))!=-1)
+	{
+		if (opcion=='j') numHilos = atoi(optarg);
+		else if (opcion=='a') mostrarAtletas = 1;
+		else if (opcion=='r') clasificados = atoi(optarg);
+		else
+		{
+			fprintf(stderr, "Uso: %s [-j hilos] [-a] [-r N] [fichero]\n", argv[0]);
+			exit(-1);
+		}
+	}
+	if (optind<argc) nombreArchivo = argv[optind];
+	if (numHilos<1) numHilos = 1;
+
+
+	// Se proyecta el fichero en memoria.
+	fichero = open(nombreArchivo, O_RDONLY);
+	if (fichero<0 || fstat(fichero, &info)!=0)
+	{
+		perror("Error en la apertura del fichero log.\n");
+		exit(-1);
+	}
+
+	datos = NULL;
+	if (info.st_size>0)
+	{
+		datos = (char*)mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fichero, 0);
+		if (datos==MAP_FAILED)
+		{
+			perror("Error en la proyección del fichero log.\n");
+			exit(-1);
+		}
+		madvise(datos, info.st_size, MADV_SEQUENTIAL);
+	}
+
+	if (info.st_size<numHilos*4096L) numHilos = 1; // No merece la pena repartir ficheros pequeños.
+
+
+	// Se parte el fichero en trozos que empiezan siempre al principio de una línea.
+	trozos = (struct trozo*)calloc(numHilos, sizeof(struct trozo));
+	corte = datos;
+	for (i=0; i<numHilos; i++)
+	{
+		trozos[i].inicio = corte;
+		if (i==numHilos-1)
+		{
+			corte = datos + info.st_size;
+		}
+		else
+		{
+			corte = datos + info.st_size/numHilos*(i+1);
+			if (corte<trozos[i].inicio) corte = trozos[i].inicio;
+			corte = memchr(corte, '\n', datos + info.st_size - corte);
+			corte = (corte==NULL) ? datos + info.st_size : corte+1;
+		}
+		trozos[i].fin = corte;
+		trozos[i].base = trozos[i].inicio - datos;
+
+		if (pthread_create(&trozos[i].hilo, NULL, analizaTrozo, (void*)&trozos[i])!=0)
+		{
+			perror("Error en la creación de los hilos.\n");
+			exit(-1);
+		}
+	}
+
+	for (i=0; i<numHilos; i++)
+	{
+		pthread_join(trozos[i].hilo, NULL);
+	}
+
+
+	juntaTrozos(&total, trozos, numHilos);
+	imprimeResultados(&total, mostrarAtletas, clasificados);
+
+	if (datos!=NULL) munmap(datos, info.st_size);
+	close(fichero);
+	return 0;
+}
+
+
+
+/* Implementación de las funciones. */
+
+
+void *analizaTrozo (void *arg)
+{
+	struct trozo *t = (struct trozo*)arg;
+	const char *p = t->inicio;
+	const char *finLinea;
+	int i;
+
+	for (i=0; i<3; i++)
+	{
+		t->podioRegistrado[i].dorsal = -1;
+	}
+
+	while (p<t->fin)
+	{
+		finLinea = memchr(p, '\n', t->fin-p);
+		if (finLinea==NULL) finLinea = t->fin;
+
+		analizaLinea(t, p, finLinea);
+		p = finLinea+1;
+	}
+
+	return NULL;
+}
+
+
+int empiezaPor (const char *p, const char *fin, const char *prefijo)
+{
+	size_t n = strlen(prefijo);
+
+	return (size_t)(fin-p)>=n && memcmp(p, prefijo, n)==0;
+}
+
+
+int leeEntero (const char **p, const char *fin)
+{
+	int valor = 0;
+
+	while (*p<fin && (**p<'0' || **p>'9')) (*p)++;
+	while (*p<fin && **p>='0' && **p<='9')
+	{
+		valor = valor*10 + (**p-'0');
+		(*p)++;
+	}
+	return valor;
+}
+
+
+int64_t leeHoraFin (const char *p, const char *fin)
+{
+	int64_t valor = 0;
+
+	while (p<fin && !empiezaPor(p, fin, "(fin ")) p++;
+	if (p==fin) return 0;
+
+	for (p+=5; p<fin && *p>='0' && *p<='9'; p++)
+	{
+		valor = valor*10 + (*p-'0');
+	}
+	return valor;
+}
+
+
+struct estadoAtleta *atletaDe (struct trozo *t, int dorsal)
+{
+	int nuevo;
+
+	if (dorsal>=t->numDorsales)
+	{
+		nuevo = (t->numDorsales==0) ? DORSALES_INICIALES : t->numDorsales;
+		while (nuevo<=dorsal) nuevo *= 2;
+
+		t->atletas = (struct estadoAtleta*)realloc(t->atletas, sizeof(struct estadoAtleta)*nuevo);
+		memset(t->atletas+t->numDorsales, 0, sizeof(struct estadoAtleta)*(nuevo-t->numDorsales));
+		t->numDorsales = nuevo;
+	}
+	return &t->atletas[dorsal];
+}
+
+
+struct estadoTarima *tarimaDe (struct trozo *t, int tarima)
+{
+	int nuevo;
+	int i;
+
+	if (tarima>=t->numTarimas)
+	{
+		nuevo = (t->numTarimas==0) ? TARIMAS_INICIALES : t->numTarimas;
+		while (nuevo<=tarima) nuevo *= 2;
+
+		t->tarimas = (struct estadoTarima*)realloc(t->tarimas, sizeof(struct estadoTarima)*nuevo);
+		memset(t->tarimas+t->numTarimas, 0, sizeof(struct estadoTarima)*(nuevo-t->numTarimas));
+		for (i=t->numTarimas; i<nuevo; i++)
+		{
+			t->tarimas[i].total_registrado = -1;
+		}
+		t->numTarimas = nuevo;
+	}
+	return &t->tarimas[tarima];
+}
+
+
+int ganaEmpate (struct puesto *puesto, int dorsal, int64_t fin, long orden)
+{
+	// Igual que vaDelante en el campeonato: el último en acabar y, a la misma hora, el dorsal más alto.
+	if (fin!=0 && puesto->fin!=0)
+	{
+		if (fin!=puesto->fin) return fin>puesto->fin;
+		return dorsal>puesto->dorsal;
+	}
+	return orden>puesto->orden;
+}
+
+
+void meteEnPodio (struct puesto *podio, int dorsal, int puntuacion, int64_t fin, long orden)
+{
+	int i;
+	int j;
+
+	// Igual que en actualizaPodio: entra en el primer puesto vacío o delante del primero al que supere o al que gane el empate.
+	for (i=0; i<3; i++)
+	{
+		if (podio[i].dorsal==0 || puntuacion>podio[i].puntuacion || (puntuacion==podio[i].puntuacion && ganaEmpate(&podio[i], dorsal, fin, orden)))
+		{
+			for (j=2; j>i; j--)
+			{
+				podio[j] = podio[j-1];
+			}
+			podio[i].dorsal = dorsal;
+			podio[i].puntuacion = puntuacion;
+			podio[i].fin = fin;
+			podio[i].orden = orden;
+			return;
+		}
+	}
+}
+
+
+void analizaLinea (struct trozo *t, const char *linea, const char *fin)
+{
+	const char *p;
+	const char *id;
+	const char *finId;
+	const char *msg;
+	struct estadoAtleta *atleta;
+	struct estadoTarima *tarima;
+	int numero;
+	int dorsal;
+	int puesto;
+
+	if (linea>=fin || *linea!='[') return; // Líneas vacías (el mensaje final lleva un salto de línea de más).
+	t->lineas++;
+
+	// Formato: "[fecha]  id:  mensaje". La fecha se salta sin mirarla.
+	p = memchr(linea, ']', fin-linea);
+	if (p==NULL) return;
+	p++;
+	while (p<fin && *p==' ') p++;
+	id = p;
+
+	finId = NULL;
+	for (; p+1<fin; p++)
+	{
+		if (p[0]==':' && p[1]==' ')
+		{
+			finId = p;
+			break;
+		}
+	}
+	if (finId==NULL) return;
+	msg = finId+1;
+	while (msg<fin && *msg==' ') msg++;
+
+
+	if (empiezaPor(id, finId, "Atleta "))
+	{
+		p = id;
+		atleta = atletaDe(t, leeEntero(&p, finId));
+
+		if (empiezaPor(msg, fin, "He entrado a la tarima "))
+		{
+			p = msg;
+			atleta->estados |= INSCRITO;
+			atleta->tarima_asignada = leeEntero(&p, fin);
+		}
+		else if (empiezaPor(msg, fin, "Estoy deshidratado")) atleta->estados |= DESHIDRATADO;
+		else if (empiezaPor(msg, fin, "Voy a calentar")) atleta->estados |= CALENTANDO;
+		else if (empiezaPor(msg, fin, "He finalizado el levantamiento")) atleta->estados |= FINALIZADO;
+		else if (empiezaPor(msg, fin, "Voy a beber a la fuente, pero ... ¡qué lástima!")) atleta->estados |= EN_FUENTE;
+		else if (empiezaPor(msg, fin, "Voy a beber a la fuente, pero ... ¡vaya por Dios!")) atleta->estados |= APRETO_BOTON;
+		else if (empiezaPor(msg, fin, "Ya he bebido")) atleta->estados |= BEBIO;
+		else if (empiezaPor(msg, fin, "Me voy sin beber")) atleta->estados |= SIN_BEBER;
+		else t->desconocidas++;
+	}
+	else if (empiezaPor(id, finId, "Juez "))
+	{
+		p = id;
+		numero = leeEntero(&p, finId);
+		tarima = tarimaDe(t, numero);
+
+		if (empiezaPor(msg, fin, "El dorsal "))
+		{
+			p = msg;
+			dorsal = leeEntero(&p, fin);
+			atleta = atletaDe(t, dorsal);
+			atleta->estados |= PUNTUADO;
+			atleta->juez = numero;
+			tarima->levantamientos++;
+
+			if (empiezaPor(p, fin, " hizo un levantamiento asombroso"))
+			{
+				atleta->resultado = RESULTADO_VALIDO;
+				atleta->puntuacion = leeEntero(&p, fin);
+				tarima->validos++;
+			}
+			else
+			{
+				atleta->resultado = empiezaPor(p, fin, " no lleva pantalones") ? RESULTADO_NULO_INDUMENTARIA : RESULTADO_NULO_FUERZA;
+				atleta->puntuacion = 0;
+				tarima->nulos++;
+			}
+			meteEnPodio(t->podio, dorsal, atleta->puntuacion, leeHoraFin(p, fin), t->base + (linea - t->inicio));
+		}
+		else if (empiezaPor(msg, fin, "Dorsal "))
+		{
+			p = msg;
+			atletaDe(t, leeEntero(&p, fin))->estados |= NECESITA_BEBER;
+		}
+		else if (empiezaPor(msg, fin, "Esto es muy aburrido")) tarima->descansos++;
+		else if (!empiezaPor(msg, fin, "Ya he acabado de descansar")) t->desconocidas++;
+	}
+	else if (empiezaPor(id, finId, "Total atletas tarima "))
+	{
+		p = id;
+		numero = leeEntero(&p, finId);
+		p = msg;
+		tarimaDe(t, numero)->total_registrado = leeEntero(&p, fin);
+	}
+	else if (empiezaPor(id, finId, "PRIMERA POSICI") || empiezaPor(id, finId, "SEGUNDA POSICI") || empiezaPor(id, finId, "TERCERA POSICI"))
+	{
+		puesto = (*id=='P') ? 0 : (*id=='S') ? 1 : 2;
+		p = msg;
+		t->podioRegistrado[puesto].dorsal = leeEntero(&p, fin);
+		t->podioRegistrado[puesto].puntuacion = leeEntero(&p, fin);
+	}
+	else if (!empiezaPor(id, finId, "FIN DEL PROGRAMA") && !empiezaPor(id, finId, "Árbitro"))
+	{
+		t->desconocidas++;
+	}
+}
+
+
+void juntaTrozos (struct trozo *total, struct trozo *trozos, int numTrozos)
+{
+	struct estadoAtleta *atleta;
+	struct estadoTarima *tarima;
+	int i;
+	int j;
+
+	memset(total, 0, sizeof(struct trozo));
+	for (j=0; j<3; j++)
+	{
+		total->podioRegistrado[j].dorsal = -1;
+	}
+
+	// Cada mensaje aparece una sola vez por atleta, así que juntar los estados no depende del orden de los trozos.
+	for (i=0; i<numTrozos; i++)
+	{
+		for (j=trozos[i].numDorsales-1; j>=0; j--)
+		{
+			if (trozos[i].atletas[j].estados==0) continue;
+
+			atleta = atletaDe(total, j);
+			atleta->estados |= trozos[i].atletas[j].estados;
+			if (trozos[i].atletas[j].estados & INSCRITO) atleta->tarima_asignada = trozos[i].atletas[j].tarima_asignada;
+			if (trozos[i].atletas[j].estados & PUNTUADO)
+			{
+				atleta->juez = trozos[i].atletas[j].juez;
+				atleta->resultado = trozos[i].atletas[j].resultado;
+				atleta->puntuacion = trozos[i].atletas[j].puntuacion;
+			}
+		}
+
+		for (j=trozos[i].numTarimas-1; j>=0; j--)
+		{
+			tarima = tarimaDe(total, j);
+			tarima->levantamientos += trozos[i].tarimas[j].levantamientos;
+			tarima->validos += trozos[i].tarimas[j].validos;
+			tarima->nulos += trozos[i].tarimas[j].nulos;
+			tarima->descansos += trozos[i].tarimas[j].descansos;
+			if (trozos[i].tarimas[j].total_registrado>=0) tarima->total_registrado = trozos[i].tarimas[j].total_registrado;
+		}
+
+		for (j=0; j<3; j++)
+		{
+			if (trozos[i].podio[j].dorsal!=0) meteEnPodio(total->podio, trozos[i].podio[j].dorsal, trozos[i].podio[j].puntuacion, trozos[i].podio[j].fin, trozos[i].podio[j].orden);
+			if (trozos[i].podioRegistrado[j].dorsal>=0) total->podioRegistrado[j] = trozos[i].podioRegistrado[j];
+		}
+
+		total->lineas += trozos[i].lineas;
+		total->desconocidas += trozos[i].desconocidas;
+		free(trozos[i].atletas);
+		free(trozos[i].tarimas);
+	}
+}
+
+
+int comparaClasificacion (const void *a, const void *b)
+{
+	const struct estadoAtleta *x = *(const struct estadoAtleta**)a;
+	const struct estadoAtleta *y = *(const struct estadoAtleta**)b;
+
+	if (x->puntuacion!=y->puntuacion) return y->puntuacion - x->puntuacion;
+	return (x<y) ? -1 : (x>y); // A igualdad de puntos, por dorsal.
+}
+
+
+void imprimeResultados (struct trozo *total, int mostrarAtletas, int clasificados)
+{
+	char *resultados[3] = {"válido", "nulo (indumentaria)", "nulo (fuerza)"};
+	char *puestos[3] = {"PRIMERA POSICIÓN", "SEGUNDA POSICIÓN", "TERCERA POSICIÓN"};
+	struct estadoAtleta **clasificacion;
+	struct estadoAtleta *a;
+	int inscritos = 0;
+	int deshidratados = 0;
+	int puntuados = 0;
+	int bebieron = 0;
+	int sinBeber = 0;
+	int numClasificados = 0;
+	int coincide;
+	int i;
+
+	clasificacion = (struct estadoAtleta**)malloc(sizeof(struct estadoAtleta*)*(total->numDorsales+1));
+
+	if (mostrarAtletas) printf("dorsal\ttarima\tjuez\tresultado\tpuntos\testado\n");
+	for (i=0; i<total->numDorsales; i++)
+	{
+		a = &total->atletas[i];
+		if (a->estados==0) continue;
+
+		if (a->estados & INSCRITO) inscritos++;
+		if (a->estados & DESHIDRATADO) deshidratados++;
+		if (a->estados & BEBIO) bebieron++;
+		if (a->estados & SIN_BEBER) sinBeber++;
+		if (a->estados & PUNTUADO)
+		{
+			puntuados++;
+			clasificacion[numClasificados++] = a;
+		}
+
+		if (mostrarAtletas)
+		{
+			printf("%d\t%d\t%d\t%s\t%d\t", i, a->tarima_asignada, a->juez, (a->estados & PUNTUADO) ? resultados[a->resultado] : "-", a->puntuacion);
+			if (a->estados & DESHIDRATADO) printf("deshidratado");
+			else if (a->estados & BEBIO) printf("bebió");
+			else if (a->estados & SIN_BEBER) printf("se fue sin beber");
+			else if (a->estados & (EN_FUENTE|APRETO_BOTON)) printf("en la fuente");
+			else if (a->estados & FINALIZADO) printf("finalizado");
+			else if (a->estados & PUNTUADO) printf("puntuado");
+			else if (a->estados & CALENTANDO) printf("en la tarima");
+			else printf("en la cola");
+			printf("\n");
+		}
+	}
+
+	printf("Líneas analizadas: %ld (%ld sin reconocer).\n", total->lineas, total->desconocidas);
+	printf("Atletas inscritos: %d, deshidratados: %d, puntuados: %d, bebieron: %d, se fueron sin beber: %d.\n", inscritos, deshidratados, puntuados, bebieron, sinBeber);
+
+
+	// Totales de cada tarima comparados con los que escribió el campeonato.
+	for (i=1; i<total->numTarimas; i++)
+	{
+		if (total->tarimas[i].levantamientos==0 && total->tarimas[i].total_registrado<0 && total->tarimas[i].descansos==0) continue;
+
+		printf("Total atletas tarima %d: %d (%d válidos, %d nulos, %d descansos)", i, total->tarimas[i].levantamientos, total->tarimas[i].validos, total->tarimas[i].nulos, total->tarimas[i].descansos);
+		if (total->tarimas[i].total_registrado>=0)
+		{
+			printf(" %s", total->tarimas[i].total_registrado==total->tarimas[i].levantamientos ? "[coincide con el log]" : "[NO coincide con el log]");
+		}
+		printf("\n");
+	}
+
+
+	// Podio.
+	for (i=0; i<3; i++)
+	{
+		printf("%s: Atleta %d con %d puntos.", puestos[i], total->podio[i].dorsal, total->podio[i].puntuacion);
+		if (total->podioRegistrado[i].dorsal>=0)
+		{
+			coincide = total->podioRegistrado[i].dorsal==total->podio[i].dorsal && total->podioRegistrado[i].puntuacion==total->podio[i].puntuacion;
+			printf(" %s", coincide ? "[coincide con el log]" : "[NO coincide con el log]");
+		}
+		printf("\n");
+	}
+
+
+	// Clasificación.
+	qsort(clasificacion, numClasificados, sizeof(struct estadoAtleta*), comparaClasificacion);
+	if (clasificados>numClasificados) clasificados = numClasificados;
+	for (i=0; i<clasificados; i++)
+	{
+		printf("%d. Atleta %d con %d puntos (tarima %d).\n", i+1, (int)(clasificacion[i]-total->atletas), clasificacion[i]->puntuacion, clasificacion[i]->juez);
+	}
+
+	free(clasificacion);
+	free(total->atletas);
+	free(total->tarimas);
+}
@@ -0,0 +1,389 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "resultados.h"
+
+
+
+/* Declaración de las variables globales del almacén de resultados. */
+
+
+static pthread_mutex_t semaforo_resultados = PTHREAD_MUTEX_INITIALIZER; // Semáforo para añadir levantamientos de uno en uno.
+
+static int ficheroDatos = -1;
+static int ficheroIndice = -1;
+
+static int64_t numRegistros; // Registros que hay en el fichero de datos.
+static struct bloqueIndice bloqueActual; // Bloque que se está llenando y que todavía no está en el índice.
+static struct indiceClaves dorsales = {-1, 0, CLAVE_DORSAL}; // Índices por dorsal y por tarima.
+static struct indiceClaves tarimas = {-1, 0, CLAVE_TARIMA};
+
+
+
+/* Implementación de las funciones. */
+
+
+int64_t marcaTiempo()
+{
+	struct timespec ahora;
+
+	clock_gettime(CLOCK_REALTIME, &ahora);
+	return (int64_t)ahora.tv_sec*1000000000 + ahora.tv_nsec;
+}
+
+
+uint64_t bitTarima (int tarima)
+{
+	if (tarima>=1 && tarima<64)
+	{
+		return (uint64_t)1 << (tarima-1);
+	}
+	return (uint64_t)1 << 63; // Las tarimas a partir de la 64 comparten el último bit.
+}
+
+
+void iniciaBloque (struct bloqueIndice *bloque, int64_t primero)
+{
+	memset(bloque, 0, sizeof(struct bloqueIndice));
+	bloque->primer_registro = primero;
+}
+
+
+void anadeABloque (struct bloqueIndice *bloque, struct registroLevantamiento *levantamiento)
+{
+	if (bloque->num_registros==0)
+	{
+		bloque->puntuacion_max = levantamiento->puntuacion;
+		bloque->dorsal_min = levantamiento->dorsal;
+		bloque->dorsal_max = levantamiento->dorsal;
+		bloque->t_min = levantamiento->t_fin;
+		bloque->t_max = levantamiento->t_fin;
+		bloque->ejecucion_min = levantamiento->ejecucion;
+		bloque->ejecucion_max = levantamiento->ejecucion;
+	}
+	else
+	{
+		if (levantamiento->puntuacion>bloque->puntuacion_max) bloque->puntuacion_max = levantamiento->puntuacion;
+		if (levantamiento->dorsal<bloque->dorsal_min) bloque->dorsal_min = levantamiento->dorsal;
+		if (levantamiento->dorsal>bloque->dorsal_max) bloque->dorsal_max = levantamiento->dorsal;
+		if (levantamiento->t_fin<bloque->t_min) bloque->t_min = levantamiento->t_fin;
+		if (levantamiento->t_fin>bloque->t_max) bloque->t_max = levantamiento->t_fin;
+		if (levantamiento->ejecucion<bloque->ejecucion_min) bloque->ejecucion_min = levantamiento->ejecucion;
+		if (levantamiento->ejecucion>bloque->ejecucion_max) bloque->ejecucion_max = levantamiento->ejecucion;
+	}
+	bloque->mascara_tarimas |= bitTarima(levantamiento->tarima);
+	bloque->num_registros++;
+}
+
+
+static void preparaCabecera (struct cabeceraResultados *cabecera)
+{
+	memset(cabecera, 0, sizeof(struct cabeceraResultados));
+	memcpy(cabecera->magia, MAGIA_RESULTADOS, sizeof(cabecera->magia));
+	cabecera->version = VERSION_RESULTADOS;
+	cabecera->tamRegistro = sizeof(struct registroLevantamiento);
+	cabecera->tamBloque = sizeof(struct bloqueIndice);
+	cabecera->tamEntrada = sizeof(struct entradaClave);
+}
+
+
+int compruebaCabecera (int fichero)
+{
+	struct cabeceraResultados esperada;
+	struct cabeceraResultados leida;
+
+	preparaCabecera(&esperada);
+	if (pread(fichero, &leida, sizeof(struct cabeceraResultados), 0)!=(ssize_t)sizeof(struct cabeceraResultados)) return 0;
+	return memcmp(&esperada, &leida, sizeof(struct cabeceraResultados))==0;
+}
+
+
+int comparaEntradas (const void *a, const void *b)
+{
+	const struct entradaClave *x = (const struct entradaClave*)a;
+	const struct entradaClave *y = (const struct entradaClave*)b;
+
+	if (x->clave!=y->clave) return (x->clave<y->clave) ? -1 : 1;
+	if (x->ejecucion!=y->ejecucion) return (x->ejecucion<y->ejecucion) ? -1 : 1;
+	if (x->campeonato!=y->campeonato) return (x->campeonato<y->campeonato) ? -1 : 1;
+	if (x->registro!=y->registro) return (x->registro<y->registro) ? -1 : 1;
+	return 0;
+}
+
+
+static void escribeTodo (int fichero, void *datos, size_t tam)
+{
+	char *p = (char*)datos;
+	ssize_t escritos;
+
+	while (tam>0)
+	{
+		escritos = write(fichero, p, tam);
+		if (escritos<0)
+		{
+			perror("Error al escribir en el almacén de resultados.\n");
+			exit(-1);
+		}
+		p += escritos;
+		tam -= escritos;
+	}
+}
+
+
+static void escribeTramo (struct indiceClaves *indice)
+{
+	struct tramoClaves tramo;
+	struct entradaClave *entradas;
+	struct registroLevantamiento lectura[REGISTROS_POR_BLOQUE];
+	int64_t i;
+	int n;
+	int j;
+
+	if (numRegistros<=indice->cubiertos) return;
+
+	// Se leen del fichero de datos los registros que no tiene ningún tramo (los de esta vez y los de una ejecución que se cortara).
+	tramo.primer_registro = indice->cubiertos;
+	tramo.num_entradas = numRegistros-indice->cubiertos;
+	entradas = (struct entradaClave*)malloc(sizeof(struct entradaClave)*tramo.num_entradas);
+	for (i=0; i<tramo.num_entradas; i+=n)
+	{
+		n = (tramo.num_entradas-i<REGISTROS_POR_BLOQUE) ? (int)(tramo.num_entradas-i) : REGISTROS_POR_BLOQUE;
+		if (pread(ficheroDatos, lectura, sizeof(struct registroLevantamiento)*n, POSICION_REGISTRO(indice->cubiertos+i))!=(ssize_t)(sizeof(struct registroLevantamiento)*n))
+		{
+			perror("Error en la lectura del almacén de resultados.\n");
+			exit(-1);
+		}
+		for (j=0; j<n; j++)
+		{
+			entradas[i+j].clave = (indice->clave==CLAVE_DORSAL) ? lectura[j].dorsal : lectura[j].tarima;
+			entradas[i+j].campeonato = lectura[j].campeonato;
+			entradas[i+j].ejecucion = lectura[j].ejecucion;
+			entradas[i+j].registro = indice->cubiertos+i+j;
+		}
+	}
+	qsort(entradas, tramo.num_entradas, sizeof(struct entradaClave), comparaEntradas);
+
+	tramo.ejecucion_min = entradas[0].ejecucion;
+	tramo.ejecucion_max = entradas[0].ejecucion;
+	for (i=1; i<tramo.num_entradas; i++)
+	{
+		if (entradas[i].ejecucion<tramo.ejecucion_min) tramo.ejecucion_min = entradas[i].ejecucion;
+		if (entradas[i].ejecucion>tramo.ejecucion_max) tramo.ejecucion_max = entradas[i].ejecucion;
+	}
+
+	escribeTodo(indice->fichero, &tramo, sizeof(struct tramoClaves));
+	escribeTodo(indice->fichero, entradas, sizeof(struct entradaClave)*tramo.num_entradas);
+	indice->cubiertos = numRegistros;
+	free(entradas);
+}
+
+
+static void compruebaTramos (struct indiceClaves *indice)
+{
+	struct stat info;
+	struct tramoClaves tramo;
+	int64_t desplazamiento = 0;
+
+	// Se quedan los tramos completos que siguen a los anteriores y no pasan de los datos; los registros que queden fuera
+	// entran en el tramo que se escribe al cerrar.
+	fstat(indice->fichero, &info);
+	indice->cubiertos = 0;
+	while (desplazamiento+(int64_t)sizeof(struct tramoClaves)<=info.st_size)
+	{
+		pread(indice->fichero, &tramo, sizeof(struct tramoClaves), desplazamiento);
+		if (tramo.primer_registro!=indice->cubiertos || tramo.num_entradas<=0 || indice->cubiertos+tramo.num_entradas>numRegistros) break;
+		if (desplazamiento+(int64_t)sizeof(struct tramoClaves)+tramo.num_entradas*(int64_t)sizeof(struct entradaClave)>info.st_size) break;
+
+		desplazamiento += sizeof(struct tramoClaves) + tramo.num_entradas*sizeof(struct entradaClave);
+		indice->cubiertos += tramo.num_entradas;
+	}
+	if (desplazamiento!=info.st_size)
+	{
+		ftruncate(indice->fichero, desplazamiento);
+	}
+}
+
+
+void abreResultados (char *nombreDatos, char *nombreIndice, char *nombreDorsales, char *nombreTarimas)
+{
+	struct stat info;
+	struct cabeceraResultados cabecera;
+	struct bloqueIndice ultimo;
+	struct registroLevantamiento levantamiento;
+	int64_t numBloques;
+	int64_t cubiertos;
+	int64_t i;
+
+	// Los ficheros sólo crecen: los campeonatos sucesivos se añaden al final.
+	ficheroDatos = open(nombreDatos, O_RDWR|O_CREAT|O_APPEND, 0644);
+	ficheroIndice = open(nombreIndice, O_RDWR|O_CREAT|O_APPEND, 0644);
+	dorsales.fichero = open(nombreDorsales, O_RDWR|O_CREAT|O_APPEND, 0644);
+	tarimas.fichero = open(nombreTarimas, O_RDWR|O_CREAT|O_APPEND, 0644);
+	if (ficheroDatos<0 || ficheroIndice<0 || dorsales.fichero<0 || tarimas.fichero<0)
+	{
+		perror("Error en la apertura del almacén de resultados.\n");
+		exit(-1);
+	}
+
+
+	// Un almacén nuevo (o cortado antes de tener la cabecera entera) empieza por la cabecera y sin índices; uno escrito con
+	// otro formato no se toca.
+	fstat(ficheroDatos, &info);
+	if (info.st_size<(off_t)sizeof(struct cabeceraResultados))
+	{
+		ftruncate(ficheroDatos, 0);
+		ftruncate(ficheroIndice, 0);
+		ftruncate(dorsales.fichero, 0);
+		ftruncate(tarimas.fichero, 0);
+		preparaCabecera(&cabecera);
+		escribeTodo(ficheroDatos, &cabecera, sizeof(struct cabeceraResultados));
+		info.st_size = sizeof(struct cabeceraResultados);
+	}
+	else if (!compruebaCabecera(ficheroDatos))
+	{
+		fprintf(stderr, "%s no es un almacén de resultados de esta versión: hay que moverlo o borrarlo.\n", nombreDatos);
+		exit(-1);
+	}
+
+	// Si un campeonato anterior se cortó a medias se descarta el último registro incompleto.
+	numRegistros = (info.st_size-sizeof(struct cabeceraResultados))/sizeof(struct registroLevantamiento);
+	if (POSICION_REGISTRO(numRegistros)!=info.st_size)
+	{
+		ftruncate(ficheroDatos, POSICION_REGISTRO(numRegistros));
+	}
+
+	fstat(ficheroIndice, &info);
+	numBloques = info.st_size/sizeof(struct bloqueIndice);
+	cubiertos = 0;
+
+	// Se descartan las entradas del índice que apunten más allá de los datos.
+	while (numBloques>0)
+	{
+		pread(ficheroIndice, &ultimo, sizeof(struct bloqueIndice), (numBloques-1)*sizeof(struct bloqueIndice));
+		cubiertos = ultimo.primer_registro + ultimo.num_registros;
+		if (cubiertos<=numRegistros) break;
+		numBloques--;
+		cubiertos = 0;
+	}
+	if (numBloques*(int64_t)sizeof(struct bloqueIndice)!=info.st_size)
+	{
+		ftruncate(ficheroIndice, numBloques*sizeof(struct bloqueIndice));
+	}
+
+
+	// Los registros que quedaron fuera del índice forman el bloque actual.
+	iniciaBloque(&bloqueActual, cubiertos);
+	for (i=cubiertos; i<numRegistros; i++)
+	{
+		pread(ficheroDatos, &levantamiento, sizeof(struct registroLevantamiento), POSICION_REGISTRO(i));
+		anadeABloque(&bloqueActual, &levantamiento);
+
+		if (bloqueActual.num_registros==REGISTROS_POR_BLOQUE)
+		{
+			escribeTodo(ficheroIndice, &bloqueActual, sizeof(struct bloqueIndice));
+			iniciaBloque(&bloqueActual, i+1);
+		}
+	}
+
+
+	// Los índices por dorsal y por tarima se quedan con sus tramos buenos.
+	compruebaTramos(&dorsales);
+	compruebaTramos(&tarimas);
+}
+
+
+void guardaLevantamiento (struct registroLevantamiento *levantamiento)
+{
+	guardaLevantamientos(levantamiento, 1);
+}
+
+
+void guardaLevantamientos (struct registroLevantamiento *levantamientos, int cuantos)
+{
+	int estadoCancelacion;
+	int i;
+
+	if (ficheroDatos<0) return; // El almacén no está abierto.
+
+	// Un hilo cancelado a mitad de escritura dejaría el semáforo bloqueado y el registro a medias.
+	pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &estadoCancelacion);
+
+	if (pthread_mutex_lock(&semaforo_resultados)!=0)
+	{
+		perror("Error en el bloqueo del semáforo de los resultados.\n");
+		exit(-1);
+	}
+
+		// Toda la tanda va al fichero de datos de una vez; el índice se completa registro a registro.
+		escribeTodo(ficheroDatos, levantamientos, sizeof(struct registroLevantamiento)*cuantos);
+		for (i=0; i<cuantos; i++)
+		{
+			numRegistros++;
+			anadeABloque(&bloqueActual, &levantamientos[i]);
+
+			// Cuando el bloque está completo se añade su resumen al índice.
+			if (bloqueActual.num_registros==REGISTROS_POR_BLOQUE)
+			{
+				escribeTodo(ficheroIndice, &bloqueActual, sizeof(struct bloqueIndice));
+				iniciaBloque(&bloqueActual, numRegistros);
+			}
+		}
+
+	if (pthread_mutex_unlock(&semaforo_resultados)!=0)
+	{
+		perror("Error en el desbloqueo del semáforo de los resultados.\n");
+		exit(-1);
+	}
+
+	pthread_setcancelstate(estadoCancelacion, NULL);
+}
+
+
+int ficheroResultados()
+{
+	return ficheroDatos;
+}
+
+
+void cierraResultados()
+{
+	if (ficheroDatos<0) return;
+
+	if (pthread_mutex_lock(&semaforo_resultados)!=0)
+	{
+		perror("Error en el bloqueo del semáforo de los resultados.\n");
+		exit(-1);
+	}
+
+		// El último bloque se guarda aunque esté incompleto para que las consultas no tengan que leer nada fuera del índice.
+		if (bloqueActual.num_registros>0)
+		{
+			escribeTodo(ficheroIndice, &bloqueActual, sizeof(struct bloqueIndice));
+			iniciaBloque(&bloqueActual, numRegistros);
+		}
+
+		// Y los levantamientos guardados desde la última vez se añaden ordenados a los índices por dorsal y por tarima.
+		escribeTramo(&dorsales);
+		escribeTramo(&tarimas);
+
+		close(ficheroDatos);
+		close(ficheroIndice);
+		close(dorsales.fichero);
+		close(tarimas.fichero);
+		ficheroDatos = -1;
+		ficheroIndice = -1;
+		dorsales.fichero = -1;
+		tarimas.fichero = -1;
+
+	if (pthread_mutex_unlock(&semaforo_resultados)!=0)
+	{
+		perror("Error en el desbloqueo del semáforo de los resultados.\n");
+		exit(-1);
+	}
+}
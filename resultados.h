@@ -0,0 +1,130 @@
+#ifndef RESULTADOS_H
+#define RESULTADOS_H
+
+#include <stdint.h>
+
+
+// Definición de constantes.
+#define FICHERO_RESULTADOS "resultados.dat"
+#define FICHERO_INDICE "resultados.idx"
+#define FICHERO_DORSALES "resultados.dor"
+#define FICHERO_TARIMAS "resultados.tar"
+#define MAGIA_RESULTADOS "PLRESUL1"
+#define VERSION_RESULTADOS 1
+
+#define REGISTROS_POR_BLOQUE 256 // Número máximo de levantamientos que resume cada entrada del índice.
+
+// Claves de los índices por dorsal y por tarima.
+#define CLAVE_DORSAL 0
+#define CLAVE_TARIMA 1
+
+// Resultado de un levantamiento.
+#define RESULTADO_VALIDO 0
+#define RESULTADO_NULO_INDUMENTARIA 1
+#define RESULTADO_NULO_FUERZA 2
+
+
+
+/* Estructuras de los ficheros (todos los campos son de ancho fijo). */
+
+
+// Cabecera de resultados.dat (32 bytes), con los registros detrás. Si no coincide con la de esta versión el almacén no se lee.
+struct cabeceraResultados
+{
+	char magia[8];
+	int32_t version;
+	int32_t tamRegistro; // Tamaños de las estructuras del almacén y sus índices al escribirlo.
+	int32_t tamBloque;
+	int32_t tamEntrada;
+	int64_t reservado;
+};
+
+
+// Registro de un levantamiento puntuado (56 bytes). Los tiempos son nanosegundos desde la época.
+struct registroLevantamiento
+{
+	int32_t dorsal;
+	int32_t tarima;
+	int32_t resultado;
+	int32_t puntuacion;
+	int64_t t_inscripcion; // Hora a la que el atleta se inscribió.
+	int64_t t_llamada; // Hora a la que el juez lo llamó a la tarima.
+	int64_t t_fin; // Hora a la que terminó el levantamiento.
+	int32_t necesita_beber;
+	int32_t campeonato; // Número del campeonato (1 salvo en el modo anfitrión).
+	int64_t ejecucion; // Hora a la que arrancó el programa: con el número identifica el campeonato (los dorsales empiezan de nuevo en cada uno).
+};
+
+
+// Entrada del índice (64 bytes): resume un bloque de registros consecutivos del fichero de datos.
+struct bloqueIndice
+{
+	int64_t primer_registro; // Posición (en registros) del primer levantamiento del bloque.
+	int32_t num_registros;
+	int32_t puntuacion_max;
+	int32_t dorsal_min;
+	int32_t dorsal_max;
+	uint64_t mascara_tarimas; // Bit (tarima-1) activo si alguna tarima del bloque coincide; la 64 agrupa las demás.
+	int64_t t_min; // Menor y mayor t_fin del bloque.
+	int64_t t_max;
+	int64_t ejecucion_min; // Menor y mayor ejecución del bloque.
+	int64_t ejecucion_max;
+};
+
+
+// Índices por dorsal (resultados.dor) y por tarima (resultados.tar): cada vez que se cierra el almacén se añade a cada uno
+// un tramo con los levantamientos guardados desde el anterior, ordenados por la clave, la ejecución y el campeonato.
+// Cabecera de cada tramo (32 bytes), seguida de sus entradas.
+struct tramoClaves
+{
+	int64_t primer_registro; // Los tramos cubren los registros seguidos, desde el primero del fichero de datos.
+	int64_t num_entradas;
+	int64_t ejecucion_min;
+	int64_t ejecucion_max;
+};
+
+// Entrada de un índice por dorsal o por tarima (24 bytes).
+struct entradaClave
+{
+	int32_t clave; // Dorsal o tarima del levantamiento.
+	int32_t campeonato;
+	int64_t ejecucion;
+	int64_t registro; // Posición (en registros) del levantamiento en el fichero de datos.
+};
+
+// Desplazamiento en resultados.dat del registro que ocupa esa posición.
+#define POSICION_REGISTRO(i) ((int64_t)sizeof(struct cabeceraResultados) + (int64_t)(i)*(int64_t)sizeof(struct registroLevantamiento))
+
+
+
+/* Estructuras en memoria. */
+
+
+// Índice por dorsal o por tarima abierto para añadirle tramos.
+struct indiceClaves
+{
+	int fichero;
+	int64_t cubiertos; // Registros que ya están en algún tramo.
+	int clave; // CLAVE_DORSAL o CLAVE_TARIMA.
+};
+
+
+
+/* Declaración de las funciones. */
+
+
+int64_t marcaTiempo(); // Hora actual en nanosegundos desde la época.
+
+void abreResultados(char *nombreDatos, char *nombreIndice, char *nombreDorsales, char *nombreTarimas);
+void guardaLevantamiento(struct registroLevantamiento *levantamiento);
+void guardaLevantamientos(struct registroLevantamiento *levantamientos, int cuantos); // Una tanda con una sola escritura.
+int ficheroResultados(); // Descriptor del fichero de datos (-1 si no está abierto).
+int compruebaCabecera(int fichero); // 1 si el fichero de datos empieza por la cabecera de esta versión.
+void cierraResultados();
+
+void iniciaBloque(struct bloqueIndice *bloque, int64_t primero);
+void anadeABloque(struct bloqueIndice *bloque, struct registroLevantamiento *levantamiento);
+uint64_t bitTarima(int tarima);
+int comparaEntradas(const void *a, const void *b); // Orden de los índices por dorsal y por tarima (para qsort).
+
+#endif
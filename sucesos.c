@@ -0,0 +1,266 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+
+#include "sucesos.h"
+
+
+
+/* Declaración de las variables globales del bus de sucesos. */
+
+
+static __thread struct bus *busRepartiendo; // Bus cuyo testigo tiene este hilo mientras reparte (NULL si ninguno).
+
+
+
+/* Implementación de las funciones. */
+
+
+static void pasoBus(struct tarea *tarea);
+
+
+void iniciaBus (struct bus *bus)
+{
+	int i;
+
+	bus->huecos = (struct huecoBus*)malloc(sizeof(struct huecoBus)*TAMBUS);
+	if (bus->huecos==NULL)
+	{
+		perror("Error en la reserva de la cola de sucesos.\n");
+		exit(-1);
+	}
+	for (i=0; i<TAMBUS; i++)
+	{
+		bus->huecos[i].secuencia = i; // Libre para el productor de la primera vuelta.
+	}
+
+	bus->escritura = 0;
+	bus->lectura = 0;
+	bus->testigo = 0;
+	bus->avisado = 0;
+	bus->marcaHora = 0;
+	bus->numSuscriptores = 0;
+	bus->abreTanda = NULL;
+	bus->cierraTanda = NULL;
+	bus->datosTanda = NULL;
+	bus->publicados = 0;
+	bus->tandas = 0;
+	bus->mayorTanda = 0;
+	bus->llenos = 0;
+	iniciaTarea(&bus->tarea, pasoBus, bus);
+}
+
+
+void liberaBus (struct bus *bus)
+{
+	free(bus->huecos);
+	bus->huecos = NULL;
+}
+
+
+void suscribe (struct bus *bus, int tipos, void (*funcion)(void *datos, struct suceso *suceso), void *datos)
+{
+	if (bus->numSuscriptores==MAXSUSCRIPTORES)
+	{
+		fprintf(stderr, "Demasiados suscriptores en el bus de sucesos.\n");
+		exit(-1);
+	}
+
+	bus->suscriptores[bus->numSuscriptores].tipos = tipos;
+	bus->suscriptores[bus->numSuscriptores].funcion = funcion;
+	bus->suscriptores[bus->numSuscriptores].datos = datos;
+	bus->numSuscriptores++;
+}
+
+
+void defineTandas (struct bus *bus, void (*abreTanda)(void *datos), void (*cierraTanda)(void *datos), void *datos)
+{
+	bus->abreTanda = abreTanda;
+	bus->cierraTanda = cierraTanda;
+	bus->datosTanda = datos;
+}
+
+
+static void reparte (struct bus *bus, struct suceso *suceso)
+{
+	int i;
+
+	// Cada suscriptor lo recibe en el orden en que se suscribió.
+	for (i=0; i<bus->numSuscriptores; i++)
+	{
+		if ((bus->suscriptores[i].tipos & (1<<suceso->tipo))!=0)
+		{
+			bus->suscriptores[i].funcion(bus->suscriptores[i].datos, suceso);
+		}
+	}
+}
+
+
+static int tomaTestigo (struct bus *bus)
+{
+	return __sync_lock_test_and_set(&bus->testigo, 1)==0;
+}
+
+
+static void sueltaTestigo (struct bus *bus)
+{
+	__sync_lock_release(&bus->testigo);
+}
+
+
+static int listo (struct bus *bus)
+{
+	uint64_t posicion = bus->lectura;
+
+	return __atomic_load_n(&bus->huecos[posicion & (TAMBUS-1)].secuencia, __ATOMIC_SEQ_CST)==posicion+1;
+}
+
+
+static int consume (struct bus *bus)
+{
+	struct bus *anterior = busRepartiendo; // El que reparte otra etapa puede estar vaciando ésta porque se ha llenado.
+	struct huecoBus *hueco;
+	struct suceso suceso;
+	uint64_t posicion;
+	int repartidos = 0;
+	int enTanda;
+
+	// Se lee hasta el primer hueco que no esté listo (puede que su productor aún lo esté escribiendo: ya avisará).
+	busRepartiendo = bus;
+	while (listo(bus))
+	{
+		if (bus->abreTanda!=NULL) bus->abreTanda(bus->datosTanda);
+
+		for (enTanda=0; enTanda<TAMTANDA && listo(bus); enTanda++)
+		{
+			posicion = bus->lectura;
+			hueco = &bus->huecos[posicion & (TAMBUS-1)];
+			suceso = hueco->suceso;
+			__atomic_store_n(&hueco->secuencia, posicion+TAMBUS, __ATOMIC_RELEASE); // Libre para la vuelta siguiente.
+			bus->lectura = posicion+1;
+
+			reparte(bus, &suceso);
+		}
+
+		if (bus->cierraTanda!=NULL) bus->cierraTanda(bus->datosTanda);
+		repartidos += enTanda;
+		bus->tandas++;
+		if (enTanda>bus->mayorTanda) bus->mayorTanda = enTanda;
+	}
+	busRepartiendo = anterior;
+
+	bus->publicados += repartidos;
+	return repartidos;
+} // Se llama con el testigo.
+
+
+void publicaSuceso (struct bus *bus, struct suceso *suceso)
+{
+	struct huecoBus *hueco;
+	struct suceso marcado;
+	uint64_t posicion;
+	int64_t diferencia;
+	int lleno = 0;
+
+	if (bus->marcaHora==1 && suceso->publicado==0)
+	{
+		marcado = *suceso;
+		marcado.publicado = relojMonotonico();
+		suceso = &marcado;
+	}
+
+	// Un suscriptor que publica mientras reparte: se entrega ya, justo después del suceso que lo ha provocado.
+	if (busRepartiendo==bus)
+	{
+		reparte(bus, suceso);
+		bus->publicados++;
+		return;
+	}
+
+
+	// Se reserva el siguiente hueco libre avanzando la escritura con una comparación e intercambio.
+	posicion = __atomic_load_n(&bus->escritura, __ATOMIC_RELAXED);
+	for (;;)
+	{
+		hueco = &bus->huecos[posicion & (TAMBUS-1)];
+		diferencia = (int64_t)(__atomic_load_n(&hueco->secuencia, __ATOMIC_ACQUIRE)-posicion);
+
+		if (diferencia==0)
+		{
+			if (__atomic_compare_exchange_n(&bus->escritura, &posicion, posicion+1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;
+		}
+		else if (diferencia<0)
+		{
+			// Llena: si nadie está consumiendo se vacía aquí mismo, y si no se deja sitio al que lo hace.
+			if (lleno==0)
+			{
+				__sync_fetch_and_add(&bus->llenos, 1);
+				lleno = 1;
+			}
+			if (tomaTestigo(bus))
+			{
+				consume(bus);
+				sueltaTestigo(bus);
+			}
+			else
+			{
+				sched_yield();
+			}
+			posicion = __atomic_load_n(&bus->escritura, __ATOMIC_RELAXED);
+		}
+		else
+		{
+			posicion = __atomic_load_n(&bus->escritura, __ATOMIC_RELAXED); // Otro productor se ha adelantado.
+		}
+	}
+
+	hueco->suceso = *suceso;
+	__atomic_store_n(&hueco->secuencia, posicion+1, __ATOMIC_SEQ_CST);
+
+	// Se programa la tarea del bus si no lo está ya (la tarea quita el aviso antes de leer, así no se pierde ninguno).
+	if (__atomic_load_n(&bus->avisado, __ATOMIC_SEQ_CST)==0 && __sync_bool_compare_and_swap(&bus->avisado, 0, 1))
+	{
+		programaTarea(&bus->tarea, 0);
+	}
+}
+
+
+void reenviaSuceso (void *datos, struct suceso *suceso)
+{
+	publicaSuceso((struct bus*)datos, suceso);
+} // Si la etapa siguiente está llena, el que reparte ésta la vacía (las etapas no publican hacia atrás).
+
+
+static void pasoBus (struct tarea *tarea)
+{
+	struct bus *bus = (struct bus*)tarea->datos;
+
+	__atomic_store_n(&bus->avisado, 0, __ATOMIC_SEQ_CST);
+
+	if (!tomaTestigo(bus))
+	{
+		// Está vaciando un productor con la cola llena: se vuelve a mirar enseguida por si deja algo sin leer.
+		__atomic_store_n(&bus->avisado, 1, __ATOMIC_SEQ_CST);
+		programaTarea(tarea, 100000);
+		return;
+	}
+
+	consume(bus);
+	sueltaTestigo(bus);
+}
+
+
+int vaciaBus (struct bus *bus)
+{
+	int repartidos;
+
+	if (busRepartiendo==bus) return 0; // Desde un suscriptor no se puede.
+
+	while (!tomaTestigo(bus))
+	{
+		sched_yield();
+	}
+	repartidos = consume(bus);
+	sueltaTestigo(bus);
+	return repartidos;
+}
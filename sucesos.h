@@ -0,0 +1,114 @@
+#ifndef SUCESOS_H
+#define SUCESOS_H
+
+#include <stdint.h>
+
+#include "planificador.h"
+
+
+/*
+ * Bus de sucesos del campeonato. Lo que pasa (un atleta se inscribe, lo llaman, lo puntúan, se deshidrata...) se publica
+ * una sola vez en una cola circular sin semáforos con muchos productores y un solo consumidor. Una tarea del planificador
+ * la vacía por tandas y pasa cada suceso, en el orden de la cola, a los suscriptores de su tipo (log, podio, métricas y
+ * fuente). Así el que publica no toca los datos de los demás y se pueden añadir suscriptores sin cambiarlo.
+ *
+ * Sólo consume quien tiene el testigo: la tarea del bus, un productor que se encuentra la cola llena o quien la vacía al
+ * final. Lo que publica un suscriptor mientras se reparte un suceso se entrega enseguida, sin pasar por la cola.
+ *
+ * Un bus también sirve de etapa: con reenviaSuceso un suscriptor pasa los sucesos a otro bus, que los reparte en su propia
+ * tarea por tandas de hasta TAMTANDA (abreTanda y cierraTanda se llaman al principio y al final de cada una).
+ */
+
+
+// Definición de constantes.
+#define TAMBUS 4096 // Huecos de la cola (potencia de 2).
+#define MAXSUSCRIPTORES 8
+#define TAMTANDA 256 // Sucesos que reparte como mucho cada tanda.
+
+// Tipos de suceso.
+#define SUCESO_INSCRITO 0 // dorsal, tarima asignada.
+#define SUCESO_LLAMADO 1 // dorsal, tarima del juez, inscripcion; hora: cuando lo llama.
+#define SUCESO_CALENTADO 2 // dorsal.
+#define SUCESO_PUNTUADO 3 // dorsal, tarima del juez, resultado, valor: puntuación, agua, inscripcion, llamada; hora: fin del levantamiento.
+#define SUCESO_NECESITA_AGUA 4 // dorsal, tarima del juez.
+#define SUCESO_FINALIZADO 5 // dorsal; valor: 1 si va a la fuente.
+#define SUCESO_BEBIDO 6 // dorsal del que bebe; valor: dorsal del que aprieta el botón.
+#define SUCESO_DESHIDRATADO 7 // dorsal.
+#define NUMSUCESOS 8
+
+#define TODOS_SUCESOS ((1<<NUMSUCESOS)-1)
+
+
+
+/* Estructuras. */
+
+
+struct suceso
+{
+	int tipo;
+	int dorsal;
+	int tarima;
+	int resultado;
+	int valor;
+	int agua; // 1 si el juez lo manda a beber.
+	int64_t hora; // Horas en nanosegundos desde la época (0 si el tipo no las usa).
+	int64_t inscripcion;
+	int64_t llamada;
+	int64_t publicado; // Reloj monotónico al publicarlo en un bus con marcaHora (se conserva al pasar de etapa).
+};
+
+
+// Hueco de la cola: la secuencia dice si está libre para el productor de la vuelta actual o listo para el consumidor.
+struct huecoBus
+{
+	uint64_t secuencia;
+	struct suceso suceso;
+};
+
+
+struct suscriptor
+{
+	int tipos; // Máscara con un bit (1<<SUCESO_*) por cada tipo que recibe.
+	void (*funcion)(void *datos, struct suceso *suceso);
+	void *datos;
+};
+
+
+struct bus
+{
+	struct huecoBus *huecos;
+	uint64_t escritura; // Siguiente hueco que reserva un productor.
+	char separacion[64]; // Los productores y el consumidor no comparten línea de caché.
+	uint64_t lectura; // Siguiente hueco que lee el consumidor.
+	int testigo; // 1 mientras alguien consume.
+	int avisado; // 1 si la tarea del bus ya está programada.
+	int marcaHora; // 1 para apuntar en cada suceso cuándo se publica (lo usa la durabilidad).
+
+	struct suscriptor suscriptores[MAXSUSCRIPTORES];
+	int numSuscriptores;
+	void (*abreTanda)(void *datos); // Pueden ser NULL.
+	void (*cierraTanda)(void *datos);
+	void *datosTanda;
+	struct tarea tarea;
+
+	// Estadísticas (sólo las toca el que tiene el testigo, salvo llenos).
+	long publicados;
+	long tandas;
+	int mayorTanda;
+	long llenos; // Veces que un productor se ha encontrado la cola llena.
+};
+
+
+
+/* Declaración de las funciones. */
+
+
+void iniciaBus(struct bus *bus);
+void liberaBus(struct bus *bus);
+void suscribe(struct bus *bus, int tipos, void (*funcion)(void *datos, struct suceso *suceso), void *datos); // Antes de publicar nada.
+void defineTandas(struct bus *bus, void (*abreTanda)(void *datos), void (*cierraTanda)(void *datos), void *datos);
+void publicaSuceso(struct bus *bus, struct suceso *suceso);
+void reenviaSuceso(void *datos, struct suceso *suceso); // Suscriptor que lo publica en otro bus (los datos son ese bus).
+int vaciaBus(struct bus *bus); // Reparte todo lo publicado hasta ahora (espera al testigo); devuelve cuántos ha repartido.
+
+#endif